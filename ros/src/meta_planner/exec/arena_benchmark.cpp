@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Microbenchmark of Arena::Allocate against the same bump allocator behind a
+// single mutex, as the Arena used to be. Several threads allocate small
+// waypoint-sized objects from one shared arena at once, as the planner's
+// helper threads do when growing a tree, and the mean time per allocation is
+// reported for a few thread counts.
+//
+// Usage: arena_benchmark [num_allocations_per_thread]
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/arena.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Bump allocator with every allocation behind one mutex.
+class LockedArena {
+public:
+  explicit LockedArena(size_t block_size)
+    : block_size_(block_size), head_(nullptr), end_(nullptr) {}
+
+  ~LockedArena() {
+    for (char* block : blocks_)
+      delete[] block;
+  }
+
+  void* Allocate(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    char* start = Aligned(head_, alignment);
+    if (head_ == nullptr || start + size > end_) {
+      char* block = new char[block_size_];
+      blocks_.push_back(block);
+      start = Aligned(block, alignment);
+      end_ = block + block_size_;
+    }
+
+    head_ = start + size;
+    return start;
+  }
+
+private:
+  static char* Aligned(char* ptr, size_t alignment) {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+    return reinterpret_cast<char*>(
+      (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+  }
+
+  const size_t block_size_;
+  std::vector<char*> blocks_;
+  char* head_;
+  char* end_;
+  std::mutex mutex_;
+};
+
+// Mean nanoseconds per allocation with num_threads threads each making
+// num_allocations allocations from the given arena at once.
+template<typename ArenaType>
+double Benchmark(ArenaType& arena, size_t num_threads,
+                 size_t num_allocations, uintptr_t& checksum) {
+  std::vector<uintptr_t> sums(num_threads, 0);
+  std::vector<std::thread> threads;
+
+  const Clock::time_point start = Clock::now();
+  for (size_t ii = 0; ii < num_threads; ii++) {
+    threads.emplace_back([&arena, &sums, num_allocations, ii]() {
+      for (size_t jj = 0; jj < num_allocations; jj++) {
+        const size_t size = 48 + 8 * (jj % 8);
+        sums[ii] += reinterpret_cast<uintptr_t>(arena.Allocate(size, 8));
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+
+  const double elapsed = std::chrono::duration<double, std::nano>(
+    Clock::now() - start).count();
+
+  for (uintptr_t sum : sums)
+    checksum += sum;
+
+  return elapsed / static_cast<double>(num_threads * num_allocations);
+}
+
+} //\namespace
+
+int main(int argc, char** argv) {
+  const size_t num_allocations = (argc > 1) ?
+    static_cast<size_t>(std::max(std::atoi(argv[1]), 1)) : 1000000;
+
+  const std::vector<size_t> thread_counts = { 1, 2, 4, 8 };
+
+  // Keep results alive so that the allocations are not optimized away.
+  uintptr_t checksum = 0;
+
+  std::printf("%8s %14s %14s\n", "threads", "Arena (ns)", "locked (ns)");
+  for (size_t num_threads : thread_counts) {
+    const meta::Arena::Ptr arena = meta::Arena::Create();
+    const double lock_free =
+      Benchmark(*arena, num_threads, num_allocations, checksum);
+
+    LockedArena locked(meta::Arena::kDefaultBlockSize);
+    const double serialized =
+      Benchmark(locked, num_threads, num_allocations, checksum);
+
+    std::printf("%8zu %14.2f %14.2f\n", num_threads, lock_free, serialized);
+  }
+
+  std::printf("(checksum %zu)\n", static_cast<size_t>(checksum));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Microbenchmark of the KdTree against a FLANN kdtree used the way the old
+// FlannTree wrapper did: one heap-allocated point per insert, a rebuild each
+// time the index doubles, and result vectors allocated per query. Inserts
+// points one at a time, as the meta planner does, and times insertion and
+// k-nearest-neighbor queries at a few tree sizes. The KdTree searches under
+// (unweighted) L-infinity and FLANN under L2, so the neighbors may differ,
+// but the work is comparable.
+//
+// Usage: kd_tree_benchmark [num_queries]
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/kd_tree.h>
+#include <utils/types.h>
+
+#include <flann/flann.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Microseconds elapsed since the given time.
+double MicrosecondsSince(const Clock::time_point& start) {
+  return std::chrono::duration<double, std::micro>(
+    Clock::now() - start).count();
+}
+
+// Time to insert all points, and mean time per query, for each k, in
+// microseconds.
+struct Timing {
+  double insert_;
+  std::vector<double> query_;
+};
+
+Timing BenchmarkKdTree(const std::vector<meta::Vector3d>& points,
+                       const std::vector<meta::Vector3d>& queries,
+                       const std::vector<size_t>& ks, double& checksum) {
+  Timing timing;
+  meta::KdTree<size_t> kdtree;
+
+  const Clock::time_point insert_start = Clock::now();
+  for (size_t ii = 0; ii < points.size(); ii++)
+    kdtree.Insert(points[ii], ii);
+  timing.insert_ = MicrosecondsSince(insert_start);
+
+  std::vector<size_t> values(ks.back());
+  std::vector<double> distances(ks.back());
+  for (size_t k : ks) {
+    const Clock::time_point query_start = Clock::now();
+    for (const auto& query : queries) {
+      const size_t num_found =
+        kdtree.KnnSearch(query, k, values.data(), distances.data());
+      checksum += static_cast<double>(values[num_found - 1]);
+    }
+
+    timing.query_.push_back(MicrosecondsSince(query_start) /
+                            static_cast<double>(queries.size()));
+  }
+
+  return timing;
+}
+
+Timing BenchmarkFlann(const std::vector<meta::Vector3d>& points,
+                      const std::vector<meta::Vector3d>& queries,
+                      const std::vector<size_t>& ks, double& checksum) {
+  Timing timing;
+  std::unique_ptr< flann::KDTreeIndex< flann::L2<double> > > index;
+
+  const Clock::time_point insert_start = Clock::now();
+  for (const auto& point : points) {
+    flann::Matrix<double> flann_point(new double[3], 1, 3);
+    for (size_t ii = 0; ii < 3; ii++)
+      flann_point[0][ii] = point(ii);
+
+    if (index == nullptr) {
+      index.reset(new flann::KDTreeIndex< flann::L2<double> >(
+        flann_point, flann::KDTreeIndexParams(1)));
+      index->buildIndex();
+    } else {
+      index->addPoints(flann_point, 2.0);
+    }
+  }
+  timing.insert_ = MicrosecondsSince(insert_start);
+
+  for (size_t k : ks) {
+    const Clock::time_point query_start = Clock::now();
+    for (const auto& query : queries) {
+      meta::Vector3d copy = query;
+      const flann::Matrix<double> flann_query(copy.data(), 1, 3);
+
+      std::vector< std::vector<int> > indices;
+      std::vector< std::vector<double> > squared_distances;
+      const int num_found =
+        index->knnSearch(flann_query, indices, squared_distances,
+                         static_cast<int>(k),
+                         flann::SearchParams(-1, 0.0, false));
+      checksum += static_cast<double>(indices[0][num_found - 1]);
+    }
+
+    timing.query_.push_back(MicrosecondsSince(query_start) /
+                            static_cast<double>(queries.size()));
+  }
+
+  // Free memory from points in the index.
+  for (size_t ii = 0; ii < index->size(); ii++)
+    delete[] index->getPoint(ii);
+
+  return timing;
+}
+
+} //\namespace
+
+int main(int argc, char** argv) {
+  const size_t num_queries = (argc > 1) ?
+    static_cast<size_t>(std::max(std::atoi(argv[1]), 1)) : 10000;
+
+  const std::vector<size_t> sizes = { 500, 2000, 8000 };
+  const std::vector<size_t> ks = { 1, 10 };
+
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif(0.0, 10.0);
+
+  std::vector<meta::Vector3d> queries;
+  for (size_t ii = 0; ii < num_queries; ii++)
+    queries.push_back(meta::Vector3d(unif(rng), unif(rng), unif(rng)));
+
+  // Keep results alive so that the searches are not optimized away.
+  double checksum = 0.0;
+
+  std::printf("%8s %8s %14s %12s %12s\n",
+              "points", "tree", "insert (us)", "1-nn (us)", "10-nn (us)");
+  for (size_t size : sizes) {
+    std::vector<meta::Vector3d> points;
+    for (size_t ii = 0; ii < size; ii++)
+      points.push_back(meta::Vector3d(unif(rng), unif(rng), unif(rng)));
+
+    const Timing kdtree = BenchmarkKdTree(points, queries, ks, checksum);
+    const Timing flann = BenchmarkFlann(points, queries, ks, checksum);
+
+    std::printf("%8zu %8s %14.1f %12.3f %12.3f\n", size, "KdTree",
+                kdtree.insert_, kdtree.query_[0], kdtree.query_[1]);
+    std::printf("%8zu %8s %14.1f %12.3f %12.3f\n", size, "FLANN",
+                flann.insert_, flann.query_[0], flann.query_[1]);
+  }
+
+  std::printf("(checksum %g)\n", checksum);
+  return EXIT_SUCCESS;
+}
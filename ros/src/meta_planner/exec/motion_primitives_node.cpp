@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Offline generator for the LatticePlanner's motion primitive libraries.
+// Asks the value function server for each planner's maximum speeds, builds
+// a library for each, and saves it to <directory>motion_primitives_<id>.bin,
+// where <id> is the planner's incoming value function. Run it once with the
+// same parameters as the MetaPlanner, while the server is up.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/motion_primitives.h>
+#include <utils/types.h>
+
+#include <value_function_srvs/GeometricPlannerSpeed.h>
+
+#include <ros/ros.h>
+#include <string>
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "motion_primitives");
+  ros::NodeHandle n("~");
+  const std::string name = ros::this_node::getName();
+
+  int num_values = 2;
+  int max_step = 1;
+  double resolution = 0.1;
+  std::string directory, max_speed_name;
+  if (!n.getParam("planners/num_values", num_values) ||
+      !n.getParam("lattice/directory", directory) ||
+      !n.getParam("lattice/resolution", resolution) ||
+      !n.getParam("lattice/max_step", max_step) ||
+      !n.getParam("srv/max_planner_speed", max_speed_name)) {
+    ROS_ERROR("%s: Failed to load parameters.", name.c_str());
+    return EXIT_FAILURE;
+  }
+
+  ros::service::waitForService(max_speed_name.c_str());
+  ros::ServiceClient max_speed_srv =
+    n.serviceClient<value_function_srvs::GeometricPlannerSpeed>(
+      max_speed_name.c_str(), true);
+
+  // One library per planner, i.e. per even value function.
+  for (int ii = 0; ii < num_values - 1; ii += 2) {
+    value_function_srvs::GeometricPlannerSpeed s;
+    s.request.id = ii;
+    if (!max_speed_srv.call(s)) {
+      ROS_ERROR("%s: Error calling max planner speed server.", name.c_str());
+      return EXIT_FAILURE;
+    }
+
+    const meta::MotionPrimitives::Ptr primitives =
+      meta::MotionPrimitives::Create(
+        meta::Vector3d(s.response.x, s.response.y, s.response.z),
+        resolution, static_cast<size_t>(max_step));
+
+    const std::string file_name =
+      directory + "motion_primitives_" + std::to_string(ii) + ".bin";
+    if (!primitives->Save(file_name)) {
+      ROS_ERROR("%s: Could not write %s.", name.c_str(), file_name.c_str());
+      return EXIT_FAILURE;
+    }
+
+    ROS_INFO("%s: Saved %zu motion primitives to %s.",
+             name.c_str(), primitives->Size(), file_name.c_str());
+  }
+
+  return EXIT_SUCCESS;
+}
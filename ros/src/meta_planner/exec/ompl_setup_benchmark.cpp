@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Benchmark of OmplPlanner's setup overhead. Runs the same sequence of random
+// BIT* queries twice: once building the state space, SimpleSetup, objective
+// and planner from scratch for every query (as OmplPlanner used to), and once
+// configuring them a single time and only clearing the setup and resetting
+// start and goal between queries (as it does now). Only the setup is timed;
+// each query is then solved briefly so that clearing has real planner data
+// to drop. States are checked against random spherical obstacles in an
+// ObstacleStore, with no value function server involved.
+//
+// Usage: ompl_setup_benchmark [num_queries] [solve_budget_seconds]
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/obstacle_store.h>
+#include <meta_planner/time_optimization_objective.h>
+#include <utils/types.h>
+
+#include <ompl/geometric/SimpleSetup.h>
+#include <ompl/geometric/planners/bitstar/BITstar.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/util/Console.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace ob = ompl::base;
+namespace og = ompl::geometric;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Milliseconds elapsed since the given time.
+double MillisecondsSince(const Clock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(
+    Clock::now() - start).count();
+}
+
+// Environment shared by both runs.
+const meta::Vector3d kLower(0.0, 0.0, 0.0);
+const meta::Vector3d kUpper(10.0, 10.0, 10.0);
+const meta::Vector3d kTrackingBound(0.1, 0.1, 0.1);
+const meta::Vector3d kMaxSpeed(1.0, 1.0, 1.0);
+
+// A state space and setup, built the way OmplPlanner::Configure does.
+struct Setup {
+  std::shared_ptr<ob::RealVectorStateSpace> space_;
+  std::shared_ptr<og::SimpleSetup> setup_;
+};
+
+Setup Configure(const meta::ObstacleStore& obstacles) {
+  Setup setup;
+  setup.space_ = std::make_shared<ob::RealVectorStateSpace>(3);
+
+  ob::RealVectorBounds ompl_bounds(3);
+  for (size_t ii = 0; ii < 3; ii++) {
+    ompl_bounds.setLow(ii, kLower(ii));
+    ompl_bounds.setHigh(ii, kUpper(ii));
+  }
+
+  setup.space_->setBounds(ompl_bounds);
+
+  setup.setup_ = std::make_shared<og::SimpleSetup>(setup.space_);
+  setup.setup_->setStateValidityChecker(
+    [&obstacles](const ob::State* state) {
+      const double* values =
+        state->as<ob::RealVectorStateSpace::StateType>()->values;
+      return obstacles.CheckPoint(
+        meta::Vector3d(values[0], values[1], values[2]), kTrackingBound); });
+
+  const ob::SpaceInformationPtr& si = setup.setup_->getSpaceInformation();
+  setup.setup_->setOptimizationObjective(
+    std::make_shared<meta::TimeOptimizationObjective>(si, kMaxSpeed));
+  setup.setup_->setPlanner(std::make_shared<og::BITstar>(si));
+  return setup;
+}
+
+// Set the start and goal of a configured setup, and run setup().
+void Prepare(Setup& setup, const meta::Vector3d& start,
+             const meta::Vector3d& stop) {
+  ob::ScopedState<ob::RealVectorStateSpace> ompl_start(setup.space_);
+  ob::ScopedState<ob::RealVectorStateSpace> ompl_stop(setup.space_);
+  for (size_t ii = 0; ii < 3; ii++) {
+    ompl_start[ii] = start(ii);
+    ompl_stop[ii] = stop(ii);
+  }
+
+  setup.setup_->setStartAndGoalStates(ompl_start, ompl_stop);
+  setup.setup_->setup();
+}
+
+// Mean and maximum setup time per query, in milliseconds, and the number
+// of queries solved.
+struct Timing {
+  double mean_;
+  double max_;
+  size_t num_solved_;
+};
+
+Timing Benchmark(const meta::ObstacleStore& obstacles,
+                 const std::vector<meta::Vector3d>& starts,
+                 const std::vector<meta::Vector3d>& stops,
+                 double budget, bool reuse) {
+  Timing timing = { 0.0, 0.0, 0 };
+  Setup setup;
+
+  for (size_t ii = 0; ii < starts.size(); ii++) {
+    const Clock::time_point setup_start = Clock::now();
+    if (!reuse || setup.setup_ == nullptr)
+      setup = Configure(obstacles);
+    else
+      setup.setup_->clear();
+
+    Prepare(setup, starts[ii], stops[ii]);
+
+    const double elapsed = MillisecondsSince(setup_start);
+    timing.mean_ += elapsed;
+    timing.max_ = std::max(timing.max_, elapsed);
+
+    if (setup.setup_->solve(budget))
+      timing.num_solved_++;
+  }
+
+  timing.mean_ /= static_cast<double>(starts.size());
+  return timing;
+}
+
+} //\namespace
+
+int main(int argc, char** argv) {
+  const size_t num_queries = (argc > 1) ?
+    static_cast<size_t>(std::max(std::atoi(argv[1]), 1)) : 200;
+  const double budget = (argc > 2) ? std::atof(argv[2]) : 0.01;
+
+  ompl::msg::setLogLevel(ompl::msg::LogLevel::LOG_ERROR);
+
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif_point(0.0, 10.0);
+  std::uniform_real_distribution<double> unif_radius(0.2, 1.0);
+
+  // Random obstacles, and random queries between valid points.
+  const meta::ObstacleStore::Ptr obstacles = meta::ObstacleStore::Create();
+  for (size_t ii = 0; ii < 20; ii++)
+    obstacles->Add(meta::Vector3d(unif_point(rng), unif_point(rng),
+                                  unif_point(rng)), unif_radius(rng));
+
+  std::vector<meta::Vector3d> points;
+  while (points.size() < 2 * num_queries) {
+    const meta::Vector3d point(unif_point(rng), unif_point(rng),
+                               unif_point(rng));
+    if (obstacles->CheckPoint(point, kTrackingBound))
+      points.push_back(point);
+  }
+
+  const std::vector<meta::Vector3d> starts(
+    points.begin(), points.begin() + num_queries);
+  const std::vector<meta::Vector3d> stops(
+    points.begin() + num_queries, points.end());
+
+  const Timing per_call =
+    Benchmark(*obstacles, starts, stops, budget, false);
+  const Timing reused =
+    Benchmark(*obstacles, starts, stops, budget, true);
+
+  std::printf("%zu queries, %.3f s budget each\n", num_queries, budget);
+  std::printf("%10s %16s %16s %8s\n",
+              "setup", "mean (ms)", "max (ms)", "solved");
+  std::printf("%10s %16.3f %16.3f %8zu\n", "per call",
+              per_call.mean_, per_call.max_, per_call.num_solved_);
+  std::printf("%10s %16.3f %16.3f %8zu\n", "reused",
+              reused.mean_, reused.max_, reused.num_solved_);
+  return EXIT_SUCCESS;
+}
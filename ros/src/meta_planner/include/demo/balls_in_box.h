@@ -38,7 +38,11 @@
 //
 // Defines a Box environment with spherical obstacles. For simplicity, this
 // does not bother with a kdtree index to speed up collision queries, since
-// it is only for a simulated demo.
+// it is only for a simulated demo. Obstacles are kept in an ObstacleStore
+// so that collision checks can be vectorized, and published as immutable
+// snapshots so that sensing never interferes with planning. Sensed obstacles
+// may move at constant velocity, in which case they are checked at their
+// predicted positions along a trajectory's time stamps.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -46,8 +50,11 @@
 #define DEMO_BALLS_IN_BOX_H
 
 #include <meta_planner/box.h>
+#include <meta_planner/obstacle_store.h>
+#include <meta_planner/obstacle_snapshots.h>
 #include <utils/types.h>
 
+#include <stdint.h>
 #include <vector>
 
 namespace meta {
@@ -69,28 +76,115 @@ public:
                ValueFunctionId incoming_value,
                ValueFunctionId outgoing_value) const;
 
+  // Spatio-temporal collision checker. Checks against the predicted
+  // positions of all obstacles at the given time.
+  bool IsValid(const Vector3d& position, double time,
+               ValueFunctionId incoming_value,
+               ValueFunctionId outgoing_value) const;
+
+  // Batch collision checker. Checks blocks of points against all obstacles
+  // at once, one point per SIMD lane. IsValid does not go through here: a
+  // lone point would leave all but one lane idle, so it uses a per-point
+  // kernel which puts obstacles on the lanes instead.
+  void IsValidBatch(const std::vector<Vector3d>& points,
+                    ValueFunctionId incoming_value,
+                    ValueFunctionId outgoing_value,
+                    std::vector<bool>& out_mask) const;
+
+  // Rules out boxes which are out of bounds, or which lie entirely inside
+  // a single obstacle once inflated by the tracking bound.
+  bool IsBlocked(const Vector3d& lower, const Vector3d& upper,
+                 ValueFunctionId incoming_value,
+                 ValueFunctionId outgoing_value) const;
+
   // Check for obstacles within a sensing radius. Returns true if at least
   // one obstacle was sensed.
   bool SenseObstacles(const Vector3d& position, double sensor_radius,
                       std::vector<Vector3d>& obstacle_positions,
                       std::vector<double>& obstacle_radii) const;
 
-  // Check if a given obstacle is in the environment.
+  // Same as above, but reports the IDs and predicted positions of all
+  // obstacles at the given time, along with their velocities.
+  bool SenseObstacles(const Vector3d& position, double sensor_radius,
+                      double time,
+                      std::vector<uint64_t>& obstacle_ids,
+                      std::vector<Vector3d>& obstacle_positions,
+                      std::vector<Vector3d>& obstacle_velocities,
+                      std::vector<double>& obstacle_radii) const;
+
+  // Check if a given obstacle is in the environment. If so, publishes a new
+  // version with the known obstacle moved to match the given one.
   bool IsObstacle(const Vector3d& obstacle_position,
                   double obstacle_radius);
 
+  // Merge a list of obstacles sensed at the given time into the environment:
+  // known obstacles (matched against their predicted positions) are updated,
+  // and unknown ones are added. Velocities may be empty if all obstacles are
+  // static. Publishes at most one new version. Returns true if any obstacle
+  // was unknown, and the indices (into the given lists) of the obstacles
+  // which were added or changed.
+  bool MergeObstacles(const std::vector<Vector3d>& obstacle_positions,
+                      const std::vector<double>& obstacle_radii,
+                      const std::vector<Vector3d>& obstacle_velocities,
+                      double stamp, std::vector<size_t>& out_changed);
+
+  // Apply an incremental sensor update: obstacles are matched by ID, in
+  // constant time each. Removed obstacles are dropped, and on a full resync
+  // so is every obstacle not listed. Publishes at most one new version.
+  // Returns true if any obstacle was unknown, and the indices (into the
+  // given lists) of the obstacles which were added or changed.
+  bool ApplyObstacleDeltas(const std::vector<uint64_t>& obstacle_ids,
+                           const std::vector<Vector3d>& obstacle_positions,
+                           const std::vector<double>& obstacle_radii,
+                           const std::vector<Vector3d>& obstacle_velocities,
+                           const std::vector<uint64_t>& removed_ids,
+                           bool full_resync, double stamp,
+                           std::vector<size_t>& out_changed);
+
+  // Latest version of the obstacles.
+  inline ObstacleStore::ConstPtr Obstacles() const {
+    return obstacles_.Current();
+  }
+
+  // Version of the obstacles seen by collision checks, i.e. the pinned
+  // version if there is one.
+  inline ObstacleStore::ConstPtr PinnedObstacles() const {
+    return obstacles_.Get();
+  }
+
   // Inherited visualizer from Box needs to be overwritten.
   void Visualize(const ros::Publisher& pub, const std::string& frame_id) const;
 
   // Add a spherical obstacle of the given radius to the environment.
   void AddObstacle(const Vector3d& point, double r);
 
+  // Versioning and pinning. See environment.h.
+  inline uint64_t Version() const { return obstacles_.Current()->Version(); }
+  inline uint64_t Pin() const { return obstacles_.Pin(); }
+  inline void Unpin() const { obstacles_.Unpin(); }
+  inline uint64_t CheckedVersion() const {
+    return obstacles_.Get()->Version();
+  }
+
 private:
   BallsInBox();
 
-  // List of obstacle locations and radii.
-  std::vector<VectorXd> points_;
-  std::vector<double> radii_;
+  // Load parameters.
+  bool LoadParameters(const ros::NodeHandle& n);
+
+  // Find a known obstacle whose predicted position at the given time matches
+  // the given one. Returns the index of the obstacle in the store, or -1 if
+  // none matches.
+  static int FindObstacle(const ObstacleStore& obstacles,
+                          const Vector3d& obstacle_position,
+                          double obstacle_radius, double time);
+
+  // Versioned obstacle locations and radii.
+  ObstacleSnapshots obstacles_;
+
+  // Time horizon and bin length for indexing predicted swept volumes.
+  double prediction_horizon_;
+  double prediction_bin_dt_;
 };
 
 } //\namespace meta
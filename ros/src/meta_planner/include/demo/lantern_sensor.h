@@ -46,6 +46,7 @@
 
 #include <demo/balls_in_box.h>
 #include <demo/lanterns_in_box.h>
+#include <demo/obstacle_deltas.h>
 #include <value_function/near_hover_quad_no_yaw.h>
 #include <utils/types.h>
 #include <utils/uncopyable.h>
@@ -84,6 +85,9 @@ private:
   // Sensor radius.
   double sensor_radius_;
 
+  // Turns sensed obstacles into incremental sensor messages.
+  ObstacleDeltas deltas_;
+
   // State space.
   //BallsInBox::Ptr space_;
   LanternsInBox::Ptr space_;
@@ -39,6 +39,8 @@
 // Defines a Box environment with spherical Chinese paper lantern obstacles.
 // These lanterns exist in real life, so this environment constantly listens
 // to tf to get their positions (and assumes their sizes to remain constant).
+// Each lantern is modeled as moving at constant velocity, estimated from the
+// history of its tf poses, so that it can be checked at future times.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -46,6 +48,8 @@
 #define DEMO_LANTERNS_IN_BOX_H
 
 #include <meta_planner/box.h>
+#include <meta_planner/obstacle_store.h>
+#include <meta_planner/obstacle_snapshots.h>
 #include <utils/types.h>
 
 #include <vector>
@@ -82,12 +86,27 @@ public:
                ValueFunctionId incoming_value,
                ValueFunctionId outgoing_value) const;
 
+  // Spatio-temporal collision checker. Checks against the predicted
+  // positions of all lanterns at the given time.
+  bool IsValid(const Vector3d& position, double time,
+               ValueFunctionId incoming_value,
+               ValueFunctionId outgoing_value) const;
+
   // Check for obstacles within a sensing radius. Returns true if at least
   // one obstacle was sensed.
   bool SenseObstacles(const Vector3d& position, double sensor_radius,
                       std::vector<Vector3d>& obstacle_positions,
                       std::vector<double>& obstacle_radii) const;
 
+  // Same as above, but reports the IDs and predicted positions of all
+  // obstacles at the given time, along with their estimated velocities.
+  bool SenseObstacles(const Vector3d& position, double sensor_radius,
+                      double time,
+                      std::vector<uint64_t>& obstacle_ids,
+                      std::vector<Vector3d>& obstacle_positions,
+                      std::vector<Vector3d>& obstacle_velocities,
+                      std::vector<double>& obstacle_radii) const;
+
   // Check if a given obstacle is in the environment.
   bool IsObstacle(const Vector3d& obstacle_position,
                   double obstacle_radius) const;
@@ -95,6 +114,17 @@ public:
   // Inherited visualizer from Box needs to be overwritten.
   void Visualize(const ros::Publisher& pub, const std::string& frame_id) const;
 
+  // Latest version of the lantern motion models. Lanterns are identified by
+  // their index in the list of lantern frames.
+  inline ObstacleStore::ConstPtr Obstacles() const {
+    return obstacles_.Current();
+  }
+
+  // Versioning and pinning. See environment.h.
+  inline uint64_t Version() const { return obstacles_.Current()->Version(); }
+  inline uint64_t Pin() const { return obstacles_.Pin(); }
+  inline void Unpin() const { obstacles_.Unpin(); }
+
 private:
   LanternsInBox();
 
@@ -102,10 +132,21 @@ private:
   bool LoadParameters(const ros::NodeHandle& n);
   bool RegisterCallbacks(const ros::NodeHandle& n);
 
-  // List of obstacle locations and shared radius.
-  std::vector<Vector3d> points_;
+  // Versioned lantern motion models, and the shared radius.
+  ObstacleSnapshots obstacles_;
   double radius_;
 
+  // Most recent tf position and time stamp of each lantern, and the
+  // exponentially smoothed velocity estimate.
+  std::vector<Vector3d> last_points_;
+  std::vector<double> last_stamps_;
+  std::vector<Vector3d> velocities_;
+  double velocity_smoothing_;
+
+  // Time horizon and bin length for indexing predicted swept volumes.
+  double prediction_horizon_;
+  double prediction_bin_dt_;
+
   // Frames.
   std::string fixed_frame_id_;
   std::vector<std::string> lantern_frame_ids_;
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ObstacleDeltas class, which turns the obstacles a sensor sees
+// on each tick into incremental SensorMeasurement messages. Only obstacles
+// which are newly detected, have changed, or have been removed from the
+// environment are published, along with a sequence number. Every so often
+// a full resync lists every obstacle reported so far, so that a listener
+// which has missed messages can catch up.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DEMO_OBSTACLE_DELTAS_H
+#define DEMO_OBSTACLE_DELTAS_H
+
+#include <meta_planner/obstacle_store.h>
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <meta_planner_msgs/SensorMeasurement.h>
+
+#include <ros/ros.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace meta {
+
+class ObstacleDeltas : private Uncopyable {
+public:
+  explicit ObstacleDeltas()
+    : sequence_(0),
+      resync_time_(1.0),
+      last_resync_(0.0) {}
+  ~ObstacleDeltas() {}
+
+  // Set the time between full resyncs.
+  inline void SetResyncTime(double resync_time) { resync_time_ = resync_time; }
+
+  // Diff the obstacles sensed at the given time against what has already
+  // been reported, and fill in 'msg' with the result. Obstacles which have
+  // been reported but are no longer in 'environment' are reported removed.
+  // Returns true if there is anything to publish.
+  bool Update(const std::vector<uint64_t>& ids,
+              const std::vector<Vector3d>& positions,
+              const std::vector<Vector3d>& velocities,
+              const std::vector<double>& radii,
+              const ObstacleStore& environment,
+              const ros::Time& stamp,
+              meta_planner_msgs::SensorMeasurement& msg);
+
+private:
+  // Last reported state of an obstacle.
+  struct Reported {
+    Vector3d position_;
+    Vector3d velocity_;
+    double radius_;
+    double stamp_;
+  };
+
+  // Append one obstacle to a message, at its predicted position at the
+  // given time.
+  static void Append(uint64_t id, const Reported& obstacle, double time,
+                     meta_planner_msgs::SensorMeasurement& msg);
+
+  // Every obstacle reported so far, keyed on ID.
+  std::unordered_map<uint64_t, Reported> reported_;
+
+  // Sequence number of the last message.
+  uint64_t sequence_;
+
+  // Time between full resyncs, and time of the last one.
+  double resync_time_;
+  double last_resync_;
+};
+
+} //\namespace meta
+
+#endif
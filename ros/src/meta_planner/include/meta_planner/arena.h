@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the Arena class, a monotonic (bump) allocator. Memory comes from
+// large blocks and is never freed piecemeal: all of it is released at once
+// when the Arena is destroyed. Allocation is thread-safe, and only takes a
+// lock to start a new block.
+//
+// Objects are tied to an arena through shared pointers. The ArenaAllocator
+// (for containers) and the shared pointers made by ArenaShared() both hold
+// the Arena, so it lives exactly as long as anything allocated from it. An
+// ArenaAllocator without an Arena falls back to the heap.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_ARENA_H
+#define META_PLANNER_ARENA_H
+
+#include <utils/uncopyable.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace meta {
+
+class Arena : private Uncopyable {
+public:
+  typedef std::shared_ptr<Arena> Ptr;
+  typedef std::shared_ptr<const Arena> ConstPtr;
+
+  // Factory method. Use this instead of the constructor.
+  static Ptr Create(size_t block_size = kDefaultBlockSize);
+
+  // Destructor. Releases every block.
+  ~Arena();
+
+  // Allocate the given number of bytes with the given alignment, which must
+  // be a power of two.
+  void* Allocate(size_t size, size_t alignment);
+
+  // Total bytes handed out, and total bytes held in blocks.
+  size_t Allocated() const;
+  size_t Reserved() const;
+
+  // Default size of each block, in bytes.
+  static const size_t kDefaultBlockSize;
+
+private:
+  explicit Arena(size_t block_size);
+
+  // Header at the start of each regular block, marking its free part.
+  // Threads claim space by moving head_ forward atomically.
+  struct Block {
+    std::atomic<char*> head_;
+    char* end_;
+  };
+
+  // Size of each regular block, not counting its header.
+  const size_t block_size_;
+
+  // Block currently being allocated from, or null before the first one.
+  std::atomic<Block*> current_;
+
+  std::atomic<size_t> allocated_;
+  std::atomic<size_t> reserved_;
+
+  // Every block. The lock is only held to add one.
+  std::vector<char*> blocks_;
+  std::mutex mutex_;
+};
+
+// Standard allocator drawing from an Arena, or from the heap without one.
+// Deallocation is a no-op in an Arena.
+template<typename T>
+class ArenaAllocator {
+public:
+  typedef T value_type;
+
+  template<typename U>
+  struct rebind { typedef ArenaAllocator<U> other; };
+
+  ArenaAllocator() {}
+  explicit ArenaAllocator(const Arena::Ptr& arena)
+    : arena_(arena) {}
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other)
+    : arena_(other.GetArena()) {}
+
+  inline T* allocate(size_t n) {
+    if (arena_ == nullptr)
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+
+    return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+  }
+
+  inline void deallocate(T* ptr, size_t) {
+    if (arena_ == nullptr)
+      ::operator delete(ptr);
+  }
+
+  inline const Arena::Ptr& GetArena() const { return arena_; }
+
+private:
+  Arena::Ptr arena_;
+};
+
+template<typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.GetArena() == b.GetArena();
+}
+
+template<typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return !(a == b);
+}
+
+// Destroys an object in an Arena without freeing its memory, and keeps the
+// Arena alive until then.
+template<typename T>
+struct ArenaDeleter {
+  Arena::Ptr arena_;
+
+  inline void operator()(T* ptr) const { ptr->~T(); }
+};
+
+// Shared pointer to an object constructed in memory from the given Arena,
+// whose control block also comes from the Arena.
+template<typename T>
+inline std::shared_ptr<T> ArenaShared(T* ptr, const Arena::Ptr& arena) {
+  return std::shared_ptr<T>(
+    ptr, ArenaDeleter<T>{ arena }, ArenaAllocator<T>(arena));
+}
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the BatchMotionValidator class, an OMPL MotionValidator which
+// discretizes a straight-line motion in R^3 and checks all intermediate
+// states with a single call to Environment::IsValidBatch.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_BATCH_MOTION_VALIDATOR_H
+#define META_PLANNER_BATCH_MOTION_VALIDATOR_H
+
+#include <meta_planner/environment.h>
+#include <utils/types.h>
+
+#include <ompl/base/MotionValidator.h>
+#include <ompl/base/SpaceInformation.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <memory>
+#include <vector>
+
+namespace meta {
+
+namespace ob = ompl::base;
+
+class BatchMotionValidator : public ob::MotionValidator {
+public:
+  explicit BatchMotionValidator(const ob::SpaceInformationPtr& si,
+                                const Environment* space,
+                                ValueFunctionId incoming_value,
+                                ValueFunctionId outgoing_value)
+    : ob::MotionValidator(si),
+      space_(space),
+      incoming_value_(incoming_value),
+      outgoing_value_(outgoing_value) {}
+
+  ~BatchMotionValidator() {}
+
+  // Check the motion from s1 to s2. Assumes s1 is valid.
+  bool checkMotion(const ob::State* s1, const ob::State* s2) const;
+
+  // Check the motion from s1 to s2, and if it is invalid report the last
+  // valid state and the fraction of the motion at which it occurs.
+  bool checkMotion(const ob::State* s1, const ob::State* s2,
+                   std::pair<ob::State*, double>& last_valid) const;
+
+private:
+  // Discretize the motion from s1 to s2 (excluding s1) and collision check
+  // every point. Returns the number of segments.
+  unsigned int CheckSegments(const ob::State* s1, const ob::State* s2,
+                             std::vector<bool>& mask) const;
+
+  // Convert an OMPL state to a Vector3d.
+  static inline Vector3d FromOmplState(const ob::State* state) {
+    const ob::RealVectorStateSpace::StateType* cast_state =
+      state->as<ob::RealVectorStateSpace::StateType>();
+    return Vector3d(cast_state->values[0],
+                    cast_state->values[1],
+                    cast_state->values[2]);
+  }
+
+  // Environment and value functions used for collision checking.
+  const Environment* space_;
+  const ValueFunctionId incoming_value_;
+  const ValueFunctionId outgoing_value_;
+};
+
+// ------------------------------- IMPLEMENTATION --------------------------- //
+
+// Discretize the motion from s1 to s2 (excluding s1) and collision check
+// every point. Returns the number of segments.
+inline unsigned int BatchMotionValidator::
+CheckSegments(const ob::State* s1, const ob::State* s2,
+              std::vector<bool>& mask) const {
+  const unsigned int num_segments =
+    si_->getStateSpace()->validSegmentCount(s1, s2);
+
+  const Vector3d start = FromOmplState(s1);
+  const Vector3d stop = FromOmplState(s2);
+
+  // Intermediate points, ending with s2 itself.
+  std::vector<Vector3d> points(num_segments);
+  for (unsigned int ii = 1; ii <= num_segments; ii++)
+    points[ii - 1] = start + (stop - start) *
+      (static_cast<double>(ii) / static_cast<double>(num_segments));
+
+  space_->IsValidBatch(points, incoming_value_, outgoing_value_, mask);
+  return num_segments;
+}
+
+// Check the motion from s1 to s2. Assumes s1 is valid.
+inline bool BatchMotionValidator::
+checkMotion(const ob::State* s1, const ob::State* s2) const {
+  std::vector<bool> mask;
+  CheckSegments(s1, s2, mask);
+
+  for (size_t ii = 0; ii < mask.size(); ii++) {
+    if (!mask[ii]) {
+      invalid_++;
+      return false;
+    }
+  }
+
+  valid_++;
+  return true;
+}
+
+// Check the motion from s1 to s2, and if it is invalid report the last
+// valid state and the fraction of the motion at which it occurs.
+inline bool BatchMotionValidator::
+checkMotion(const ob::State* s1, const ob::State* s2,
+            std::pair<ob::State*, double>& last_valid) const {
+  std::vector<bool> mask;
+  const unsigned int num_segments = CheckSegments(s1, s2, mask);
+
+  for (unsigned int ii = 0; ii < mask.size(); ii++) {
+    if (!mask[ii]) {
+      // Point ii is at fraction (ii + 1) / num_segments, so the last
+      // valid one is at ii / num_segments.
+      last_valid.second =
+        static_cast<double>(ii) / static_cast<double>(num_segments);
+
+      if (last_valid.first != nullptr)
+        si_->getStateSpace()->interpolate(
+          s1, s2, last_valid.second, last_valid.first);
+
+      invalid_++;
+      return false;
+    }
+  }
+
+  valid_++;
+  return true;
+}
+
+} //\namespace meta
+
+#endif
@@ -49,6 +49,10 @@
 #include <ros/ros.h>
 #include <memory>
 #include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <utility>
 #include <random>
 
 namespace meta {
@@ -65,7 +69,18 @@ public:
   virtual ~Box() {}
 
   // Inherited from Environment, but can be overwritten by child classes.
-  virtual Vector3d Sample() const;
+  using Environment::Sample;
+  virtual Vector3d Sample(std::default_random_engine& rng) const;
+  virtual Vector3d Sample(HaltonSequence& sequence) const;
+
+  // Inherited from Environment, but can be overwritten by child classes.
+  // Samples from the bounding box of the informed subset, and rejects points
+  // outside it. Travel time is measured in the weighted L-infinity norm,
+  // just as the value functions' best possible time.
+  virtual bool SampleInformed(const Vector3d& start, const Vector3d& stop,
+                              const Vector3d& max_speed, double max_time,
+                              HaltonSequence& sequence,
+                              Vector3d& sample) const;
 
   // Inherited from Environment, but can be overwritten by child classes.
   // Returns true if the state is a valid configuration.
@@ -73,6 +88,21 @@ public:
   virtual bool IsValid(const Vector3d& position,
                        ValueFunctionId incoming_value,
                        ValueFunctionId outgoing_value) const;
+  using Environment::IsValid;
+
+  // Inherited from Environment, but can be overwritten by child classes.
+  // Looks up the tracking bound once for the whole batch.
+  virtual void IsValidBatch(const std::vector<Vector3d>& points,
+                            ValueFunctionId incoming_value,
+                            ValueFunctionId outgoing_value,
+                            std::vector<bool>& out_mask) const;
+
+  // Inherited from Environment, but can be overwritten by child classes.
+  // Rules out boxes which lie entirely outside the bounds, once shrunk by
+  // the tracking bound.
+  virtual bool IsBlocked(const Vector3d& lower, const Vector3d& upper,
+                         ValueFunctionId incoming_value,
+                         ValueFunctionId outgoing_value) const;
 
   // Inherited by Environment, but can be overwritten by child classes.
   // Assumes that the first <=3 dimensions correspond to R^3.
@@ -86,12 +116,55 @@ public:
   inline const Vector3d& LowerBounds() const { return lower_; }
   inline const Vector3d& UpperBounds() const { return upper_; }
 
+  // Request the switching tracking bound for every pair of the given number
+  // of value functions up front, so that collision checks never have to
+  // wait on the server. Returns the number of pairs that were cached.
+  size_t CacheSwitchingBounds(size_t num_values);
+
 protected:
   explicit Box();
 
+  // Switching tracking bounds, keyed on (incoming, outgoing).
+  typedef std::map<std::pair<ValueFunctionId, ValueFunctionId>, Vector3d>
+    BoundMap;
+
+  // Query the switching tracking bound for this pair of value functions.
+  // Returns false if the server could not be reached. Bounds never change,
+  // so each pair is only requested from the server once.
+  bool SwitchingBound(ValueFunctionId incoming_value,
+                      ValueFunctionId outgoing_value,
+                      Vector3d& bound) const;
+
+  // Ask the server for the switching tracking bound for this pair of value
+  // functions, and add it to the cache. Thread safe, and no lock is held
+  // while waiting on the server.
+  bool RequestSwitchingBound(ValueFunctionId incoming_value,
+                             ValueFunctionId outgoing_value,
+                             Vector3d& bound) const;
+
+  // Check if the given tracking bound box around this position lies
+  // entirely inside the box.
+  inline bool InBounds(const Vector3d& position, const Vector3d& bound) const {
+    return !(position(0) < lower_(0) + bound(0) ||
+             position(0) > upper_(0) - bound(0) ||
+             position(1) < lower_(1) + bound(1) ||
+             position(1) > upper_(1) - bound(1) ||
+             position(2) < lower_(2) + bound(2) ||
+             position(2) > upper_(2) - bound(2));
+  }
+
   // Bounds.
   Vector3d lower_;
   Vector3d upper_;
+
+  // Cache of switching tracking bounds. The map itself is never modified;
+  // new entries are added to a copy, which is then published atomically,
+  // so lookups never take a lock. Only ever accessed through
+  // std::atomic_load/store.
+  mutable std::shared_ptr<const BoundMap> bound_cache_;
+
+  // Serializes additions to the cache (but not service calls).
+  mutable std::mutex bound_write_mutex_;
 };
 
 } //\namespace meta
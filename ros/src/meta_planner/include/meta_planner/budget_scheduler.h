@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the BudgetScheduler class, which chooses how much time to give
+// each Planner for each call. Calls are grouped into cells by planner,
+// segment length, and number of nearby obstacles. Within each cell, the
+// scheduler estimates the distribution of time-to-success from past calls
+// (Kaplan-Meier, treating failed and cancelled calls as censored) and picks
+// the budget which maximizes expected successes per second of planning.
+// Calls only teach us about the time they were given, so every so often a
+// call is given the maximum budget instead, so that longer budgets can be
+// learned too.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_BUDGET_SCHEDULER_H
+#define META_PLANNER_BUDGET_SCHEDULER_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <meta_planner_msgs/BudgetStatistics.h>
+
+#include <ros/ros.h>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace meta {
+
+class BudgetScheduler : private Uncopyable {
+public:
+  typedef std::shared_ptr<BudgetScheduler> Ptr;
+  typedef std::shared_ptr<const BudgetScheduler> ConstPtr;
+
+  // Number of segment length bins, obstacle density bins, and time buckets
+  // per cell.
+  static const size_t kNumLengthBins = 4;
+  static const size_t kNumDensityBins = 4;
+  static const size_t kNumBuckets = 20;
+
+  // Number of calls in a cell before its statistics are trusted.
+  static const size_t kMinAttempts = 20;
+
+  // One in this many budgets in each cell is the maximum budget.
+  static const size_t kExplorationPeriod = 10;
+
+  // Factory method. Use this instead of the constructor. Segments are
+  // binned by length up to max_length. Budgets are chosen from
+  // (0, max_budget]; default_budget is used until a cell has enough calls.
+  static Ptr Create(size_t num_planners, double max_length,
+                    double default_budget, double max_budget);
+
+  // Destructor.
+  ~BudgetScheduler() {}
+
+  // Budget (seconds) for a planner to plan a segment of the given length,
+  // with the given number of obstacles nearby. Every kExplorationPeriod-th
+  // budget in each cell is the maximum budget.
+  double Budget(size_t planner_id, double length, size_t num_nearby);
+
+  // Record a call which ran for the given time before it succeeded, failed,
+  // or was cancelled.
+  void Record(size_t planner_id, double length, size_t num_nearby,
+              double elapsed, bool succeeded);
+
+  // Load/save statistics from/to a file. Loading fails if the file does not
+  // match this scheduler's configuration.
+  bool Load(const std::string& file_name);
+  bool Save(const std::string& file_name) const;
+
+  // Convert to ROS message.
+  meta_planner_msgs::BudgetStatistics ToRosMessage() const;
+
+private:
+  explicit BudgetScheduler(size_t num_planners, double max_length,
+                           double default_budget, double max_budget);
+
+  // Statistics for one cell. For each time bucket, the number of calls
+  // still running at the start of the bucket, and the number of those
+  // which succeeded during it.
+  struct Cell {
+    std::array<double, kNumBuckets> exposures_;
+    std::array<double, kNumBuckets> successes_;
+    size_t num_attempts_;
+    size_t num_successes_;
+    double total_success_latency_;
+
+    // Number of budgets handed out. Not saved.
+    size_t num_budgets_;
+
+    Cell()
+      : num_attempts_(0),
+        num_successes_(0),
+        total_success_latency_(0.0),
+        num_budgets_(0) {
+      exposures_.fill(0.0);
+      successes_.fill(0.0);
+    }
+  };
+
+  // Index of the cell for the given planner, length, and density.
+  size_t CellIndex(size_t planner_id, double length, size_t num_nearby) const;
+
+  // Budget for the given cell. Assumes the lock is held.
+  double CellBudget(const Cell& cell) const;
+
+  // Configuration.
+  const size_t num_planners_;
+  const double max_length_;
+  const double default_budget_;
+  const double max_budget_;
+  const double bucket_width_;
+
+  // All cells, indexed by CellIndex().
+  std::vector<Cell> cells_;
+  mutable std::mutex mutex_;
+};
+
+} //\namespace meta
+
+#endif
@@ -43,6 +43,7 @@
 #ifndef META_PLANNER_ENVIRONMENT_H
 #define META_PLANNER_ENVIRONMENT_H
 
+#include <meta_planner/halton_sequence.h>
 #include <utils/types.h>
 #include <utils/uncopyable.h>
 
@@ -50,8 +51,10 @@
 
 #include <ros/ros.h>
 #include <visualization_msgs/Marker.h>
+#include <stdint.h>
 #include <random>
 #include <string>
+#include <vector>
 
 namespace meta {
 
@@ -65,8 +68,26 @@ public:
   // Re-seed the random engine.
   inline void Seed(unsigned int seed) const { rng_.seed(seed); }
 
-  // Derived classes must be able to sample uniformly from the state space.
-  virtual Vector3d Sample() const = 0;
+  // Sample uniformly from the state space, using the environment's own
+  // random engine. Not thread-safe; concurrent callers should each pass
+  // their own engine to the overload below.
+  inline Vector3d Sample() const { return Sample(rng_); }
+
+  // Derived classes must be able to sample uniformly from the state space,
+  // using the given random engine.
+  virtual Vector3d Sample(std::default_random_engine& rng) const = 0;
+
+  // Same as above, but drawing from a low-discrepancy sequence.
+  virtual Vector3d Sample(HaltonSequence& sequence) const = 0;
+
+  // Derived classes must be able to sample from the informed subset of the
+  // state space: points through which a planner with the given per-axis
+  // maximum speeds could go from start to stop within max_time. Returns false
+  // if no such point was found.
+  virtual bool SampleInformed(const Vector3d& start, const Vector3d& stop,
+                              const Vector3d& max_speed, double max_time,
+                              HaltonSequence& sequence,
+                              Vector3d& sample) const = 0;
 
   // Derived classes must provide a collision checker which returns true if
   // and only if the provided position is a valid collision-free configuration.
@@ -75,6 +96,49 @@ public:
                        ValueFunctionId incoming_value,
                        ValueFunctionId outgoing_value) const = 0;
 
+  // Spatio-temporal collision checker, for environments whose obstacles
+  // move over time. Returns true if the position is valid at the given time.
+  // Static environments need not override this.
+  virtual bool IsValid(const Vector3d& position, double time,
+                       ValueFunctionId incoming_value,
+                       ValueFunctionId outgoing_value) const {
+    return IsValid(position, incoming_value, outgoing_value);
+  }
+
+  // Batch collision checker. Sets out_mask[ii] to true if and only if
+  // points[ii] is valid. The default implementation just calls IsValid on
+  // each point; derived classes may override this to check whole blocks of
+  // points at once.
+  virtual void IsValidBatch(const std::vector<Vector3d>& points,
+                            ValueFunctionId incoming_value,
+                            ValueFunctionId outgoing_value,
+                            std::vector<bool>& out_mask) const;
+
+  // Derived classes may rule out whole regions of the state space, so that
+  // samplers can skip them. Returns true only if every position in the
+  // axis-aligned box from lower to upper is invalid. By default, nothing is
+  // ever ruled out.
+  virtual bool IsBlocked(const Vector3d& lower, const Vector3d& upper,
+                         ValueFunctionId incoming_value,
+                         ValueFunctionId outgoing_value) const {
+    return false;
+  }
+
+  // Version number of the environment. Derived classes whose contents
+  // change over time (e.g. as obstacles are sensed) should bump this
+  // every time they change.
+  virtual uint64_t Version() const { return 0; }
+
+  // Pin the current version, so that all collision checks see the same
+  // environment until Unpin() is called, and return the pinned version.
+  // Static environments need not do anything.
+  virtual uint64_t Pin() const { return Version(); }
+  virtual void Unpin() const {}
+
+  // Version seen by collision checks, i.e. the pinned version if there is
+  // one, otherwise the latest.
+  virtual uint64_t CheckedVersion() const { return Version(); }
+
   // Derived classes must have some sort of visualization through RVIZ.
   virtual void Visualize(const ros::Publisher& pub,
                          const std::string& frame_id) const = 0;
@@ -101,6 +165,22 @@ protected:
   std::string name_;
 };
 
+// Pins an environment for as long as this object is in scope.
+class ScopedPin : private Uncopyable {
+public:
+  explicit ScopedPin(const Environment& space)
+    : space_(space),
+      version_(space.Pin()) {}
+  ~ScopedPin() { space_.Unpin(); }
+
+  // Pinned version.
+  inline uint64_t Version() const { return version_; }
+
+private:
+  const Environment& space_;
+  const uint64_t version_;
+};
+
 } //\namespace meta
 
 #endif
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the Frontier class, a priority queue of the waypoints in a
+// WaypointTree ranked by arrival time plus a lower bound on the time from
+// there to the goal. Taking a waypoint puts it back at a lower rank, so that
+// the most promising waypoints are expanded most often but none forever.
+// Waypoints may be pushed and taken from multiple threads at once.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_FRONTIER_H
+#define META_PLANNER_FRONTIER_H
+
+#include <meta_planner/waypoint.h>
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+namespace meta {
+
+class Frontier : private Uncopyable {
+public:
+  typedef std::shared_ptr<Frontier> Ptr;
+  typedef std::shared_ptr<const Frontier> ConstPtr;
+
+  // Factory method. Use this instead of the constructor.
+  static Ptr Create();
+
+  // Destructor.
+  ~Frontier() {}
+
+  // Remove all waypoints.
+  void Clear();
+
+  // Add a waypoint, given its arrival time plus a lower bound on the time
+  // from there to the goal.
+  void Push(const Waypoint::ConstPtr& waypoint, double cost);
+
+  // Take the most promising waypoint, or null if there are none. Also
+  // returns the cost it was pushed with. The waypoint stays in the frontier,
+  // but its rank drops each time it is taken.
+  Waypoint::ConstPtr Next(double& cost);
+
+  // Number of waypoints.
+  size_t Size() const;
+
+private:
+  explicit Frontier() {}
+
+  // A waypoint, its cost, the number of times it has been taken, and the
+  // resulting priority (lower is better).
+  struct Entry {
+    double priority_;
+    double cost_;
+    size_t num_taken_;
+    Waypoint::ConstPtr waypoint_;
+
+    inline bool operator>(const Entry& other) const {
+      return priority_ > other.priority_;
+    }
+  };
+
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > queue_;
+  mutable std::mutex mutex_;
+};
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines a three-dimensional Halton sequence in the unit cube, used for
+// low-discrepancy sampling. Each sequence is shifted by its own random offset
+// (modulo one), so that several sequences cover the cube independently.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_HALTON_SEQUENCE_H
+#define META_PLANNER_HALTON_SEQUENCE_H
+
+#include <utils/types.h>
+
+#include <random>
+
+namespace meta {
+
+class HaltonSequence {
+public:
+  explicit HaltonSequence(const Vector3d& shift = Vector3d::Zero())
+    : index_(0),
+      shift_(shift) {}
+
+  // Start from a random shift drawn from the given engine.
+  explicit HaltonSequence(std::default_random_engine& rng)
+    : index_(0) {
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    for (size_t ii = 0; ii < 3; ii++)
+      shift_(ii) = unif(rng);
+  }
+
+  ~HaltonSequence() {}
+
+  // Next point in the unit cube.
+  inline Vector3d Next() {
+    // One prime base per dimension.
+    const size_t kBases[3] = { 2, 3, 5 };
+
+    index_++;
+
+    Vector3d point;
+    for (size_t ii = 0; ii < 3; ii++) {
+      point(ii) = RadicalInverse(index_, kBases[ii]) + shift_(ii);
+      if (point(ii) >= 1.0)
+        point(ii) -= 1.0;
+    }
+
+    return point;
+  }
+
+  // Skip ahead, as if count points had been drawn.
+  inline void Skip(size_t count) { index_ += count; }
+
+  // Number of points drawn (or skipped) so far.
+  inline size_t Index() const { return index_; }
+
+  // Reflect the base-b digits of the index about the radix point.
+  static inline double RadicalInverse(size_t index, size_t base) {
+    const double inverse_base = 1.0 / static_cast<double>(base);
+
+    double result = 0.0;
+    double scale = inverse_base;
+    while (index > 0) {
+      result += scale * static_cast<double>(index % base);
+      index /= base;
+      scale *= inverse_base;
+    }
+
+    return result;
+  }
+
+private:
+  // Number of points drawn so far, and offset applied to each of them.
+  size_t index_;
+  Vector3d shift_;
+};
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the KdTree class, an incremental kdtree over 3D points with values
+// attached, under a weighted L-infinity metric: the maximum over axes of the
+// absolute difference times that axis' weight.
+//
+// Points are inserted by the logarithmic method. New points collect in a
+// small buffer. Each time the buffer fills, it is merged with the smallest
+// full levels into the first empty one, and that level is rebuilt as a
+// static, balanced tree. Level ii holds either nothing or exactly
+// kLeafSize * 2^ii points, stored contiguously in the order of the tree, so
+// inserts take amortized O(log^2 n) time. Searches visit every level.
+//
+// Searches write into caller-provided buffers and never allocate. They may
+// run from multiple threads at once, but not during an insert.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_KD_TREE_H
+#define META_PLANNER_KD_TREE_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace meta {
+
+template<typename T>
+class KdTree : private Uncopyable {
+public:
+  explicit KdTree(const Vector3d& weights = Vector3d::Ones())
+    : weights_(weights),
+      size_(0) {
+    buffer_.reserve(kLeafSize);
+  }
+  ~KdTree() {}
+
+  // Maximum number of points searched by brute force, at once.
+  static const size_t kLeafSize = 8;
+
+  // Weighted L-infinity distance between two points.
+  inline double Distance(const Vector3d& a, const Vector3d& b) const {
+    return (a - b).cwiseAbs().cwiseProduct(weights_).maxCoeff();
+  }
+
+  // Number of points in the tree.
+  inline size_t Size() const { return size_; }
+
+  // Insert a point with the given value.
+  void Insert(const Vector3d& point, const T& value);
+
+  // Remove all points.
+  void Clear();
+
+  // Find the (at most) k nearest points within max_distance of the query.
+  // Writes their values and distances, closest first, into the given
+  // buffers, which must hold at least k elements. Returns how many were
+  // found.
+  size_t KnnSearch(const Vector3d& query, size_t k,
+                   T* values, double* distances,
+                   double max_distance =
+                   std::numeric_limits<double>::infinity()) const;
+
+  // Find the points within distance r of the query, closest first, into the
+  // given buffers of the given capacity. Returns how many were found, which
+  // is never more than the capacity.
+  inline size_t RadiusSearch(const Vector3d& query, double r,
+                             size_t capacity,
+                             T* values, double* distances) const {
+    return KnnSearch(query, capacity, values, distances, r);
+  }
+
+private:
+  // A point with its value.
+  struct Entry {
+    Vector3d point_;
+    T value_;
+  };
+
+  // An internal node splits its points at the median along one axis. Nodes
+  // are stored implicitly, as in a binary heap: node ii has children 2 ii
+  // and 2 ii + 1, and the root is node 1.
+  struct Node {
+    double split_;
+    size_t axis_;
+  };
+
+  // A static, balanced tree.
+  struct Level {
+    std::vector<Entry> entries_;
+    std::vector<Node> nodes_;
+  };
+
+  // The best points found so far in a search, in the caller's buffers.
+  struct Result {
+    T* values_;
+    double* distances_;
+    size_t k_;
+    size_t count_;
+    double max_distance_;
+
+    // Whether a point (or subtree) at this distance could still make it in.
+    inline bool Admits(double distance) const {
+      return (count_ < k_) ? distance <= max_distance_ :
+        distance < distances_[k_ - 1];
+    }
+
+    // Insert a point, keeping the buffers sorted by distance.
+    inline void Offer(double distance, const T& value) {
+      if (!Admits(distance))
+        return;
+
+      size_t ii = (count_ < k_) ? count_++ : k_ - 1;
+      for (; ii > 0 && distances_[ii - 1] > distance; ii--) {
+        distances_[ii] = distances_[ii - 1];
+        values_[ii] = values_[ii - 1];
+      }
+
+      distances_[ii] = distance;
+      values_[ii] = value;
+    }
+  };
+
+  // Build the given level from its entries.
+  void Build(Level& level);
+  void Build(Level& level, size_t node, size_t lo, size_t hi);
+
+  // Search the subtree of the given level rooted at the given node, holding
+  // entries lo to hi, at least the given distance from the query.
+  void Search(const Level& level, size_t node, size_t lo, size_t hi,
+              const Vector3d& query, double bound, Result& result) const;
+
+  // Per-axis weights of the distance metric.
+  const Vector3d weights_;
+
+  // Points not yet in any level, and the levels themselves.
+  std::vector<Entry> buffer_;
+  std::vector<Level> levels_;
+
+  // Scratch space for merging levels, kept to reuse its memory.
+  std::vector<Entry> merged_;
+
+  size_t size_;
+};
+
+// ---------------------------- IMPLEMENTATION ------------------------------ //
+
+template<typename T>
+const size_t KdTree<T>::kLeafSize;
+
+// Insert a point with the given value.
+template<typename T>
+void KdTree<T>::Insert(const Vector3d& point, const T& value) {
+  buffer_.push_back({ point, value });
+  size_++;
+
+  if (buffer_.size() < kLeafSize)
+    return;
+
+  // Merge the buffer and every full level below the first empty one.
+  merged_.clear();
+  merged_.insert(merged_.end(), buffer_.begin(), buffer_.end());
+  buffer_.clear();
+
+  size_t ii = 0;
+  for (; ii < levels_.size() && !levels_[ii].entries_.empty(); ii++) {
+    merged_.insert(merged_.end(), levels_[ii].entries_.begin(),
+                   levels_[ii].entries_.end());
+    levels_[ii].entries_.clear();
+  }
+
+  if (ii == levels_.size())
+    levels_.emplace_back();
+
+  levels_[ii].entries_.swap(merged_);
+  Build(levels_[ii]);
+}
+
+// Remove all points.
+template<typename T>
+void KdTree<T>::Clear() {
+  buffer_.clear();
+  levels_.clear();
+  merged_.clear();
+  size_ = 0;
+}
+
+// Find the (at most) k nearest points within max_distance of the query.
+template<typename T>
+size_t KdTree<T>::KnnSearch(const Vector3d& query, size_t k,
+                            T* values, double* distances,
+                            double max_distance) const {
+  if (k == 0)
+    return 0;
+
+  Result result = { values, distances, k, 0, max_distance };
+
+  for (const auto& entry : buffer_)
+    result.Offer(Distance(entry.point_, query), entry.value_);
+
+  for (const auto& level : levels_) {
+    if (!level.entries_.empty())
+      Search(level, 1, 0, level.entries_.size(), query, 0.0, result);
+  }
+
+  return result.count_;
+}
+
+// Build the given level from its entries.
+template<typename T>
+void KdTree<T>::Build(Level& level) {
+  // A level of kLeafSize * 2^d entries has 2^d - 1 internal nodes.
+  level.nodes_.resize(std::max<size_t>(1, level.entries_.size() / kLeafSize));
+  Build(level, 1, 0, level.entries_.size());
+}
+
+template<typename T>
+void KdTree<T>::Build(Level& level, size_t node, size_t lo, size_t hi) {
+  if (hi - lo <= kLeafSize)
+    return;
+
+  // Split along the axis of widest (weighted) extent.
+  Vector3d lower = level.entries_[lo].point_;
+  Vector3d upper = lower;
+  for (size_t ii = lo + 1; ii < hi; ii++) {
+    lower = lower.cwiseMin(level.entries_[ii].point_);
+    upper = upper.cwiseMax(level.entries_[ii].point_);
+  }
+
+  size_t axis = 0;
+  (upper - lower).cwiseProduct(weights_).maxCoeff(&axis);
+
+  const size_t mid = lo + (hi - lo) / 2;
+  std::nth_element(level.entries_.begin() + lo,
+                   level.entries_.begin() + mid,
+                   level.entries_.begin() + hi,
+                   [axis](const Entry& a, const Entry& b) {
+                     return a.point_(axis) < b.point_(axis);
+                   });
+
+  level.nodes_[node] = { level.entries_[mid].point_(axis), axis };
+
+  Build(level, 2 * node, lo, mid);
+  Build(level, 2 * node + 1, mid, hi);
+}
+
+// Search the subtree of the given level rooted at the given node. Every
+// point in it is at least bound away from the query: under L-infinity, the
+// distance to a box is just the largest distance to any of its faces.
+template<typename T>
+void KdTree<T>::Search(const Level& level, size_t node, size_t lo, size_t hi,
+                       const Vector3d& query, double bound,
+                       Result& result) const {
+  if (hi - lo <= kLeafSize) {
+    for (size_t ii = lo; ii < hi; ii++)
+      result.Offer(Distance(level.entries_[ii].point_, query),
+                   level.entries_[ii].value_);
+    return;
+  }
+
+  const Node& split = level.nodes_[node];
+  const size_t mid = lo + (hi - lo) / 2;
+  const double offset =
+    (query(split.axis_) - split.split_) * weights_(split.axis_);
+
+  // Search the side containing the query first, then the other side if it
+  // could still hold anything closer.
+  const double far_bound = std::max(bound, std::abs(offset));
+  if (offset < 0.0) {
+    Search(level, 2 * node, lo, mid, query, bound, result);
+    if (result.Admits(far_bound))
+      Search(level, 2 * node + 1, mid, hi, query, far_bound, result);
+  } else {
+    Search(level, 2 * node + 1, mid, hi, query, bound, result);
+    if (result.Admits(far_bound))
+      Search(level, 2 * node, lo, mid, query, far_bound, result);
+  }
+}
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the LatticePlanner class, which inherits from Planner. It runs A*
+// over a 3D lattice anchored at the start point, moving between cells with a
+// precomputed MotionPrimitives library and guided by the best possible time
+// to the stop point. Moves are only collision checked when they would reach
+// a cell sooner than any move so far, and the number of expansions is capped,
+// so every call takes a bounded and repeatable amount of time. The stop point
+// is joined with a straight line from the cell containing it, or from any
+// cell next to that one.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_LATTICE_PLANNER_H
+#define META_PLANNER_LATTICE_PLANNER_H
+
+#include <meta_planner/planner.h>
+#include <meta_planner/motion_primitives.h>
+#include <meta_planner/box.h>
+#include <utils/types.h>
+
+#include <memory>
+#include <atomic>
+#include <vector>
+
+namespace meta {
+
+class LatticePlanner : public Planner {
+public:
+  ~LatticePlanner() {}
+
+  static Planner::Ptr Create(ValueFunctionId incoming_value,
+                             ValueFunctionId outgoing_value,
+                             const Box::ConstPtr& space,
+                             const Dynamics::ConstPtr& dynamics,
+                             const MotionPrimitives::ConstPtr& primitives,
+                             size_t max_expansions);
+
+  // Derived classes must plan trajectories between two points.
+  Trajectory::Ptr Plan(const Vector3d& start,
+                       const Vector3d& stop,
+                       double start_time = 0.0,
+                       double budget = 1.0) const;
+
+  // Same as above, but give up as soon as cancel becomes true.
+  Trajectory::Ptr Plan(const Vector3d& start,
+                       const Vector3d& stop,
+                       double start_time,
+                       double budget,
+                       const std::atomic<bool>& cancel) const;
+
+private:
+  explicit LatticePlanner(ValueFunctionId incoming_value,
+                          ValueFunctionId outgoing_value,
+                          const Box::ConstPtr& space,
+                          const Dynamics::ConstPtr& dynamics,
+                          const MotionPrimitives::ConstPtr& primitives,
+                          size_t max_expansions);
+
+  // Check the straight line from start (reached at start_time) to
+  // start + points[ii] at start_time + times[ii], for all ii.
+  bool IsValidMove(const Vector3d& start, double start_time,
+                   const std::vector<Vector3d>& points,
+                   const std::vector<double>& times) const;
+
+  // Motion primitives.
+  const MotionPrimitives::ConstPtr primitives_;
+
+  // Maximum number of cells to expand per call.
+  const size_t max_expansions_;
+};
+
+} //\namespace meta
+
+#endif
@@ -47,16 +47,26 @@
 
 #include <meta_planner/waypoint_tree.h>
 #include <meta_planner/waypoint.h>
+#include <meta_planner/frontier.h>
+#include <meta_planner/trajectory_monitor.h>
+#include <meta_planner/budget_scheduler.h>
 #include <meta_planner/ompl_planner.h>
+#include <meta_planner/straight_line_planner.h>
+#include <meta_planner/lattice_planner.h>
+#include <meta_planner/motion_primitives.h>
+#include <meta_planner/roadmap_planner.h>
 #include <meta_planner/environment.h>
+#include <meta_planner/halton_sequence.h>
 #include <value_function/near_hover_quad_no_yaw.h>
 #include <utils/types.h>
 #include <utils/uncopyable.h>
+#include <utils/thread_pool.h>
 #include <demo/balls_in_box.h>
 
 #include <meta_planner_msgs/Trajectory.h>
 #include <meta_planner_msgs/TrajectoryRequest.h>
 #include <meta_planner_msgs/SensorMeasurement.h>
+#include <meta_planner_msgs/BudgetStatistics.h>
 #include <crazyflie_msgs/PositionVelocityStateStamped.h>
 
 #include <value_function_srvs/TrackingBoundBox.h>
@@ -65,9 +75,21 @@
 #include <value_function_srvs/GuaranteedSwitchingDistance.h>
 
 #include <ros/ros.h>
+#include <ros/callback_queue.h>
 #include <std_msgs/Empty.h>
 #include <vector>
 #include <limits>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace meta {
 
@@ -75,7 +97,9 @@ class MetaPlanner : private Uncopyable {
 public:
   ~MetaPlanner() {}
   explicit MetaPlanner()
-    : in_flight_(false),
+    : sensor_spinner_(1, &sensor_queue_),
+      last_sensor_sequence_(0),
+      in_flight_(false),
       reached_goal_(false),
       been_updated_(false),
       initialized_(false) {}
@@ -92,7 +116,8 @@ private:
   void StateCallback(
     const crazyflie_msgs::PositionVelocityStateStamped::ConstPtr& msg);
 
-  // Callback for processing sensor measurements.
+  // Callback for processing sensor measurements. Runs on its own thread,
+  // so it must only touch the environment through its snapshot interface.
   void SensorCallback(
     const meta_planner_msgs::SensorMeasurement::ConstPtr& msg);
 
@@ -105,10 +130,145 @@ private:
   void RequestTrajectoryCallback(
     const meta_planner_msgs::TrajectoryRequest::ConstPtr& msg);
 
+  // Timer callback to grow the roadmaps, and now and then save them. Shares
+  // a queue with trajectory requests, so it only runs between them.
+  void GrowRoadmapsCallback(const ros::TimerEvent& e);
+
+  // Save every roadmap which has grown since it was last saved.
+  void SaveRoadmaps();
+
   // Plan a trajectory from the given start to stop points, beginning at the
-  // specified start time. Auto-publishes the result and returns whether
-  // meta planning was successful.
-  bool Plan(const Vector3d& start, const Vector3d& stop, double start_time);
+  // specified start time, until the given (absolute) deadline. Auto-publishes
+  // the result and returns whether meta planning was successful.
+  bool Plan(const Vector3d& start, const Vector3d& stop, double start_time,
+            double deadline);
+
+  // Publish a cheap answer without planning: the rest of the current
+  // trajectory if still collision free, or else a hover at the start.
+  // Returns whether anything was published.
+  bool FallBack(const Vector3d& start, double start_time);
+
+  // Hover at the given position from the given time on. Returns null if the
+  // switching time server is unavailable.
+  Trajectory::Ptr Hover(const Vector3d& position, double time);
+
+  // Graft whatever is still valid in the previous tree onto the given tree,
+  // and return the number of waypoints reused.
+  size_t ReusePreviousTree(WaypointTree& tree, const ObstacleStore& obstacles,
+                           const Vector3d& start, const Vector3d& stop,
+                           double start_time);
+
+  // Load the motion primitive library for a planner, or generate it (and
+  // try to save it for next time) if the saved one is missing or was made
+  // for a different configuration. Returns null if the planner's maximum
+  // speeds are unavailable.
+  MotionPrimitives::ConstPtr LoadMotionPrimitives(
+    const Planner::ConstPtr& planner) const;
+
+  // Check a trajectory against every obstacle in the given version, from
+  // the given time on.
+  bool IsClear(const Trajectory::ConstPtr& traj,
+               const ObstacleStore& obstacles, double from_time);
+
+  // Shorten a trajectory with straight lines, leaving it unchanged before
+  // the given time and never crossing a switch of value functions.
+  Trajectory::ConstPtr Shortcut(const Trajectory::ConstPtr& traj,
+                                double from_time);
+
+  // Check that a trajectory starts at the given start point and time, and
+  // agrees with the previously published trajectory (if any) up to now.
+  bool AgreesWithPrefix(const Trajectory::ConstPtr& traj,
+                        const Vector3d& start, double start_time,
+                        const Trajectory::ConstPtr& published) const;
+
+  // Try to grow the tree toward one random sample (or, in best-first mode,
+  // from the most promising waypoint toward the goal), and from there to the
+  // goal. In lazy mode, grow the lazy tree instead. Safe to call from
+  // multiple threads on the same tree. Returns false only if planning should
+  // stop altogether.
+  bool Expand(WaypointTree& tree, const Vector3d& start, const Vector3d& stop,
+              double start_time, HaltonSequence& sequence,
+              std::default_random_engine& rng, bool& reached_goal);
+
+  // Plan from a waypoint in the tree to the given sample, and from there to
+  // the goal, inserting whatever succeeds. Sets inserted to the new waypoint
+  // at the sample, or null if it could not be reached. Returns false only if
+  // planning should stop altogether.
+  bool Connect(WaypointTree& tree, Waypoint::ConstPtr neighbor,
+               const Vector3d& sample, const Vector3d& stop,
+               double start_time, Waypoint::ConstPtr& inserted,
+               bool& reached_goal);
+
+  // Lazy mode: add an unchecked straight-line edge from a waypoint in the
+  // lazy tree to the given sample (and from there to the goal, if close
+  // enough), and evaluate any candidate path to the goal that could beat the
+  // best trajectory in the tree. Returns false only if planning should stop
+  // altogether.
+  bool ExpandLazily(WaypointTree& tree, const Waypoint::ConstPtr& neighbor,
+                    const Vector3d& sample, const Vector3d& stop,
+                    double start_time, bool& reached_goal);
+
+  // Lazy mode: unchecked waypoint at the given point, reached from the given
+  // lazy waypoint as fast as the fastest planner could possibly go.
+  Waypoint::ConstPtr LazyWaypoint(const Vector3d& point,
+                                  const Waypoint::ConstPtr& parent,
+                                  double start_time) const;
+
+  // Lazy mode: plan each unchecked edge on the path to the given lazy
+  // waypoint at the goal for real, until one fails (which invalidates it
+  // and everything below it) or the path reaches the goal. Returns false
+  // only if planning should stop altogether.
+  bool EvaluateLazyPath(WaypointTree& tree, const Waypoint::ConstPtr& goal,
+                        const Vector3d& stop, double start_time,
+                        bool& reached_goal);
+
+  // Lazy mode: true if this lazy waypoint, or any unchecked waypoint above
+  // it, has been invalidated. Call with lazy_mutex_ held.
+  bool IsInvalidated(const Waypoint::ConstPtr& waypoint) const;
+
+  // Lower bound on the time to go from one point to another with any planner.
+  double LowerBoundTime(const Vector3d& from, const Vector3d& to) const;
+
+  // Add a waypoint to the frontier, ranked by its arrival time (since the
+  // start time) plus a lower bound on the time from there to the goal.
+  void PushFrontier(const Waypoint::ConstPtr& waypoint, const Vector3d& stop,
+                    double start_time);
+
+  // Plan from start to stop with each of the candidate planners (given by
+  // index, most aggressive first) at once, and return the result of the
+  // most aggressive one that succeeds, or null.
+  Trajectory::Ptr PlanInParallel(const std::vector<size_t>& candidates,
+                                 const Vector3d& start, const Vector3d& stop,
+                                 double start_time,
+                                 size_t& planner_used_id) const;
+
+  // Number of obstacles which come within the given distance of a point.
+  size_t NumNearbyObstacles(const Vector3d& point, double distance) const;
+
+  // Publish a new trajectory and start monitoring it for conflicts with
+  // sensed obstacles, including any sensed while it was being planned.
+  void PublishTrajectory(const Trajectory::ConstPtr& traj);
+
+  // Build a monitor for a trajectory. Returns null if any tracking bound
+  // is unavailable.
+  TrajectoryMonitor::ConstPtr Monitor(const Trajectory::ConstPtr& traj);
+
+  // Check a sensed obstacle against the monitored trajectory. Returns true,
+  // and reports the offending segment, if they conflict.
+  bool Conflicts(const TrajectoryMonitor& monitor,
+                 const Vector3d& point, double radius,
+                 const Vector3d& velocity, double stamp) const;
+
+  // Get the tracking bound of every value function from the server.
+  bool CacheTrackingBounds();
+
+  // Get the guaranteed switching distance of every planner from the server.
+  bool CacheSwitchingDistances();
+
+  // Get the tracking bound of a value function. Bounds never change, so
+  // they are all requested from the server up front, and lookups are read
+  // only and safe from any thread.
+  bool TrackingBound(ValueFunctionId value, Vector3d& bound) const;
 
   // Dynamics.
   NearHoverQuadNoYaw::ConstPtr dynamics_;
@@ -116,10 +276,70 @@ private:
   // Remember the last trajectory we sent.
   Trajectory::ConstPtr traj_;
 
+  // Monitor for the last trajectory we sent. Shared with the sensor thread,
+  // so only accessed through std::atomic_load/store.
+  TrajectoryMonitor::ConstPtr monitor_;
+
+  // Tree from the last plan, and the obstacles it was planned against.
+  WaypointTree::ConstPtr previous_tree_;
+  ObstacleStore::ConstPtr previous_obstacles_;
+
+  // Cache of tracking bounds, keyed on value function. Filled once in
+  // RegisterCallbacks and never modified afterward.
+  std::map<ValueFunctionId, Vector3d> tracking_bounds_;
+
+  // Cache of guaranteed switching distances, keyed on the (incoming,
+  // outgoing) value functions of each planner. Also filled once in
+  // RegisterCallbacks, so expansion workers can read it without locking.
+  std::map<std::pair<ValueFunctionId, ValueFunctionId>, Vector3d>
+    switching_distances_;
+
   // List of planners.
   std::vector<Planner::ConstPtr> planners_;
+
+  // Whether the planners above search a lattice of motion primitives
+  // instead of running BIT*, and the lattice configuration.
+  bool lattice_;
+  std::string lattice_directory_;
+  double lattice_resolution_;
+  size_t lattice_max_step_;
+  size_t lattice_max_expansions_;
+
+  // Number of BIT* instances to run at once on a single connection, and the
+  // smallest budget for which that is worth doing.
+  size_t threads_per_query_;
+  double parallel_min_budget_;
+
+  // Straight line planners, one per planner above, and whether to try them
+  // first. Also counts how many calls they resolved in the current episode.
+  bool straight_lines_enabled_;
+  std::vector<Planner::ConstPtr> straight_lines_;
+  mutable std::atomic<size_t> num_calls_;
+  mutable std::atomic<size_t> num_straight_lines_;
   size_t num_value_functions_;
 
+  // Persistent roadmaps, one per planner above, to try after the straight
+  // line and before the planner itself. Also the files they are saved in,
+  // their sizes when last saved, and how many calls they resolved in the
+  // current episode.
+  bool roadmaps_enabled_;
+  std::vector<RoadmapPlanner::Ptr> roadmaps_;
+  std::vector<std::string> roadmap_files_;
+  std::vector<size_t> roadmap_saved_sizes_;
+  double roadmap_saved_time_;
+  std::string roadmap_directory_;
+  size_t roadmap_max_vertices_;
+  ros::Timer roadmap_timer_;
+  double roadmap_grow_period_;
+  mutable std::atomic<size_t> num_roadmap_paths_;
+
+  // Workers for expanding the tree and for running planners concurrently,
+  // and one random engine per expansion worker (which seeds its sequence).
+  size_t num_threads_;
+  std::unique_ptr<ThreadPool> expansion_pool_;
+  std::unique_ptr<ThreadPool> planner_pool_;
+  std::vector<std::default_random_engine> rngs_;
+
   // Geometric goal point.
   Vector3d goal_;
 
@@ -141,8 +361,59 @@ private:
   // Max time to spend searching for an optimal path.
   double max_runtime_;
 
-  // Maximum distance between waypoints.
+  // Chooses the time budget for each planner call, and the file in which
+  // its statistics persist across runs.
+  BudgetScheduler::Ptr budgets_;
+  std::string budget_file_;
+
+  // Anytime mode: publish each improvement as soon as it is found. Stop
+  // early once within this fraction of the lower bound on trajectory time.
+  bool anytime_;
+  double optimality_gap_;
+
+  // Deadline mode: plan until the requested start time less a margin for
+  // publishing, and fall back right away if less than the minimum slack
+  // remains. The deadline of the current episode is in absolute seconds.
+  bool deadline_mode_;
+  double publish_margin_;
+  double min_slack_;
+  double deadline_;
+
+  // Whether to shortcut trajectories before publishing them, and a random
+  // engine for doing so on the planning thread.
+  bool shortcut_;
+  std::default_random_engine shortcut_rng_;
+
+  // Maximum speeds of the fastest planner, for informed sampling, and
+  // whether they were available for the current episode.
+  Vector3d max_speed_;
+  bool informed_;
+
+  // Maximum distance between waypoints, under the weighted L-infinity metric
+  // of the waypoint trees, whose per-axis weights are set for each episode.
   double max_connection_radius_;
+  Vector3d metric_weights_;
+
+  // Best-first mode: expand the most promising waypoints in the frontier,
+  // except for this fraction of expansions, which sample at random as usual.
+  bool best_first_;
+  double random_fraction_;
+  Frontier::Ptr frontier_;
+
+  // Lazy mode: grow a tree of unchecked straight-line edges, and only plan
+  // the edges on candidate paths to the goal. The lazy tree holds every
+  // waypoint of the real tree as well, and each lazy waypoint maps to the
+  // real one it was evaluated as (if any). Waypoints on edges which failed,
+  // lazy waypoints at the goal still to be evaluated, and counts of edges
+  // inserted and evaluated are kept for the current episode.
+  bool lazy_;
+  WaypointTree::Ptr lazy_tree_;
+  std::unordered_map<const Waypoint*, Waypoint::ConstPtr> realized_;
+  std::unordered_set<const Waypoint*> invalidated_;
+  std::vector<Waypoint::ConstPtr> lazy_goals_;
+  mutable std::mutex lazy_mutex_;
+  std::atomic<size_t> num_lazy_edges_;
+  std::atomic<size_t> num_evaluated_edges_;
 
   // Services and names.
   ros::ServiceClient bound_srv_;
@@ -155,10 +426,15 @@ private:
   std::string switching_time_name_;
   std::string switching_distance_name_;
 
+  // Serializes use of the service clients above during planning. Only
+  // needed to retime trajectories when backtracking.
+  std::mutex srv_mutex_;
+
   // Publishers/subscribers and related topics.
   ros::Publisher traj_pub_;
   ros::Publisher env_pub_;
   ros::Publisher trigger_replan_pub_;
+  ros::Publisher budget_pub_;
   ros::Subscriber state_sub_;
   ros::Subscriber sensor_sub_;
   ros::Subscriber request_traj_sub_;
@@ -171,12 +447,21 @@ private:
   std::string request_traj_topic_;
   std::string trigger_replan_topic_;
   std::string in_flight_topic_;
+  std::string budget_topic_;
+
+  // Sensor measurements are processed on their own thread, concurrently
+  // with planning.
+  ros::CallbackQueue sensor_queue_;
+  ros::AsyncSpinner sensor_spinner_;
+
+  // Sequence number of the last sensor message, to detect missed updates.
+  uint64_t last_sensor_sequence_;
 
   // Frames.
   std::string fixed_frame_id_;
 
   // Are we in flight?
-  bool in_flight_;
+  std::atomic<bool> in_flight_;
 
   // Have we reached the goal?
   bool reached_goal_;
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the MotionPrimitives class, a library of straight moves between
+// cells of a uniform 3D lattice for one planner's maximum speeds. Each
+// primitive stores its offset in cells, how long it takes at full speed, and
+// the points (relative to its start) at which it must be collision checked.
+// Libraries are generated offline and saved to a binary file, so that
+// planners only need to load them at startup.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_MOTION_PRIMITIVES_H
+#define META_PLANNER_MOTION_PRIMITIVES_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace meta {
+
+class MotionPrimitives : private Uncopyable {
+public:
+  typedef std::shared_ptr<MotionPrimitives> Ptr;
+  typedef std::shared_ptr<const MotionPrimitives> ConstPtr;
+
+  // One straight move on the lattice.
+  struct Primitive {
+    // Offset in cells.
+    std::array<int, 3> offset_;
+
+    // Displacement in meters and time to traverse it at full speed.
+    Vector3d displacement_;
+    double duration_;
+
+    // Collision check points relative to the start of the move, and the
+    // times at which they are reached. The last point is the end of the move.
+    std::vector<Vector3d> points_;
+    std::vector<double> times_;
+  };
+
+  // Destructor.
+  ~MotionPrimitives() {}
+
+  // Factory method. Generates every move to a cell at most max_step cells
+  // away along each axis which is not a repeat of a shorter move, for a
+  // lattice with the given cell size (meters). Collision check points are
+  // no more than half a cell apart.
+  static Ptr Create(const Vector3d& max_speed, double resolution,
+                    size_t max_step);
+
+  // Load a library from a file. Returns null if the file could not be read.
+  static Ptr Load(const std::string& file_name);
+
+  // Save to a file.
+  bool Save(const std::string& file_name) const;
+
+  // Check if this library was generated for the given configuration.
+  bool Matches(const Vector3d& max_speed, double resolution,
+               size_t max_step) const;
+
+  // Accessors.
+  inline const std::vector<Primitive>& Primitives() const {
+    return primitives_;
+  }
+  inline const Vector3d& MaxSpeed() const { return max_speed_; }
+  inline double Resolution() const { return resolution_; }
+  inline size_t MaxStep() const { return max_step_; }
+  inline size_t Size() const { return primitives_.size(); }
+
+  // Shortest possible time between two points, i.e. the weighted
+  // L-infinity distance under the maximum speeds.
+  inline double BestPossibleTime(const Vector3d& start,
+                                 const Vector3d& stop) const {
+    return (stop - start).cwiseAbs().cwiseQuotient(max_speed_).maxCoeff();
+  }
+
+private:
+  explicit MotionPrimitives(const Vector3d& max_speed, double resolution,
+                            size_t max_step);
+
+  // Fill in displacement, duration, and collision check points for a
+  // primitive whose offset has been set.
+  void Complete(Primitive& primitive) const;
+
+  // Configuration.
+  const Vector3d max_speed_;
+  const double resolution_;
+  const size_t max_step_;
+
+  // Primitives, sorted by duration.
+  std::vector<Primitive> primitives_;
+};
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ObstacleAwareInformedSampler class, an OMPL InformedSampler
+// which draws from the state space's own sampler (as installed with
+// setStateSamplerAllocator, i.e. an ObstacleAwareSampler) and rejects samples
+// which cannot lie on a solution better than the given cost. OMPL's own
+// RejectionInfSampler and PathLengthDirectInfSampler always start from the
+// space's default sampler, so optimization objectives which hand them out
+// would bypass the obstacle aware sampler entirely.
+//
+// Also defines ObstacleAwarePathLengthObjective, a path length objective
+// which hands out this sampler.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_OBSTACLE_AWARE_INFORMED_SAMPLER_H
+#define META_PLANNER_OBSTACLE_AWARE_INFORMED_SAMPLER_H
+
+#include <ompl/base/samplers/InformedStateSampler.h>
+#include <ompl/base/objectives/PathLengthOptimizationObjective.h>
+#include <ompl/base/ProblemDefinition.h>
+#include <ompl/base/StateSampler.h>
+#include <memory>
+
+namespace meta {
+
+namespace ob = ompl::base;
+
+class ObstacleAwareInformedSampler : public ob::InformedSampler {
+public:
+  explicit ObstacleAwareInformedSampler(const ob::ProblemDefinitionPtr& problem,
+                                        unsigned int max_calls)
+    : ob::InformedSampler(problem, max_calls),
+      sampler_(problem->getSpaceInformation()->allocStateSampler()) {}
+
+  ~ObstacleAwareInformedSampler() {}
+
+  // Sample until a state is found whose best possible solution is better
+  // than max_cost, giving up after the maximum number of calls.
+  bool sampleUniform(ob::State* state, const ob::Cost& max_cost);
+
+  // Same as above, but the best possible solution must also be no better
+  // than min_cost.
+  bool sampleUniform(ob::State* state, const ob::Cost& min_cost,
+                     const ob::Cost& max_cost);
+
+  // Rejection sampling has no closed form for the informed subset, so its
+  // measure is that of the whole state space.
+  bool hasInformedMeasure() const { return false; }
+  double getInformedMeasure(const ob::Cost& current_cost) const {
+    return space_->getMeasure();
+  }
+  using ob::InformedSampler::getInformedMeasure;
+
+private:
+  // The state space's own sampler.
+  const ob::StateSamplerPtr sampler_;
+};
+
+// Path length objective whose informed sampler draws from the state space's
+// own sampler, for when OmplPlanner cannot optimize time.
+class ObstacleAwarePathLengthObjective :
+    public ob::PathLengthOptimizationObjective {
+public:
+  explicit ObstacleAwarePathLengthObjective(const ob::SpaceInformationPtr& si)
+    : ob::PathLengthOptimizationObjective(si) {}
+
+  ~ObstacleAwarePathLengthObjective() {}
+
+  // Informed sampler for BIT* and other informed planners.
+  ob::InformedSamplerPtr allocInformedStateSampler(
+    const ob::ProblemDefinitionPtr& problem, unsigned int max_calls) const {
+    return std::make_shared<ObstacleAwareInformedSampler>(problem, max_calls);
+  }
+};
+
+// ------------------------------- IMPLEMENTATION --------------------------- //
+
+// Sample until a state is found whose best possible solution is better than
+// max_cost, giving up after the maximum number of calls.
+inline bool ObstacleAwareInformedSampler::
+sampleUniform(ob::State* state, const ob::Cost& max_cost) {
+  for (unsigned int ii = 0; ii < numIters_; ii++) {
+    sampler_->sampleUniform(state);
+
+    if (opt_->isCostBetterThan(heuristicSolnCost(state), max_cost))
+      return true;
+  }
+
+  return false;
+}
+
+// Same as above, but the best possible solution must also be no better than
+// min_cost.
+inline bool ObstacleAwareInformedSampler::
+sampleUniform(ob::State* state, const ob::Cost& min_cost,
+              const ob::Cost& max_cost) {
+  for (unsigned int ii = 0; ii < numIters_; ii++) {
+    sampler_->sampleUniform(state);
+
+    const ob::Cost cost = heuristicSolnCost(state);
+    if (opt_->isCostBetterThan(cost, max_cost) &&
+        !opt_->isCostBetterThan(cost, min_cost))
+      return true;
+  }
+
+  return false;
+}
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ObstacleAwareSampler class, an OMPL StateSampler for R^3 which
+// divides the bounds into a coarse grid and only samples from cells which
+// the environment cannot rule out entirely (e.g. because they lie inside an
+// inflated obstacle). The grid is rebuilt whenever the version of the
+// environment seen by collision checks changes.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_OBSTACLE_AWARE_SAMPLER_H
+#define META_PLANNER_OBSTACLE_AWARE_SAMPLER_H
+
+#include <meta_planner/environment.h>
+#include <utils/types.h>
+
+#include <ompl/base/StateSampler.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ros/ros.h>
+#include <stdint.h>
+#include <vector>
+
+namespace meta {
+
+namespace ob = ompl::base;
+
+class ObstacleAwareSampler : public ob::RealVectorStateSampler {
+public:
+  // Number of grid cells along each axis.
+  static const size_t kCellsPerAxis = 10;
+
+  explicit ObstacleAwareSampler(const ob::StateSpace* state_space,
+                                const Environment* space,
+                                ValueFunctionId incoming_value,
+                                ValueFunctionId outgoing_value);
+
+  ~ObstacleAwareSampler() {}
+
+  // Sample uniformly from the cells which have not been ruled out. Other
+  // kinds of samples are drawn from the whole state space, as usual.
+  void sampleUniform(ob::State* state);
+
+private:
+  // Rebuild the list of cells which have not been ruled out, if the
+  // environment has changed since it was last built.
+  void Update();
+
+  // Environment and value functions used for ruling out cells.
+  const Environment* space_;
+  const ValueFunctionId incoming_value_;
+  const ValueFunctionId outgoing_value_;
+
+  // Grid origin and cell size.
+  Vector3d lower_;
+  Vector3d cell_size_;
+
+  // Indices of cells which have not been ruled out, and the environment
+  // version they were computed for.
+  std::vector<size_t> free_cells_;
+  uint64_t version_;
+  bool built_;
+};
+
+// ------------------------------- IMPLEMENTATION --------------------------- //
+
+inline ObstacleAwareSampler::
+ObstacleAwareSampler(const ob::StateSpace* state_space,
+                     const Environment* space,
+                     ValueFunctionId incoming_value,
+                     ValueFunctionId outgoing_value)
+  : ob::RealVectorStateSampler(state_space),
+    space_(space),
+    incoming_value_(incoming_value),
+    outgoing_value_(outgoing_value),
+    version_(0),
+    built_(false) {
+  const ob::RealVectorBounds& bounds =
+    state_space->as<ob::RealVectorStateSpace>()->getBounds();
+
+  for (size_t ii = 0; ii < 3; ii++) {
+    lower_(ii) = bounds.low[ii];
+    cell_size_(ii) = (bounds.high[ii] - bounds.low[ii]) / kCellsPerAxis;
+  }
+}
+
+// Sample uniformly from the cells which have not been ruled out. All cells
+// have the same volume, so picking one uniformly and then a point uniformly
+// within it is uniform over their union.
+inline void ObstacleAwareSampler::sampleUniform(ob::State* state) {
+  Update();
+
+  // If everything has been ruled out, there is nowhere better to look.
+  if (free_cells_.empty()) {
+    ob::RealVectorStateSampler::sampleUniform(state);
+    return;
+  }
+
+  size_t cell = free_cells_[
+    rng_.uniformInt(0, static_cast<int>(free_cells_.size()) - 1)];
+
+  double* values =
+    state->as<ob::RealVectorStateSpace::StateType>()->values;
+  for (size_t ii = 0; ii < 3; ii++) {
+    const size_t index = cell % kCellsPerAxis;
+    cell /= kCellsPerAxis;
+
+    values[ii] = lower_(ii) +
+      (static_cast<double>(index) + rng_.uniform01()) * cell_size_(ii);
+  }
+}
+
+// Rebuild the list of cells which have not been ruled out, if the
+// environment has changed since it was last built.
+inline void ObstacleAwareSampler::Update() {
+  const uint64_t version = space_->CheckedVersion();
+  if (built_ && version == version_)
+    return;
+
+  free_cells_.clear();
+  for (size_t kk = 0; kk < kCellsPerAxis; kk++) {
+    for (size_t jj = 0; jj < kCellsPerAxis; jj++) {
+      for (size_t ii = 0; ii < kCellsPerAxis; ii++) {
+        const Vector3d lower = lower_ + Vector3d(
+          ii * cell_size_(0), jj * cell_size_(1), kk * cell_size_(2));
+
+        if (!space_->IsBlocked(lower, lower + cell_size_,
+                               incoming_value_, outgoing_value_))
+          free_cells_.push_back(
+            ii + kCellsPerAxis * (jj + kCellsPerAxis * kk));
+      }
+    }
+  }
+
+  version_ = version;
+  built_ = true;
+
+#ifdef ENABLE_DEBUG_MESSAGES
+  ROS_INFO_THROTTLE(10.0, "Sampling from %zu of %zu cells.",
+                    free_cells_.size(),
+                    kCellsPerAxis * kCellsPerAxis * kCellsPerAxis);
+#endif
+}
+
+} //\namespace meta
+
+#endif
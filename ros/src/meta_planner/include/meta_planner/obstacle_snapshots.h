@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ObstacleSnapshots class, which publishes immutable, versioned
+// ObstacleStores. Writers copy the current store, edit the copy, and swap
+// it in atomically, so readers never see a torn obstacle list and never
+// wait on a writer. A reader may also pin one version (e.g. for a whole
+// planning episode) so that every query it makes sees the same obstacles.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_OBSTACLE_SNAPSHOTS_H
+#define META_PLANNER_OBSTACLE_SNAPSHOTS_H
+
+#include <meta_planner/obstacle_store.h>
+#include <utils/uncopyable.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace meta {
+
+class ObstacleSnapshots : private Uncopyable {
+public:
+  explicit ObstacleSnapshots()
+    : current_(ObstacleStore::Create()) {}
+  ~ObstacleSnapshots() {}
+
+  // Latest published version.
+  inline ObstacleStore::ConstPtr Current() const {
+    return std::atomic_load(&current_);
+  }
+
+  // Version to use for collision checking: the pinned version if there is
+  // one, otherwise the latest.
+  inline ObstacleStore::ConstPtr Get() const {
+    return (pinned_ != nullptr) ? pinned_ : Current();
+  }
+
+  // Copy the latest version, apply 'edit' to the copy, and publish it as
+  // the next version if 'edit' returns true. Writers are serialized with
+  // each other but never block readers. Returns the latest version number.
+  template<typename EditFunction>
+  uint64_t Update(EditFunction edit);
+
+  // Pin the latest version until Unpin() is called, and return its version
+  // number. Pinning is not thread safe with respect to readers of Get(), so
+  // it should only be done by the thread that owns those readers, before
+  // they start and after they finish.
+  inline uint64_t Pin() const {
+    pinned_ = Current();
+    return pinned_->Version();
+  }
+
+  inline void Unpin() const { pinned_.reset(); }
+
+private:
+  // Latest version. Only ever accessed through std::atomic_load/store.
+  ObstacleStore::ConstPtr current_;
+
+  // Pinned version, if any.
+  mutable ObstacleStore::ConstPtr pinned_;
+
+  // Serializes writers.
+  std::mutex write_mutex_;
+};
+
+// ---------------------------- IMPLEMENTATION ------------------------------ //
+
+// Copy the latest version, apply 'edit' to the copy, and publish it as the
+// next version if 'edit' returns true.
+template<typename EditFunction>
+inline uint64_t ObstacleSnapshots::Update(EditFunction edit) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+
+  const ObstacleStore::ConstPtr current = Current();
+  const ObstacleStore::Ptr next = current->Clone();
+
+  if (!edit(*next))
+    return current->Version();
+
+  next->version_ = current->Version() + 1;
+  std::atomic_store(&current_, ObstacleStore::ConstPtr(next));
+  return next->version_;
+}
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ObstacleStore class, which holds a set of spherical obstacles
+// in structure-of-arrays form (separate x, y, z, and radius arrays). Arrays
+// are 32-byte aligned and padded to a multiple of the SIMD width with
+// sentinel obstacles that can never collide, so that collision checks can
+// run over blocks of query points (or blocks of obstacles) with AVX2.
+//
+// Each obstacle also carries a constant velocity and the time stamp at which
+// its position was measured, so that it can be checked at future times. To
+// keep those checks cheap, the store can index the volumes swept out by all
+// obstacles over a prediction horizon, split into short time bins.
+//
+// Every obstacle has a stable ID, which may be assigned by whoever sensed it,
+// and can be looked up by ID in constant time.
+//
+// Once published through ObstacleSnapshots a store is never modified again;
+// writers Clone() it, edit the copy, and publish that as the next version.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_OBSTACLE_STORE_H
+#define META_PLANNER_OBSTACLE_STORE_H
+
+#include <utils/types.h>
+#include <utils/aligned_allocator.h>
+
+#include <ros/ros.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+namespace meta {
+
+class ObstacleStore {
+public:
+  typedef std::shared_ptr<ObstacleStore> Ptr;
+  typedef std::shared_ptr<const ObstacleStore> ConstPtr;
+
+  // Number of doubles in one AVX2 register.
+  static const size_t kNumLanes = 4;
+
+  // Factory method. Use this instead of the constructor.
+  static Ptr Create();
+
+  // Destructor.
+  ~ObstacleStore() {}
+
+  // Deep copy of this store, with the same version number.
+  Ptr Clone() const;
+
+  // Version number assigned when this store was published.
+  inline uint64_t Version() const { return version_; }
+
+  // Add a spherical obstacle, optionally moving at constant velocity from
+  // the given point, which was measured at the given time stamp. Assigns
+  // the next unused ID.
+  void Add(const Vector3d& point, double radius,
+           const Vector3d& velocity = Vector3d::Zero(), double stamp = 0.0);
+
+  // Same as above, but with the given ID, which must not already be in use.
+  void Add(uint64_t id, const Vector3d& point, double radius,
+           const Vector3d& velocity = Vector3d::Zero(), double stamp = 0.0);
+
+  // Remove an obstacle. The last obstacle takes its place, so indices (but
+  // not IDs) of other obstacles may change.
+  void Remove(size_t ii);
+
+  // Index of the obstacle with the given ID, or -1 if there is none.
+  inline int Find(uint64_t id) const {
+    const auto iter = index_.find(id);
+    return (iter == index_.end()) ? -1 : static_cast<int>(iter->second);
+  }
+
+  // Move an existing obstacle.
+  void SetPoint(size_t ii, const Vector3d& point);
+
+  // Update the motion model of an existing obstacle.
+  void SetMotion(size_t ii, const Vector3d& point,
+                 const Vector3d& velocity, double stamp);
+
+  // Index the volumes swept out by all obstacles over the time interval
+  // [start, start + horizon], in bins of length bin_dt. Any subsequent edit
+  // drops the index.
+  void BuildSweptIndex(double start, double horizon, double bin_dt);
+
+  // Accessors.
+  inline size_t Size() const { return size_; }
+  inline Vector3d Point(size_t ii) const {
+    return Vector3d(xs_[ii], ys_[ii], zs_[ii]);
+  }
+  inline double Radius(size_t ii) const { return rs_[ii]; }
+  inline Vector3d Velocity(size_t ii) const {
+    return Vector3d(vxs_[ii], vys_[ii], vzs_[ii]);
+  }
+  inline double Stamp(size_t ii) const { return ts_[ii]; }
+  inline uint64_t Id(size_t ii) const { return ids_[ii]; }
+  inline bool IsMoving() const { return num_moving_ > 0; }
+
+  // Predicted position of an obstacle at the given time.
+  inline Vector3d PointAt(size_t ii, double time) const {
+    return Point(ii) + (time - ts_[ii]) * Velocity(ii);
+  }
+
+  // Check a block of at most kNumLanes query points against every obstacle.
+  // Each query point is surrounded by an axis-aligned box with the given half
+  // widths (the tracking bound). Entries of 'valid' which are false on input
+  // are not checked; entries which collide with an obstacle are set to false.
+  void CheckBlock(const Vector3d* points, size_t num_points,
+                  const Vector3d& bound, bool* valid) const;
+
+  // Check a single point against every obstacle. Returns true if collision
+  // free. Obstacles are processed kNumLanes at a time.
+  bool CheckPoint(const Vector3d& point, const Vector3d& bound) const;
+
+  // Check a single point against every obstacle's predicted position at the
+  // given time. Returns true if collision free. If the swept volume index
+  // covers this time and its bin is clear, the exact check is skipped.
+  bool CheckPoint(const Vector3d& point, double time,
+                  const Vector3d& bound) const;
+
+  // Check whether a single obstacle collides with every query point in the
+  // axis-aligned box from lower to upper, with query points surrounded by
+  // boxes as above. Used to rule out whole regions when sampling.
+  bool CoversBox(const Vector3d& lower, const Vector3d& upper,
+                 const Vector3d& bound) const;
+
+private:
+  friend class ObstacleSnapshots;
+
+  explicit ObstacleStore()
+    : size_(0),
+      num_moving_(0),
+      next_id_(0),
+      swept_start_(0.0),
+      swept_bin_dt_(0.0),
+      version_(0) {}
+
+  // Pad arrays up to the next multiple of kNumLanes with sentinels.
+  void Pad();
+
+  // Obstacle centers and radii. Only the first size_ entries are real.
+  AlignedVector<double> xs_;
+  AlignedVector<double> ys_;
+  AlignedVector<double> zs_;
+  AlignedVector<double> rs_;
+  size_t size_;
+
+  // Obstacle velocities and the time stamps of their measured positions.
+  AlignedVector<double> vxs_;
+  AlignedVector<double> vys_;
+  AlignedVector<double> vzs_;
+  AlignedVector<double> ts_;
+  size_t num_moving_;
+
+  // Obstacle IDs, and the index of each ID.
+  std::vector<uint64_t> ids_;
+  std::unordered_map<uint64_t, size_t> index_;
+  uint64_t next_id_;
+
+  // Swept volume index. Bin kk is a static store holding one bounding sphere
+  // per obstacle for the interval starting at swept_start_ + kk * bin_dt.
+  std::vector<ConstPtr> swept_bins_;
+  double swept_start_;
+  double swept_bin_dt_;
+
+  // Version number.
+  uint64_t version_;
+};
+
+} //\namespace meta
+
+#endif
@@ -42,7 +42,18 @@
 // an instance of the Box subclass of Environment.
 //
 // We follow these ( http://ompl.kavrakilab.org/geometricPlanningSE3.html )
-// instructions for using OMPL geometric planners.
+// instructions for using OMPL geometric planners. OMPL plans geometrically,
+// so solutions are re-checked against moving obstacles at their time stamps.
+// Optimizing planners minimize trajectory time rather than path length.
+//
+// The OMPL state space, setup, and planner are built once and reused for
+// every query; they are only rebuilt if the environment's bounds change.
+// Concurrent queries each take their own setup from a pool.
+//
+// Queries with a large enough budget may be split across several independent
+// planner instances on separate threads, each with its own setup (and so its
+// own collision checking state). All of them stop as soon as any finds a
+// solution, and the cheapest solution found is used.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -51,7 +62,12 @@
 
 #include <meta_planner/planner.h>
 #include <meta_planner/box.h>
+#include <meta_planner/batch_motion_validator.h>
+#include <meta_planner/obstacle_aware_sampler.h>
+#include <meta_planner/obstacle_aware_informed_sampler.h>
+#include <meta_planner/time_optimization_objective.h>
 #include <utils/types.h>
+#include <utils/thread_pool.h>
 
 #include <ompl/geometric/planners/rrt/RRTConnect.h>
 #include <ompl/geometric/planners/bitstar/BITstar.h>
@@ -60,7 +76,15 @@
 #include <ompl/base/TypedSpaceInformation.h>
 #include <ompl/base/SpaceInformation.h>
 #include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/base/PlannerTerminationCondition.h>
 #include <memory>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <algorithm>
+#include <limits>
 
 namespace meta {
 
@@ -72,10 +96,14 @@ class OmplPlanner : public Planner {
 public:
   ~OmplPlanner() {}
 
+  // Factory method. Queries with a budget of at least min_parallel_budget
+  // (seconds) run num_threads planner instances at once.
   static Planner::Ptr Create(ValueFunctionId incoming_value,
                              ValueFunctionId outgoing_value,
                              const Box::ConstPtr& space,
-                             const Dynamics::ConstPtr& dynamics);
+                             const Dynamics::ConstPtr& dynamics,
+                             size_t num_threads = 1,
+                             double min_parallel_budget = 0.0);
 
   // Derived classes must plan trajectories between two points.
   Trajectory::Ptr Plan(const Vector3d& start,
@@ -83,14 +111,59 @@ public:
                        double start_time = 0.0,
                        double budget = 1.0) const;
 
+  // Same as above, but stop solving as soon as cancel becomes true.
+  Trajectory::Ptr Plan(const Vector3d& start,
+                       const Vector3d& stop,
+                       double start_time,
+                       double budget,
+                       const std::atomic<bool>& cancel) const;
+
 private:
   explicit OmplPlanner(ValueFunctionId incoming_value,
                        ValueFunctionId outgoing_value,
                        const Box::ConstPtr& space,
-                       const Dynamics::ConstPtr& dynamics);
+                       const Dynamics::ConstPtr& dynamics,
+                       size_t num_threads,
+                       double min_parallel_budget);
 
   // Convert between OMPL states and Vector3ds.
   Vector3d FromOmplState(const ob::State* state) const;
+
+  // Persistent OMPL setup, and the bounds it was built for. Each query
+  // in flight needs its own.
+  struct Context {
+    std::shared_ptr<ob::RealVectorStateSpace> space_;
+    std::shared_ptr<og::SimpleSetup> setup_;
+    Vector3d lower_;
+    Vector3d upper_;
+  };
+
+  // Build the OMPL state space, setup, and planner for the current bounds
+  // of the environment.
+  void Configure(Context& context) const;
+
+  // Get a context ready to solve a query from start to stop.
+  void Prepare(Context& context, const Vector3d& start,
+               const Vector3d& stop) const;
+
+  // Take an idle context, or create one if none are idle. The context
+  // returns to the pool when released.
+  std::shared_ptr<Context> Acquire() const;
+
+  // Idle contexts.
+  mutable std::vector< std::unique_ptr<Context> > contexts_;
+  mutable std::mutex contexts_mutex_;
+
+  // Total time spent setting up queries, and number of queries.
+  // Guarded by contexts_mutex_.
+  mutable double setup_time_;
+  mutable size_t num_queries_;
+
+  // Number of planner instances per large query, the smallest budget which
+  // counts as large, and workers for all but the first instance.
+  const size_t num_threads_;
+  const double min_parallel_budget_;
+  std::unique_ptr<ThreadPool> helpers_;
 };
 
 // ------------------------------- IMPLEMENTATION --------------------------- //
@@ -99,8 +172,17 @@ template<typename PlannerType>
 OmplPlanner<PlannerType>::OmplPlanner(ValueFunctionId incoming_value,
                                       ValueFunctionId outgoing_value,
                                       const Box::ConstPtr& space,
-                                      const Dynamics::ConstPtr& dynamics)
-  : Planner(incoming_value, outgoing_value, space, dynamics) {}
+                                      const Dynamics::ConstPtr& dynamics,
+                                      size_t num_threads,
+                                      double min_parallel_budget)
+  : Planner(incoming_value, outgoing_value, space, dynamics),
+    setup_time_(0.0),
+    num_queries_(0),
+    num_threads_(std::max<size_t>(num_threads, 1)),
+    min_parallel_budget_(min_parallel_budget) {
+  if (num_threads_ > 1)
+    helpers_.reset(new ThreadPool(num_threads_ - 1));
+}
 
 // Create OmplPlanner pointer.
 template<typename PlannerType>
@@ -108,9 +190,12 @@ inline Planner::Ptr OmplPlanner<PlannerType>::
 Create(ValueFunctionId incoming_value,
        ValueFunctionId outgoing_value,
        const Box::ConstPtr& space,
-       const Dynamics::ConstPtr& dynamics) {
+       const Dynamics::ConstPtr& dynamics,
+       size_t num_threads,
+       double min_parallel_budget) {
   Planner::Ptr ptr(new OmplPlanner<PlannerType>(
-    incoming_value, outgoing_value, space, dynamics));
+    incoming_value, outgoing_value, space, dynamics,
+    num_threads, min_parallel_budget));
   return ptr;
 }
 
@@ -119,6 +204,16 @@ template<typename PlannerType>
 Trajectory::Ptr OmplPlanner<PlannerType>::
 Plan(const Vector3d& start, const Vector3d& stop,
      double start_time, double budget) const {
+  const std::atomic<bool> never(false);
+  return Plan(start, stop, start_time, budget, never);
+}
+
+// Same as above, but stop solving as soon as cancel becomes true.
+template<typename PlannerType>
+Trajectory::Ptr OmplPlanner<PlannerType>::
+Plan(const Vector3d& start, const Vector3d& stop,
+     double start_time, double budget,
+     const std::atomic<bool>& cancel) const {
   // Check that both start and stop are in bounds.
   if (!space_->IsValid(start, incoming_value_, outgoing_value_)) {
     ROS_WARN_THROTTLE(1.0, "Start point was in collision or out of bounds.");
@@ -130,49 +225,89 @@ Plan(const Vector3d& start, const Vector3d& stop,
     return nullptr;
   }
 
-  // Create the OMPL state space corresponding to this environment.
-  auto ompl_space(
-    std::make_shared<ob::RealVectorStateSpace>(3));
-
-  // Set bounds for the environment.
-  const Vector3d lower = space_->LowerBounds();
-  const Vector3d upper = space_->UpperBounds();
+  // Split large queries across several planner instances.
+  const size_t num_instances =
+    (budget >= min_parallel_budget_) ? num_threads_ : 1;
 
-  ob::RealVectorBounds ompl_bounds(3);
-
-  for (size_t ii = 0; ii < 3; ii++) {
-    ompl_bounds.setLow(ii, lower(ii));
-    ompl_bounds.setHigh(ii, upper(ii));
+  std::vector< std::shared_ptr<Context> > contexts;
+  const auto setup_start = std::chrono::steady_clock::now();
+  for (size_t ii = 0; ii < num_instances; ii++) {
+    contexts.push_back(Acquire());
+    Prepare(*contexts.back(), start, stop);
   }
 
-  ompl_space->setBounds(ompl_bounds);
-
-  // Create a SimpleSetup instance and set the state validity checker function.
-  og::SimpleSetup ompl_setup(ompl_space);
-  ompl_setup.setStateValidityChecker([&](const ob::State* state) {
-      return space_->IsValid(FromOmplState(state),
-                             incoming_value_, outgoing_value_); });
+  // Keep track of setup overhead.
+  {
+    std::lock_guard<std::mutex> lock(contexts_mutex_);
+    setup_time_ += std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - setup_start).count();
+    num_queries_++;
 
-  // Set the start and stop states.
-  ob::ScopedState<ob::RealVectorStateSpace> ompl_start(ompl_space);
-  ob::ScopedState<ob::RealVectorStateSpace> ompl_stop(ompl_space);
-  for (size_t ii = 0; ii < 3; ii++) {
-    ompl_start[ii] = start(ii);
-    ompl_stop[ii] = stop(ii);
+#ifdef ENABLE_DEBUG_MESSAGES
+    ROS_INFO_THROTTLE(10.0, "OMPL setup took %f ms on average over %zu "
+                      "queries.", 1e3 * setup_time_ / num_queries_,
+                      num_queries_);
+#endif
   }
 
-  ompl_setup.setStartAndGoalStates(ompl_start, ompl_stop);
-
-  // Set the planner.
-  ob::PlannerPtr ompl_planner(
-    new PlannerType(ompl_setup.getSpaceInformation()));
-  ompl_setup.setPlanner(ompl_planner);
-
-  // Solve. Parameter is the amount of time (in seconds) used by the solver.
-  const ob::PlannerStatus solved = ompl_setup.solve(budget);
+  // Solve. Stop after the budget (in seconds), when cancelled, or when
+  // any other instance has found a solution.
+  std::atomic<bool> found(false);
+  const ob::PlannerTerminationCondition ptc =
+    ob::plannerOrTerminationCondition(
+      ob::timedPlannerTerminationCondition(budget),
+      ob::PlannerTerminationCondition([&cancel, &found]() {
+          return cancel.load() || found.load(); }));
+
+  // Not std::vector<bool>, whose elements cannot be written concurrently.
+  std::vector<char> solved(num_instances, false);
+  const auto solve = [&](size_t ii) {
+    const std::shared_ptr<og::SimpleSetup>& setup = contexts[ii]->setup_;
+
+    // Optimizing planners would otherwise keep refining until the budget
+    // runs out, so only a lone instance is allowed to do that.
+    const ob::PlannerStatus status = (num_instances > 1) ?
+      setup->solve(ob::plannerOrTerminationCondition(
+        ptc, ob::exactSolnPlannerTerminationCondition(
+          setup->getProblemDefinition()))) :
+      setup->solve(ptc);
+
+    // Approximate solutions do not reach the stop point, so they neither
+    // count as solved nor stop the other instances.
+    if (status == ob::PlannerStatus::EXACT_SOLUTION) {
+      solved[ii] = true;
+      found = true;
+    }
+  };
+
+  std::vector< std::future<void> > helpers;
+  for (size_t ii = 1; ii < num_instances; ii++)
+    helpers.push_back(helpers_->Submit([&solve, ii]() { solve(ii); }));
+
+  solve(0);
+  for (auto& helper : helpers)
+    helper.wait();
+
+  // Use the cheapest solution found.
+  size_t best = num_instances;
+  double best_cost = std::numeric_limits<double>::infinity();
+  for (size_t ii = 0; ii < num_instances; ii++) {
+    if (!solved[ii])
+      continue;
+
+    const std::shared_ptr<og::SimpleSetup>& setup = contexts[ii]->setup_;
+    const double cost = setup->getSolutionPath().cost(
+      setup->getOptimizationObjective()).value();
+
+    if (best == num_instances || cost < best_cost) {
+      best = ii;
+      best_cost = cost;
+    }
+  }
 
-  if (solved) {
-    const og::PathGeometric& solution = ompl_setup.getSolutionPath();
+  if (best < num_instances && !cancel) {
+    const std::shared_ptr<Context>& context = contexts[best];
+    const og::PathGeometric& solution = context->setup_->getSolutionPath();
 
     // Populate the Trajectory with states and time stamps.
     std::vector<Vector3d> positions;
@@ -194,6 +329,29 @@ Plan(const Vector3d& start, const Vector3d& stop,
       values.push_back(incoming_value_);
     }
 
+    // OMPL only knows where obstacles are, not where they will be. Check
+    // the path again at its time stamps, at the same resolution OMPL uses
+    // for motions, against the predicted positions of moving obstacles.
+    for (size_t ii = 1; ii < positions.size(); ii++) {
+      const unsigned int num_steps = context->space_->validSegmentCount(
+        solution.getState(ii - 1), solution.getState(ii));
+
+      for (unsigned int jj = 1; jj <= num_steps; jj++) {
+        const double fraction = static_cast<double>(jj) / num_steps;
+        const Vector3d position = positions[ii - 1] +
+          fraction * (positions[ii] - positions[ii - 1]);
+        const double time = times[ii - 1] +
+          fraction * (times[ii] - times[ii - 1]);
+
+        if (!space_->IsValid(position, time,
+                             incoming_value_, outgoing_value_)) {
+          ROS_WARN_THROTTLE(1.0, "OMPL solution collides with a moving "
+                            "obstacle at time %f.", time);
+          return nullptr;
+        }
+      }
+    }
+
     // Convert to full state space. Make sure to use the INCOMING VALUE!
     std::vector<VectorXd> full_states =
       dynamics_->LiftGeometricTrajectory(positions, times);
@@ -201,10 +359,118 @@ Plan(const Vector3d& start, const Vector3d& stop,
     return Trajectory::Create(times, full_states, values, values);
   }
 
-  ROS_WARN("OMPL Planner could not compute a solution.");
+  if (!cancel)
+    ROS_WARN("OMPL Planner could not compute a solution.");
   return nullptr;
 }
 
+// Get a context ready to solve a query from start to stop.
+template<typename PlannerType>
+void OmplPlanner<PlannerType>::Prepare(Context& context, const Vector3d& start,
+                                       const Vector3d& stop) const {
+  // Reuse the existing setup unless the bounds have changed. Clearing it
+  // drops the previous query's planner data and solutions.
+  if (context.setup_ == nullptr ||
+      space_->LowerBounds() != context.lower_ ||
+      space_->UpperBounds() != context.upper_)
+    Configure(context);
+  else
+    context.setup_->clear();
+
+  // Set the start and stop states.
+  ob::ScopedState<ob::RealVectorStateSpace> ompl_start(context.space_);
+  ob::ScopedState<ob::RealVectorStateSpace> ompl_stop(context.space_);
+  for (size_t ii = 0; ii < 3; ii++) {
+    ompl_start[ii] = start(ii);
+    ompl_stop[ii] = stop(ii);
+  }
+
+  context.setup_->setStartAndGoalStates(ompl_start, ompl_stop);
+
+  // Set up here rather than in solve() so that the budget is spent planning.
+  // This is a no-op unless the setup was just (re)configured.
+  context.setup_->setup();
+}
+
+// Build the OMPL state space, setup, and planner for the current bounds
+// of the environment.
+template<typename PlannerType>
+void OmplPlanner<PlannerType>::Configure(Context& context) const {
+  // Create the OMPL state space corresponding to this environment.
+  context.space_ = std::make_shared<ob::RealVectorStateSpace>(3);
+
+  // Set bounds for the environment.
+  context.lower_ = space_->LowerBounds();
+  context.upper_ = space_->UpperBounds();
+
+  ob::RealVectorBounds ompl_bounds(3);
+
+  for (size_t ii = 0; ii < 3; ii++) {
+    ompl_bounds.setLow(ii, context.lower_(ii));
+    ompl_bounds.setHigh(ii, context.upper_(ii));
+  }
+
+  context.space_->setBounds(ompl_bounds);
+
+  // Only sample from regions which the environment cannot rule out. Both
+  // objectives below make BIT*'s informed sampler draw from this, too.
+  context.space_->setStateSamplerAllocator(
+    [this](const ob::StateSpace* state_space) -> ob::StateSamplerPtr {
+      return std::make_shared<ObstacleAwareSampler>(
+        state_space, space_.get(), incoming_value_, outgoing_value_); });
+
+  // Create a SimpleSetup instance and set the state validity checker function.
+  context.setup_ = std::make_shared<og::SimpleSetup>(context.space_);
+  context.setup_->setStateValidityChecker([this](const ob::State* state) {
+      return space_->IsValid(FromOmplState(state),
+                             incoming_value_, outgoing_value_); });
+
+  // Check each motion with one batched collision query instead of one
+  // query per intermediate state.
+  const ob::SpaceInformationPtr& si = context.setup_->getSpaceInformation();
+  si->setMotionValidator(std::make_shared<BatchMotionValidator>(
+    si, space_.get(), incoming_value_, outgoing_value_));
+
+  // Optimize time rather than path length, using the same metric that the
+  // solution is later time stamped with. Fall back to path length if this
+  // planner's speeds are unavailable.
+  Vector3d max_speed;
+  if (MaxSpeed(max_speed)) {
+    context.setup_->setOptimizationObjective(
+      std::make_shared<TimeOptimizationObjective>(si, max_speed));
+  } else {
+    ROS_WARN("%s: Optimizing path length instead of time.", name_.c_str());
+    context.setup_->setOptimizationObjective(
+      std::make_shared<ObstacleAwarePathLengthObjective>(si));
+  }
+
+  // Set the planner.
+  context.setup_->setPlanner(std::make_shared<PlannerType>(si));
+}
+
+// Take an idle context, or create one if none are idle. The context
+// returns to the pool when released.
+template<typename PlannerType>
+std::shared_ptr<typename OmplPlanner<PlannerType>::Context>
+OmplPlanner<PlannerType>::Acquire() const {
+  Context* context = nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(contexts_mutex_);
+    if (!contexts_.empty()) {
+      context = contexts_.back().release();
+      contexts_.pop_back();
+    }
+  }
+
+  if (context == nullptr)
+    context = new Context();
+
+  return std::shared_ptr<Context>(context, [this](Context* released) {
+      std::lock_guard<std::mutex> lock(contexts_mutex_);
+      contexts_.emplace_back(released); });
+}
+
 // Convert between OMPL states and VectorXds.
 template<typename PlannerType>
 Vector3d OmplPlanner<PlannerType>::FromOmplState(
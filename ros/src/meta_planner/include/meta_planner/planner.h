@@ -69,8 +69,11 @@
 #include <utils/message_interfacing.h>
 
 #include <value_function_srvs/GeometricPlannerTime.h>
+#include <value_function_srvs/GeometricPlannerSpeed.h>
 
 #include <memory>
+#include <atomic>
+#include <mutex>
 
 #include <ros/ros.h>
 
@@ -94,9 +97,24 @@ public:
                                double start_time = 0.0,
                                double budget = 1.0) const = 0;
 
+  // Same as above, but give up as soon as cancel becomes true. Planners
+  // that cannot be interrupted may ignore it.
+  virtual Trajectory::Ptr Plan(const Vector3d& start,
+                               const Vector3d& stop,
+                               double start_time,
+                               double budget,
+                               const std::atomic<bool>& cancel) const {
+    return Plan(start, stop, start_time, budget);
+  }
+
   // Shortest possible time to go from start to stop for this planner.
   double BestPossibleTime(const Vector3d& start, const Vector3d& stop) const;
 
+  // Maximum speed of this planner along each axis. Returns false if the
+  // server could not be reached. Speeds never change, so the server is only
+  // queried until it first answers.
+  bool MaxSpeed(Vector3d& speed) const;
+
   // Get the value function associated to this planner. The way incoming and
   // outgoing value functions are intended to be used, this corresponds to
   // the outgoing value function.
@@ -116,7 +134,8 @@ protected:
     : incoming_value_(incoming_value),
       outgoing_value_(outgoing_value),
       space_(space),
-      dynamics_(dynamics) {
+      dynamics_(dynamics),
+      have_max_speed_(false) {
     if (incoming_value_ + 1 != outgoing_value_)
       ROS_ERROR("Outgoing value function not successor to incoming one.");
   }
@@ -131,10 +150,19 @@ protected:
   // Dynamics.
   const Dynamics::ConstPtr dynamics_;
 
-  // Server to query value functions best possible time.
+  // Server to query value functions best possible time. Planners may be
+  // queried from multiple threads, so calls are serialized.
   mutable ros::ServiceClient best_time_srv_;
+  mutable std::mutex best_time_mutex_;
   std::string best_time_name_;
 
+  // Server to query the planner's maximum speed, and its cached answer.
+  // Shares the mutex above.
+  mutable ros::ServiceClient max_speed_srv_;
+  mutable Vector3d max_speed_;
+  mutable bool have_max_speed_;
+  std::string max_speed_name_;
+
   // Initialization and naming.
   bool initialized_;
   std::string name_;
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the RoadmapPlanner class, which inherits from Planner. It keeps a
+// lazy probabilistic roadmap which persists across queries: vertices are
+// added in the background by Grow(), and edges are only collision checked
+// when a query wants to use them. Each check is remembered for the
+// environment version it was made against, so edges are revalidated only
+// once obstacles change. The roadmap can be saved to and loaded from disk.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_ROADMAP_PLANNER_H
+#define META_PLANNER_ROADMAP_PLANNER_H
+
+#include <meta_planner/planner.h>
+#include <meta_planner/box.h>
+#include <meta_planner/halton_sequence.h>
+#include <meta_planner/kd_tree.h>
+#include <utils/types.h>
+
+#include <boost/thread/shared_mutex.hpp>
+#include <memory>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace meta {
+
+class RoadmapPlanner : public Planner {
+public:
+  typedef std::shared_ptr<RoadmapPlanner> Ptr;
+  typedef std::shared_ptr<const RoadmapPlanner> ConstPtr;
+
+  ~RoadmapPlanner() {}
+
+  // Factory method. The roadmap holds at most max_vertices vertices, each
+  // joined to its nearest neighbors within connection_radius. Distances are
+  // weighted L-infinity, scaled by the planner's speeds as in the meta
+  // planner's trees.
+  static Ptr Create(ValueFunctionId incoming_value,
+                    ValueFunctionId outgoing_value,
+                    const Box::ConstPtr& space,
+                    const Dynamics::ConstPtr& dynamics,
+                    size_t max_vertices, double connection_radius);
+
+  // Find a path through the roadmap between two points, or return null.
+  Trajectory::Ptr Plan(const Vector3d& start,
+                       const Vector3d& stop,
+                       double start_time = 0.0,
+                       double budget = 1.0) const;
+
+  // Same as above, but give up as soon as cancel becomes true.
+  Trajectory::Ptr Plan(const Vector3d& start,
+                       const Vector3d& stop,
+                       double start_time,
+                       double budget,
+                       const std::atomic<bool>& cancel) const;
+
+  // Draw up to num_samples more samples, and add the valid ones to the
+  // roadmap. Returns the number of vertices added.
+  size_t Grow(size_t num_samples);
+
+  // Number of vertices, and whether there is room for more.
+  size_t Size() const;
+  bool Full() const;
+
+  // Load/save the roadmap from/to a file. Loading fails if the file was
+  // saved for different value functions. Edge checks are not saved.
+  bool Load(const std::string& file_name);
+  bool Save(const std::string& file_name) const;
+
+  // Number of nearest neighbors each new vertex is joined to.
+  static const size_t kNumNeighbors = 10;
+
+private:
+  explicit RoadmapPlanner(ValueFunctionId incoming_value,
+                          ValueFunctionId outgoing_value,
+                          const Box::ConstPtr& space,
+                          const Dynamics::ConstPtr& dynamics,
+                          size_t max_vertices, double connection_radius);
+
+  // An edge between two vertices.
+  struct Edge {
+    size_t from_;
+    size_t to_;
+    double cost_;
+  };
+
+  // Add an (unchecked) edge, given the maximum speeds. Assumes the lock
+  // is held for writing.
+  void AddEdge(size_t from, size_t to, const Vector3d& speed);
+
+  // Vertices within the connection radius of a point, nearest first, at
+  // most kNumNeighbors of them. Assumes the lock is held for reading.
+  std::vector<size_t> Neighbors(const Vector3d& point) const;
+
+  // Time to go straight between two points at the given maximum speeds.
+  static inline double Cost(const Vector3d& from, const Vector3d& to,
+                            const Vector3d& speed) {
+    return (to - from).cwiseAbs().cwiseQuotient(speed).maxCoeff();
+  }
+
+  // Collision check the straight line between two points against the
+  // current obstacles. The start point itself is not checked.
+  bool IsValidSegment(const Vector3d& from, const Vector3d& to) const;
+
+  // Maximum number of vertices and connection radius.
+  const size_t max_vertices_;
+  const double connection_radius_;
+
+  // The roadmap, and the sequence its vertices are drawn from.
+  std::vector<Vector3d> vertices_;
+  std::vector<Edge> edges_;
+  std::vector< std::vector<size_t> > adjacency_;
+  HaltonSequence sequence_;
+
+  // Vertex indices by position, for neighbor searches. Its metric depends
+  // on the planner's speeds, so it is only built once vertices are added.
+  std::unique_ptr< KdTree<size_t> > kdtree_;
+
+  // Last check of each edge, indexed like edges_: zero if never checked,
+  // otherwise the environment version and the result packed together.
+  // Queries record checks while only holding the lock for reading. A deque
+  // so that appending never moves the atomics.
+  mutable std::deque< std::atomic<uint64_t> > checks_;
+
+  // Readers/writer lock on the roadmap. Queries only read it, so they run
+  // concurrently; Grow() and Load() write it.
+  mutable boost::shared_mutex mutex_;
+};
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the StraightLinePlanner class, which inherits from Planner. It only
+// ever tries the straight line from start to stop, checked at the same
+// resolution OMPL uses for motions, and fails if that line is blocked. This
+// is cheap enough to try before running a full OMPL planner.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_STRAIGHT_LINE_PLANNER_H
+#define META_PLANNER_STRAIGHT_LINE_PLANNER_H
+
+#include <meta_planner/planner.h>
+#include <meta_planner/box.h>
+#include <utils/types.h>
+
+#include <memory>
+#include <atomic>
+
+namespace meta {
+
+class StraightLinePlanner : public Planner {
+public:
+  ~StraightLinePlanner() {}
+
+  static Planner::Ptr Create(ValueFunctionId incoming_value,
+                             ValueFunctionId outgoing_value,
+                             const Box::ConstPtr& space,
+                             const Dynamics::ConstPtr& dynamics);
+
+  // Plan the straight line between two points, or return null if it is
+  // blocked. Never takes long enough to need the budget.
+  Trajectory::Ptr Plan(const Vector3d& start,
+                       const Vector3d& stop,
+                       double start_time = 0.0,
+                       double budget = 1.0) const;
+
+  // Fraction of the environment's diagonal between collision checks, as in
+  // OMPL's default longest valid segment.
+  static const double kResolutionFraction;
+
+private:
+  explicit StraightLinePlanner(ValueFunctionId incoming_value,
+                               ValueFunctionId outgoing_value,
+                               const Box::ConstPtr& space,
+                               const Dynamics::ConstPtr& dynamics);
+};
+
+} //\namespace meta
+
+#endif
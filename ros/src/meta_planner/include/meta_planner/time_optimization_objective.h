@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the TimeOptimizationObjective class, an OMPL OptimizationObjective
+// whose cost is the time a planner with the given per-axis maximum speeds
+// takes along a path, i.e. the weighted L-infinity length used by the value
+// functions' best possible time. Straight lines are fastest in this metric,
+// so the motion cost is also an exact (and hence admissible) heuristic.
+// Informed planners such as BIT* sample from the state space's own sampler.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_TIME_OPTIMIZATION_OBJECTIVE_H
+#define META_PLANNER_TIME_OPTIMIZATION_OBJECTIVE_H
+
+#include <meta_planner/obstacle_aware_informed_sampler.h>
+#include <utils/types.h>
+
+#include <ompl/base/OptimizationObjective.h>
+#include <ompl/base/SpaceInformation.h>
+#include <ompl/base/goals/GoalState.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace meta {
+
+namespace ob = ompl::base;
+
+class TimeOptimizationObjective : public ob::OptimizationObjective {
+public:
+  explicit TimeOptimizationObjective(const ob::SpaceInformationPtr& si,
+                                     const Vector3d& max_speed)
+    : ob::OptimizationObjective(si),
+      inverse_speed_(max_speed.cwiseInverse()) {
+    description_ = "Time";
+
+    // Cost to go is the time straight to the goal state.
+    setCostToGoHeuristic([this](const ob::State* state,
+                                const ob::Goal* goal) {
+        const ob::GoalState* goal_state =
+          dynamic_cast<const ob::GoalState*>(goal);
+        return (goal_state == nullptr) ? identityCost() :
+          motionCostHeuristic(state, goal_state->getState()); });
+  }
+
+  ~TimeOptimizationObjective() {}
+
+  // Being somewhere takes no time; only moving does.
+  ob::Cost stateCost(const ob::State* state) const {
+    return identityCost();
+  }
+
+  // Time to move in a straight line from s1 to s2.
+  ob::Cost motionCost(const ob::State* s1, const ob::State* s2) const {
+    return ob::Cost(Time(s1, s2));
+  }
+
+  // Moving in a straight line is fastest, so this is exact.
+  ob::Cost motionCostHeuristic(const ob::State* s1,
+                               const ob::State* s2) const {
+    return ob::Cost(Time(s1, s2));
+  }
+
+  // Informed sampler for BIT* and other informed planners. OMPL's default
+  // would ignore the sampler installed on the state space.
+  ob::InformedSamplerPtr allocInformedStateSampler(
+    const ob::ProblemDefinitionPtr& problem, unsigned int max_calls) const {
+    return std::make_shared<ObstacleAwareInformedSampler>(problem, max_calls);
+  }
+
+private:
+  // Weighted L-infinity distance between two states.
+  inline double Time(const ob::State* s1, const ob::State* s2) const {
+    const double* values1 =
+      s1->as<ob::RealVectorStateSpace::StateType>()->values;
+    const double* values2 =
+      s2->as<ob::RealVectorStateSpace::StateType>()->values;
+
+    double time = 0.0;
+    for (size_t ii = 0; ii < 3; ii++)
+      time = std::max(time,
+                      std::abs(values2[ii] - values1[ii]) * inverse_speed_(ii));
+
+    return time;
+  }
+
+  // Reciprocal of the maximum speed along each axis.
+  const Vector3d inverse_speed_;
+};
+
+} //\namespace meta
+
+#endif
@@ -43,6 +43,7 @@
 #ifndef META_PLANNER_TRAJECTORY_H
 #define META_PLANNER_TRAJECTORY_H
 
+#include <meta_planner/arena.h>
 #include <value_function/dynamics.h>
 #include <utils/types.h>
 #include <utils/message_interfacing.h>
@@ -70,17 +71,16 @@ public:
   typedef std::shared_ptr<Trajectory> Ptr;
   typedef std::shared_ptr<const Trajectory> ConstPtr;
 
-  // Factory method. Use this instead of the constructor.
-  static inline Ptr Create() {
-    Ptr ptr(new Trajectory());
-    return ptr;
-  }
+  // Factory method. Use this instead of the constructor. If given an Arena,
+  // the Trajectory and its states are allocated from it.
+  static Ptr Create(const Arena::Ptr& arena = nullptr);
 
   // Factory constructor from times, states, values.
   static Ptr Create(const std::vector<double>& times,
                     const std::vector<VectorXd>& states,
                     const std::vector<ValueFunctionId>& control_values,
-                    const std::vector<ValueFunctionId>& bound_values);
+                    const std::vector<ValueFunctionId>& bound_values,
+                    const Arena::Ptr& arena = nullptr);
 
   // Factory constructor from ROS message and an ordered list of all
   // possible ValueFunctions.
@@ -88,7 +88,8 @@ public:
 
   // Factory constructor to create a Trajectory as the remainder of the
   // given Trajectory after the specified time point.
-  static Ptr Create(const ConstPtr& other, double start);
+  static Ptr Create(const ConstPtr& other, double start,
+                    const Arena::Ptr& arena = nullptr);
 
   // Clear out this Trajectory.
   void Clear();
@@ -135,6 +136,18 @@ public:
   ValueFunctionId GetControlValueFunction(double time) const;
   ValueFunctionId GetBoundValueFunction(double time) const;
 
+  // Get all waypoints in time order, along with the bound value function
+  // used at each one.
+  void Waypoints(std::vector<double>& times,
+                 std::vector<VectorXd>& states,
+                 std::vector<ValueFunctionId>& bound_values) const;
+
+  // Same as above, but also with the control value function at each one.
+  void Waypoints(std::vector<double>& times,
+                 std::vector<VectorXd>& states,
+                 std::vector<ValueFunctionId>& control_values,
+                 std::vector<ValueFunctionId>& bound_values) const;
+
   // Convert to ROS message.
   meta_planner_msgs::Trajectory ToRosMessage() const;
 
@@ -146,7 +159,8 @@ public:
   void Print(const std::string& prefix) const;
 
 private:
-  Trajectory() {}
+  explicit Trajectory(const Arena::Ptr& arena = nullptr)
+    : map_(std::less<double>(), Allocator(arena)) {}
 
   // Compute the color (on a red-blue colormap) at a particular time.
   std_msgs::ColorRGBA Colormap(double time) const;
@@ -166,8 +180,11 @@ private:
     ~StateValue() {}
   };
 
-  // Map from time stamp to corresponding state/value function.
-  std::map<double, StateValue> map_;
+  // Map from time stamp to corresponding state/value function, allocated
+  // from an Arena if there is one.
+  typedef ArenaAllocator< std::pair<const double, StateValue> > Allocator;
+  typedef std::map<double, StateValue, std::less<double>, Allocator> Map;
+  Map map_;
 };
 
 // ---------------------- IMPLEMENT INLINE FUNCTIONS ------------------------ //
@@ -301,6 +318,36 @@ inline ValueFunctionId Trajectory::FirstBoundValueFunction() const {
     return map_.begin()->second.bound_value_;
   }
 
+// Get all waypoints in time order, along with the bound value function
+// used at each one.
+inline void Trajectory::Waypoints(std::vector<double>& times,
+                                  std::vector<VectorXd>& states,
+                                  std::vector<ValueFunctionId>& bound_values)
+  const {
+  times.clear();
+  states.clear();
+  bound_values.clear();
+
+  for (const auto& entry : map_) {
+    times.push_back(entry.first);
+    states.push_back(entry.second.state_);
+    bound_values.push_back(entry.second.bound_value_);
+  }
+}
+
+// Same as above, but also with the control value function at each one.
+inline void Trajectory::Waypoints(std::vector<double>& times,
+                                  std::vector<VectorXd>& states,
+                                  std::vector<ValueFunctionId>& control_values,
+                                  std::vector<ValueFunctionId>& bound_values)
+  const {
+  Waypoints(times, states, bound_values);
+
+  control_values.clear();
+  for (const auto& entry : map_)
+    control_values.push_back(entry.second.control_value_);
+}
+
 } //\namespace meta
 
 #endif
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the TrajectoryMonitor class, which watches the remainder of the
+// active trajectory for conflicts with newly sensed obstacles. Each segment
+// between consecutive waypoints is swept by the tracking bound of its bound
+// value function, and segments are organized in a bounding volume hierarchy
+// over space and time. Checking an obstacle therefore only touches the
+// segments it could possibly overlap.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_TRAJECTORY_MONITOR_H
+#define META_PLANNER_TRAJECTORY_MONITOR_H
+
+#include <meta_planner/trajectory.h>
+#include <value_function/dynamics.h>
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <ros/ros.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace meta {
+
+class TrajectoryMonitor : private Uncopyable {
+public:
+  typedef std::shared_ptr<TrajectoryMonitor> Ptr;
+  typedef std::shared_ptr<const TrajectoryMonitor> ConstPtr;
+
+  // Factory method. Use this instead of the constructor. Requires the
+  // tracking bound of every bound value function used in the trajectory;
+  // returns null if any is missing.
+  static Ptr Create(const Trajectory::ConstPtr& traj,
+                    const Dynamics::ConstPtr& dynamics,
+                    const std::map<ValueFunctionId, Vector3d>& bounds);
+
+  // Factory method from waypoint times, positions, and tracking bounds.
+  static Ptr Create(const std::vector<double>& times,
+                    const std::vector<Vector3d>& positions,
+                    const std::vector<Vector3d>& bounds);
+
+  // Destructor.
+  ~TrajectoryMonitor() {}
+
+  // Check a spherical obstacle, moving at constant velocity from the given
+  // point at the given time stamp, against all segments which end after
+  // 'from_time'. Returns the index of the earliest conflicting segment, or
+  // -1 if there is no conflict.
+  int Conflict(const Vector3d& point, double radius,
+               const Vector3d& velocity, double stamp,
+               double from_time) const;
+
+  // Accessors.
+  inline size_t NumSegments() const { return segments_.size(); }
+  inline double SegmentStartTime(size_t ii) const {
+    return segments_[ii].start_time_;
+  }
+  inline double SegmentStopTime(size_t ii) const {
+    return segments_[ii].stop_time_;
+  }
+
+private:
+  explicit TrajectoryMonitor() {}
+
+  // Segment between consecutive waypoints, and the tracking bound around it.
+  struct Segment {
+    Vector3d start_;
+    Vector3d stop_;
+    double start_time_;
+    double stop_time_;
+    Vector3d bound_;
+  };
+
+  // Node of the bounding volume hierarchy. Boxes contain every segment below
+  // the node, inflated by its tracking bound, over the node's time interval.
+  // Leaves hold a range of 'order_', inner nodes have exactly two children.
+  struct Node {
+    Vector3d lower_;
+    Vector3d upper_;
+    double start_time_;
+    double stop_time_;
+    size_t first_;
+    size_t count_;
+    size_t left_;
+    size_t right_;
+  };
+
+  // Recursively build the hierarchy over order_[first, first + count).
+  // Returns the index of the new node.
+  size_t Build(size_t first, size_t count);
+
+  // Exact check of a single segment against a moving obstacle.
+  bool SegmentConflict(const Segment& segment,
+                       const Vector3d& point, double radius,
+                       const Vector3d& velocity, double stamp,
+                       double from_time) const;
+
+  // Segments in time order, and a permutation of them used by the leaves.
+  std::vector<Segment> segments_;
+  std::vector<size_t> order_;
+
+  // Hierarchy. The root is node 0.
+  std::vector<Node> nodes_;
+};
+
+} //\namespace meta
+
+#endif
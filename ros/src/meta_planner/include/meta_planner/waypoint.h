@@ -44,6 +44,7 @@
 #define META_PLANNER_WAYPOINT_H
 
 #include <meta_planner/trajectory.h>
+#include <meta_planner/arena.h>
 #include <utils/types.h>
 #include <utils/uncopyable.h>
 
@@ -61,13 +62,21 @@ public:
   const Trajectory::Ptr traj_;
   const ConstPtr parent_;
 
-  // Factory method. Use this instead of the constructor.
+  // Factory method. Use this instead of the constructor. If given an Arena,
+  // the Waypoint is allocated from it.
   static inline ConstPtr Create(const Vector3d& point,
                                 ValueFunctionId value,
                                 const Trajectory::Ptr& traj,
-                                const ConstPtr& parent) {
-    ConstPtr ptr(new Waypoint(point, value, traj, parent));
-    return ptr;
+                                const ConstPtr& parent,
+                                const Arena::Ptr& arena = nullptr) {
+    if (arena == nullptr) {
+      ConstPtr ptr(new Waypoint(point, value, traj, parent));
+      return ptr;
+    }
+
+    void* memory = arena->Allocate(sizeof(Waypoint), alignof(Waypoint));
+    return ArenaShared(
+      new (memory) Waypoint(point, value, traj, parent), arena);
   }
 
   // Destructor.
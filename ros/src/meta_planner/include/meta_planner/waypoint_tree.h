@@ -38,7 +38,12 @@
 //
 // Defines the WaypointTree class. The WaypointTree class handles queries like
 // finding the nearest k points, as well as the length (in time) of the
-// shortest path to the goal.
+// shortest path to the goal. Waypoints may be inserted and searched for
+// from multiple threads at once.
+//
+// Each tree owns an Arena, from which its waypoints (and whatever else the
+// caller chooses) may be allocated. The Arena is released in one shot once
+// the tree and everything allocated from it are gone.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -46,38 +51,66 @@
 #define META_PLANNER_WAYPOINT_TREE_H
 
 #include <meta_planner/waypoint.h>
-#include <meta_planner/flann_tree.h>
+#include <meta_planner/kd_tree.h>
+#include <meta_planner/arena.h>
 #include <utils/types.h>
 #include <utils/uncopyable.h>
 
+#include <boost/thread/shared_mutex.hpp>
 #include <iostream>
 #include <list>
 #include <limits>
+#include <memory>
 
 namespace meta {
 
 class WaypointTree : private Uncopyable {
 public:
+  typedef std::shared_ptr<WaypointTree> Ptr;
+  typedef std::shared_ptr<const WaypointTree> ConstPtr;
+
   ~WaypointTree() {}
   explicit WaypointTree(const Vector3d& start,
                         ValueFunctionId start_value,
-                        double start_time = 0.0);
+                        double start_time = 0.0,
+                        const Vector3d& weights = Vector3d::Ones());
 
-  // Find nearest neighbors in the tree.
-  inline std::vector<Waypoint::ConstPtr>
-  KnnSearch(Vector3d& query, size_t k) const {
-    return kdtree_.KnnSearch(query, k);
+  // Distance between two points, under the weighted L-infinity metric used
+  // by the searches below.
+  inline double Distance(const Vector3d& a, const Vector3d& b) const {
+    return kdtree_.Distance(a, b);
   }
 
-  inline std::vector<Waypoint::ConstPtr>
-  RadiusSearch(Vector3d& query, double r) const {
-    return kdtree_.RadiusSearch(query, r);
+  // Find the (at most) k nearest neighbors in the tree, closest first, into
+  // the given buffers of at least k elements. Returns how many were found.
+  size_t KnnSearch(const Vector3d& query, size_t k,
+                   Waypoint::ConstPtr* neighbors, double* distances) const;
+
+  // Same as above, but returning the neighbors.
+  std::vector<Waypoint::ConstPtr> KnnSearch(const Vector3d& query,
+                                            size_t k) const;
+
+  // Find all neighbors within distance r, closest first.
+  std::vector<Waypoint::ConstPtr> RadiusSearch(const Vector3d& query,
+                                               double r) const;
+
+  // All waypoints in the tree, including the root, in order of insertion.
+  std::vector<Waypoint::ConstPtr> Waypoints() const;
+
+  // Arena for everything allocated in building this tree.
+  inline const Arena::Ptr& GetArena() const { return arena_; }
+
+  // Root of the tree, and best terminal waypoint (null if none).
+  inline const Waypoint::ConstPtr& Root() const { return root_; }
+  inline Waypoint::ConstPtr Terminus() const {
+    return std::atomic_load(&terminus_);
   }
 
   // Add Waypoint to tree.
   void Insert(const Waypoint::ConstPtr& waypoint, bool is_terminal);
 
-  // Get best (fastest) trajectory (if it exists).
+  // Get best (fastest) trajectory (if it exists). This is a copy on the heap,
+  // which outlives the tree and its Arena.
   Trajectory::Ptr BestTrajectory() const;
 
   // Get best total time (seconds) of any valid trajectory.
@@ -85,17 +118,27 @@ public:
   double BestTime() const;
 
 private:
+  // Arena for this tree's waypoints. Declared first, since the root is
+  // allocated from it.
+  const Arena::Ptr arena_;
+
   // Root of the tree.
   Waypoint::ConstPtr root_;
 
-  // Best terminal waypoint.
+  // Best terminal waypoint. Only accessed through std::atomic_load and
+  // std::atomic_compare_exchange, since any thread may improve it.
   Waypoint::ConstPtr terminus_;
 
   // Start time.
   const double start_time_;
 
-  // Kdtree storing all waypoints for easy nearest neighbor searching.
-  FlannTree kdtree_;
+  // Kdtree storing all waypoints for easy nearest neighbor searching, and
+  // the same waypoints in order of insertion.
+  KdTree<Waypoint::ConstPtr> kdtree_;
+  std::vector<Waypoint::ConstPtr> registry_;
+
+  // Readers/writer lock on the kdtree and registry.
+  mutable boost::shared_mutex mutex_;
 };
 
 } //\namespace meta
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the Arena class, a monotonic (bump) allocator. Memory comes from
+// large blocks and is never freed piecemeal: all of it is released at once
+// when the Arena is destroyed. Allocation is thread-safe, and only takes a
+// lock to start a new block.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/arena.h>
+
+#include <cstdint>
+#include <new>
+
+namespace meta {
+
+const size_t Arena::kDefaultBlockSize = 1 << 16;
+
+// Factory method. Use this instead of the constructor.
+Arena::Ptr Arena::Create(size_t block_size) {
+  Ptr ptr(new Arena(block_size));
+  return ptr;
+}
+
+Arena::Arena(size_t block_size)
+  : block_size_(block_size),
+    current_(nullptr),
+    allocated_(0),
+    reserved_(0) {}
+
+// Destructor. Releases every block.
+Arena::~Arena() {
+  for (char* block : blocks_)
+    delete[] block;
+}
+
+// Allocate the given number of bytes with the given alignment. Requests too
+// large to share a block get a block of their own, leaving the current one
+// in place. Otherwise, space is claimed from the current block without a
+// lock, and only starting a new block is serialized.
+void* Arena::Allocate(size_t size, size_t alignment) {
+  allocated_.fetch_add(size, std::memory_order_relaxed);
+
+  const auto aligned = [alignment](char* ptr) {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+    return reinterpret_cast<char*>(
+      (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+  };
+
+  const size_t padded = size + alignment - 1;
+  if (padded > block_size_ / 4) {
+    char* block = new char[padded];
+    reserved_.fetch_add(padded, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocks_.push_back(block);
+    return aligned(block);
+  }
+
+  while (true) {
+    Block* block = current_.load(std::memory_order_acquire);
+    if (block != nullptr) {
+      char* head = block->head_.load(std::memory_order_relaxed);
+      char* start = aligned(head);
+      while (start <= block->end_ &&
+             size <= static_cast<size_t>(block->end_ - start)) {
+        if (block->head_.compare_exchange_weak(
+              head, start + size, std::memory_order_relaxed))
+          return start;
+
+        start = aligned(head);
+      }
+    }
+
+    // Start a new block, unless another thread already has.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (current_.load(std::memory_order_relaxed) != block)
+      continue;
+
+    char* memory = new char[sizeof(Block) + block_size_];
+    blocks_.push_back(memory);
+    reserved_.fetch_add(sizeof(Block) + block_size_,
+                        std::memory_order_relaxed);
+
+    Block* next = new (memory) Block();
+    next->head_.store(memory + sizeof(Block), std::memory_order_relaxed);
+    next->end_ = memory + sizeof(Block) + block_size_;
+    current_.store(next, std::memory_order_release);
+  }
+}
+
+// Total bytes handed out.
+size_t Arena::Allocated() const {
+  return allocated_.load();
+}
+
+// Total bytes held in blocks.
+size_t Arena::Reserved() const {
+  return reserved_.load();
+}
+
+} //\namespace meta
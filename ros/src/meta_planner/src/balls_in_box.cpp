@@ -38,12 +38,18 @@
 //
 // Defines a Box environment with spherical obstacles. For simplicity, this
 // does not bother with a kdtree index to speed up collision queries, since
-// it is only for a simulated demo.
+// it is only for a simulated demo. Obstacles are kept in an ObstacleStore
+// so that collision checks can be vectorized, and published as immutable
+// snapshots so that sensing never interferes with planning. Sensed obstacles
+// may move at constant velocity, in which case they are checked at their
+// predicted positions along a trajectory's time stamps.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <demo/balls_in_box.h>
 
+#include <unordered_set>
+
 namespace meta {
 
 // Factory method. Use this instead of the constructor.
@@ -54,7 +60,24 @@ BallsInBox::Ptr BallsInBox::Create() {
 
 // Constructor. Don't use this. Use the factory method instead.
 BallsInBox::BallsInBox()
-  : Box() {}
+  : Box(),
+    prediction_horizon_(0.0),
+    prediction_bin_dt_(0.0) {}
+
+// Load parameters.
+bool BallsInBox::LoadParameters(const ros::NodeHandle& n) {
+  if (!Box::LoadParameters(n)) return false;
+
+  ros::NodeHandle nl(n);
+
+  // Prediction horizon and bin length for moving obstacles.
+  if (!nl.getParam("obstacles/prediction_horizon", prediction_horizon_))
+    return false;
+  if (!nl.getParam("obstacles/prediction_bin_dt", prediction_bin_dt_))
+    return false;
+
+  return true;
+}
 
 // Inherited collision checker from Box needs to be overwritten.
 // Takes in incoming and outgoing value functions. See planner.h for details.
@@ -69,68 +92,98 @@ bool BallsInBox::IsValid(const Vector3d& position,
   }
 #endif
 
-  // Make sure server is up.
-  if (!switching_bound_srv_) {
-    ROS_WARN("%s: Switching bound server disconnected.", name_.c_str());
+  Vector3d bound;
+  if (!SwitchingBound(incoming_value, outgoing_value, bound))
+    return false;
+
+  // Check bounds, then check against each obstacle.
+  if (!InBounds(position, bound))
+    return false;
 
-    ros::NodeHandle nl;
-    switching_bound_srv_ = nl.serviceClient<value_function_srvs::SwitchingTrackingBoundBox>(
-      switching_bound_name_.c_str(), true);
+  return obstacles_.Get()->CheckPoint(position, bound);
+}
 
+// Spatio-temporal collision checker. Checks against the predicted
+// positions of all obstacles at the given time.
+bool BallsInBox::IsValid(const Vector3d& position, double time,
+                         ValueFunctionId incoming_value,
+                         ValueFunctionId outgoing_value) const {
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (!initialized_) {
+    ROS_WARN("%s: Tried to collision check an uninitialized BallsInBox.",
+             name_.c_str());
     return false;
   }
+#endif
 
-  // No obstacles. Just check bounds.
-  value_function_srvs::SwitchingTrackingBoundBox bound;
-  bound.request.from_id = incoming_value;
-  bound.request.to_id = outgoing_value;
-  if (!switching_bound_srv_.call(bound)) {
-    ROS_ERROR("%s: Error calling switching bound server.", name_.c_str());
+  Vector3d bound;
+  if (!SwitchingBound(incoming_value, outgoing_value, bound))
     return false;
-  }
 
-  if (position(0) < lower_(0) + bound.response.x ||
-      position(0) > upper_(0) - bound.response.x ||
-      position(1) < lower_(1) + bound.response.y ||
-      position(1) > upper_(1) - bound.response.y ||
-      position(2) < lower_(2) + bound.response.z ||
-      position(2) > upper_(2) - bound.response.z)
+  if (!InBounds(position, bound))
     return false;
 
-  // Check against each obstacle.
-  const Vector3d bound_vector(
-    bound.response.x, bound.response.y, bound.response.z);
-
-  for (size_t ii = 0; ii < points_.size(); ii++) {
-    const Vector3d& p = points_[ii];
-
-    // Compute signed distance between position and obstacle center.
-    const Vector3d signed_distance = p - position;
-
-    // Find closest point in the tracking bound to the obstacle center.
-    Vector3d closest_point;
-    for (size_t jj = 0; jj < 3; jj++) {
-      if (signed_distance(jj) >= 0.0) {
-        if (signed_distance(jj) >= bound_vector(jj))
-          closest_point(jj) = position(jj) + bound_vector(jj);
-        else
-          closest_point(jj) = p(jj);
-      } else {
-        if (signed_distance(jj) <= -bound_vector(jj))
-          closest_point(jj) = position(jj) - bound_vector(jj);
-        else
-          closest_point(jj) = p(jj);
-      }
-    }
+  return obstacles_.Get()->CheckPoint(position, time, bound);
+}
+
+// Batch collision checker. Checks blocks of points against all obstacles
+// at once, one point per SIMD lane. IsValid does not go through here: a
+// lone point would leave all but one lane idle, so it uses a per-point
+// kernel which puts obstacles on the lanes instead.
+void BallsInBox::IsValidBatch(const std::vector<Vector3d>& points,
+                              ValueFunctionId incoming_value,
+                              ValueFunctionId outgoing_value,
+                              std::vector<bool>& out_mask) const {
+  out_mask.assign(points.size(), false);
 
-    // Check distance to closest point.
-    if ((closest_point - p).norm() <= radii_[ii])
-      return false;
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (!initialized_) {
+    ROS_WARN("%s: Tried to collision check an uninitialized BallsInBox.",
+             name_.c_str());
+    return;
   }
+#endif
 
-  return true;
+  // Only need to look up the tracking bound once for the whole batch.
+  Vector3d bound;
+  if (!SwitchingBound(incoming_value, outgoing_value, bound))
+    return;
+
+  // Hold on to one version for the whole batch.
+  const ObstacleStore::ConstPtr obstacles = obstacles_.Get();
+
+  // Walk through points one SIMD block at a time.
+  const size_t kBlockSize = ObstacleStore::kNumLanes;
+  bool valid[kBlockSize];
+
+  for (size_t ii = 0; ii < points.size(); ii += kBlockSize) {
+    const size_t num_points = std::min(kBlockSize, points.size() - ii);
+
+    // Bounds check. Points out of bounds skip the obstacle check.
+    for (size_t jj = 0; jj < num_points; jj++)
+      valid[jj] = InBounds(points[ii + jj], bound);
+
+    obstacles->CheckBlock(&points[ii], num_points, bound, valid);
+
+    for (size_t jj = 0; jj < num_points; jj++)
+      out_mask[ii + jj] = valid[jj];
+  }
 }
 
+// Rules out boxes which are out of bounds, or which lie entirely inside
+// a single obstacle once inflated by the tracking bound.
+bool BallsInBox::IsBlocked(const Vector3d& lower, const Vector3d& upper,
+                           ValueFunctionId incoming_value,
+                           ValueFunctionId outgoing_value) const {
+  if (Box::IsBlocked(lower, upper, incoming_value, outgoing_value))
+    return true;
+
+  Vector3d bound;
+  if (!SwitchingBound(incoming_value, outgoing_value, bound))
+    return false;
+
+  return obstacles_.Get()->CoversBox(lower, upper, bound);
+}
 
 // Checks for obstacles within a sensing radius. Returns true if at least
 // one obstacle was found.
@@ -140,32 +193,206 @@ bool BallsInBox::SenseObstacles(const Vector3d& position, double sensor_radius,
   obstacle_positions.clear();
   obstacle_radii.clear();
 
-  for (size_t ii = 0; ii < points_.size(); ii++){
-    if ((position - points_[ii]).norm() <= radii_[ii] + sensor_radius) {
-      obstacle_positions.push_back(points_[ii]);
-      obstacle_radii.push_back(radii_[ii]);
+  const ObstacleStore::ConstPtr obstacles = obstacles_.Current();
+  for (size_t ii = 0; ii < obstacles->Size(); ii++){
+    const Vector3d point = obstacles->Point(ii);
+    const double radius = obstacles->Radius(ii);
+
+    if ((position - point).norm() <= radius + sensor_radius) {
+      obstacle_positions.push_back(point);
+      obstacle_radii.push_back(radius);
     }
   }
 
   return obstacle_positions.size() > 0;
 }
 
-// Checks if a given obstacle is in the environment.
+// Same as above, but reports the IDs and predicted positions of all
+// obstacles at the given time, along with their velocities.
+bool BallsInBox::SenseObstacles(const Vector3d& position,
+                                double sensor_radius, double time,
+                                std::vector<uint64_t>& obstacle_ids,
+                                std::vector<Vector3d>& obstacle_positions,
+                                std::vector<Vector3d>& obstacle_velocities,
+                                std::vector<double>& obstacle_radii) const {
+  obstacle_ids.clear();
+  obstacle_positions.clear();
+  obstacle_velocities.clear();
+  obstacle_radii.clear();
+
+  const ObstacleStore::ConstPtr obstacles = obstacles_.Current();
+  for (size_t ii = 0; ii < obstacles->Size(); ii++){
+    const Vector3d point = obstacles->PointAt(ii, time);
+    const double radius = obstacles->Radius(ii);
+
+    if ((position - point).norm() <= radius + sensor_radius) {
+      obstacle_ids.push_back(obstacles->Id(ii));
+      obstacle_positions.push_back(point);
+      obstacle_velocities.push_back(obstacles->Velocity(ii));
+      obstacle_radii.push_back(radius);
+    }
+  }
+
+  return obstacle_positions.size() > 0;
+}
+
+// Checks if a given obstacle is in the environment. If so, publishes a new
+// version with the known obstacle moved to match the given one.
 bool BallsInBox::IsObstacle(const Vector3d& obstacle_position,
                             double obstacle_radius) {
-  const double kClosePosition = 0.25;
-  for (size_t ii = 0; ii < points_.size(); ii++)
-    if ((obstacle_position - points_[ii]).norm() < kClosePosition &&
-        std::abs(obstacle_radius - radii_[ii]) < 1e-8) {
+  bool found = false;
+
+  const double right_now = ros::Time::now().toSec();
+
+  obstacles_.Update([&](ObstacleStore& obstacles) {
+      const int ii = FindObstacle(
+        obstacles, obstacle_position, obstacle_radius, right_now);
+      if (ii < 0)
+        return false;
+
       // If this obstacle is in the environment, update the position of 
       // the known obstacle to match the sensed one.
-      points_[ii] = obstacle_position;
+      obstacles.SetPoint(ii, obstacle_position);
+      found = true;
       return true;
-    }
+    });
+
+  return found;
+}
 
-  return false;
+// Merge a list of obstacles sensed at the given time into the environment:
+// known obstacles (matched against their predicted positions) are updated,
+// and unknown ones are added. Publishes at most one new version. Returns true
+// if any obstacle was unknown, and the indices of those added or changed.
+bool BallsInBox::
+MergeObstacles(const std::vector<Vector3d>& obstacle_positions,
+               const std::vector<double>& obstacle_radii,
+               const std::vector<Vector3d>& obstacle_velocities,
+               double stamp, std::vector<size_t>& out_changed) {
+  const bool has_velocities =
+    obstacle_velocities.size() == obstacle_positions.size();
+  bool unseen_obstacle = false;
+  out_changed.clear();
+
+  obstacles_.Update([&](ObstacleStore& obstacles) {
+      for (size_t ii = 0; ii < obstacle_positions.size(); ii++) {
+        const Vector3d velocity = (has_velocities) ?
+          obstacle_velocities[ii] : Vector3d::Zero();
+
+        const int jj = FindObstacle(
+          obstacles, obstacle_positions[ii], obstacle_radii[ii], stamp);
+
+        if (jj < 0) {
+          obstacles.Add(obstacle_positions[ii], obstacle_radii[ii],
+                        velocity, stamp);
+          unseen_obstacle = true;
+          out_changed.push_back(ii);
+        } else if (obstacles.Point(jj) != obstacle_positions[ii] ||
+                   obstacles.Velocity(jj) != velocity) {
+          obstacles.SetMotion(jj, obstacle_positions[ii], velocity, stamp);
+          out_changed.push_back(ii);
+        }
+      }
+
+      const bool changed = !out_changed.empty();
+
+      // Re-index swept volumes from the time of this measurement.
+      if (changed)
+        obstacles.BuildSweptIndex(
+          stamp, prediction_horizon_, prediction_bin_dt_);
+
+      return changed;
+    });
+
+  return unseen_obstacle;
 }
 
+// Apply an incremental sensor update: obstacles are matched by ID, in
+// constant time each. Removed obstacles are dropped, and on a full resync so
+// is every obstacle not listed. Returns true if any obstacle was unknown, and
+// the indices of those added or changed.
+bool BallsInBox::
+ApplyObstacleDeltas(const std::vector<uint64_t>& obstacle_ids,
+                    const std::vector<Vector3d>& obstacle_positions,
+                    const std::vector<double>& obstacle_radii,
+                    const std::vector<Vector3d>& obstacle_velocities,
+                    const std::vector<uint64_t>& removed_ids,
+                    bool full_resync, double stamp,
+                    std::vector<size_t>& out_changed) {
+  const bool has_velocities =
+    obstacle_velocities.size() == obstacle_positions.size();
+  bool unseen_obstacle = false;
+  out_changed.clear();
+
+  obstacles_.Update([&](ObstacleStore& obstacles) {
+      bool changed = false;
+
+      // On a full resync, drop everything the sensor no longer reports.
+      if (full_resync) {
+        const std::unordered_set<uint64_t> listed(
+          obstacle_ids.begin(), obstacle_ids.end());
+
+        for (size_t ii = obstacles.Size(); ii > 0; ii--) {
+          if (listed.count(obstacles.Id(ii - 1)) == 0) {
+            obstacles.Remove(ii - 1);
+            changed = true;
+          }
+        }
+      }
+
+      for (size_t ii = 0; ii < removed_ids.size(); ii++) {
+        const int jj = obstacles.Find(removed_ids[ii]);
+        if (jj >= 0) {
+          obstacles.Remove(jj);
+          changed = true;
+        }
+      }
+
+      for (size_t ii = 0; ii < obstacle_ids.size(); ii++) {
+        const Vector3d velocity = (has_velocities) ?
+          obstacle_velocities[ii] : Vector3d::Zero();
+
+        const int jj = obstacles.Find(obstacle_ids[ii]);
+        if (jj < 0) {
+          obstacles.Add(obstacle_ids[ii], obstacle_positions[ii],
+                        obstacle_radii[ii], velocity, stamp);
+          unseen_obstacle = true;
+          out_changed.push_back(ii);
+        } else if (obstacles.PointAt(jj, stamp) != obstacle_positions[ii] ||
+                   obstacles.Velocity(jj) != velocity) {
+          obstacles.SetMotion(jj, obstacle_positions[ii], velocity, stamp);
+          out_changed.push_back(ii);
+        }
+      }
+
+      changed = changed || !out_changed.empty();
+
+      // Re-index swept volumes from the time of this measurement.
+      if (changed)
+        obstacles.BuildSweptIndex(
+          stamp, prediction_horizon_, prediction_bin_dt_);
+
+      return changed;
+    });
+
+  return unseen_obstacle;
+}
+
+// Find a known obstacle whose predicted position at the given time matches
+// the given one. Returns the index of the obstacle in the store, or -1 if
+// none matches.
+int BallsInBox::FindObstacle(const ObstacleStore& obstacles,
+                             const Vector3d& obstacle_position,
+                             double obstacle_radius, double time) {
+  const double kClosePosition = 0.25;
+  for (size_t ii = 0; ii < obstacles.Size(); ii++)
+    if ((obstacle_position - obstacles.PointAt(ii, time)).norm() <
+        kClosePosition &&
+        std::abs(obstacle_radius - obstacles.Radius(ii)) < 1e-8)
+      return static_cast<int>(ii);
+
+  return -1;
+}
 
 // Inherited visualizer from Box needs to be overwritten.
 void BallsInBox::Visualize(const ros::Publisher& pub,
@@ -208,7 +435,10 @@ void BallsInBox::Visualize(const ros::Publisher& pub,
   pub.publish(cube);
 
   // Visualize obstacles as spheres.
-  for (size_t ii = 0; ii < points_.size(); ii++){
+  const ObstacleStore::ConstPtr obstacles = obstacles_.Current();
+  for (size_t ii = 0; ii < obstacles->Size(); ii++){
+    const double radius = obstacles->Radius(ii);
+
     visualization_msgs::Marker sphere;
     sphere.ns = "sphere";
     sphere.header.frame_id = frame_id;
@@ -217,9 +447,9 @@ void BallsInBox::Visualize(const ros::Publisher& pub,
     sphere.type = visualization_msgs::Marker::SPHERE;
     sphere.action = visualization_msgs::Marker::ADD;
 
-    sphere.scale.x = 2.0 * radii_[ii];
-    sphere.scale.y = 2.0 * radii_[ii];
-    sphere.scale.z = 2.0 * radii_[ii];
+    sphere.scale.x = 2.0 * radius;
+    sphere.scale.y = 2.0 * radius;
+    sphere.scale.z = 2.0 * radius;
 
     sphere.color.a = 0.9;
     sphere.color.r = 0.7;
@@ -227,7 +457,7 @@ void BallsInBox::Visualize(const ros::Publisher& pub,
     sphere.color.b = 0.5;
 
     geometry_msgs::Point p;
-    const Vector3d point = points_[ii];
+    const Vector3d point = obstacles->Point(ii);
     p.x = point(0);
     p.y = point(1);
     p.z = point(2);
@@ -249,8 +479,10 @@ void BallsInBox::AddObstacle(const Vector3d& point, double r) {
     ROS_ERROR("Radius was too small: %f.", r);
 #endif
 
-  points_.push_back(point);
-  radii_.push_back(std::max(r, kSmallNumber));
+  obstacles_.Update([&](ObstacleStore& obstacles) {
+      obstacles.Add(point, std::max(r, kSmallNumber));
+      return true;
+    });
 }
 
 } //\namespace meta
@@ -55,21 +55,80 @@ Box::Ptr Box::Create() {
 Box::Box()
   : Environment(),
     lower_(Vector3d::Zero()),
-    upper_(Vector3d::Constant(1.0)) {}
+    upper_(Vector3d::Constant(1.0)),
+    bound_cache_(new BoundMap()) {}
 
 // Inherited from Environment, but can be overwritten by child classes.
-Vector3d Box::Sample() const {
+Vector3d Box::Sample(std::default_random_engine& rng) const {
   Vector3d sample;
 
   // Sample each dimension from this distribution.
   for (size_t ii = 0; ii < 3; ii++) {
     std::uniform_real_distribution<double> unif(lower_(ii), upper_(ii));
-    sample(ii) = unif(rng_);
+    sample(ii) = unif(rng);
   }
 
   return sample;
 }
 
+// Inherited from Environment, but can be overwritten by child classes.
+Vector3d Box::Sample(HaltonSequence& sequence) const {
+  return lower_ + sequence.Next().cwiseProduct(upper_ - lower_);
+}
+
+// Inherited from Environment, but can be overwritten by child classes.
+// Samples from the bounding box of the informed subset, and rejects points
+// outside it. Travel time is measured in the weighted L-infinity norm,
+// just as the value functions' best possible time.
+bool Box::SampleInformed(const Vector3d& start, const Vector3d& stop,
+                         const Vector3d& max_speed, double max_time,
+                         HaltonSequence& sequence, Vector3d& sample) const {
+  // Along each axis, going through a point takes at least as long as the
+  // two legs along that axis alone. So the informed subset lies within
+  // max_time * max_speed / 2 of the midpoint, in each dimension.
+  const Vector3d midpoint = 0.5 * (start + stop);
+  const Vector3d half_width = 0.5 * max_time * max_speed;
+  const Vector3d lower = lower_.cwiseMax(midpoint - half_width);
+  const Vector3d upper = upper_.cwiseMin(midpoint + half_width);
+
+  if ((lower.array() > upper.array()).any())
+    return false;
+
+  // Rejection is cheap, but give up eventually in case the informed subset
+  // is very thin.
+  const size_t kMaxAttempts = 100;
+  for (size_t ii = 0; ii < kMaxAttempts; ii++) {
+    sample = lower + sequence.Next().cwiseProduct(upper - lower);
+
+    const double time =
+      (sample - start).cwiseAbs().cwiseQuotient(max_speed).maxCoeff() +
+      (stop - sample).cwiseAbs().cwiseQuotient(max_speed).maxCoeff();
+    if (time <= max_time)
+      return true;
+  }
+
+  return false;
+}
+
+// Inherited from Environment, but can be overwritten by child classes.
+// Rules out boxes which lie entirely outside the bounds, once shrunk by
+// the tracking bound.
+bool Box::IsBlocked(const Vector3d& lower, const Vector3d& upper,
+                    ValueFunctionId incoming_value,
+                    ValueFunctionId outgoing_value) const {
+  Vector3d bound;
+  if (!SwitchingBound(incoming_value, outgoing_value, bound))
+    return false;
+
+  for (size_t ii = 0; ii < 3; ii++) {
+    if (upper(ii) < lower_(ii) + bound(ii) ||
+        lower(ii) > upper_(ii) - bound(ii))
+      return true;
+  }
+
+  return false;
+}
+
 // Inherited from Environment, but can be overwritten by child classes.
 // Returns true if the state is a valid configuration.
 // Takes in incoming and outgoing value functions. See planner.h for details.
@@ -84,33 +143,103 @@ bool Box::IsValid(const Vector3d& position,
   }
 #endif
 
-  // Make sure server is up.
-  if (!switching_bound_srv_) {
-    ROS_WARN("%s: Switching bound server disconnected.", name_.c_str());
-
-    ros::NodeHandle nl;
-    switching_bound_srv_ = nl.serviceClient<value_function_srvs::SwitchingTrackingBoundBox>(
-      switching_bound_name_.c_str(), true);
+  // No obstacles. Just check bounds.
+  Vector3d bound;
+  if (!SwitchingBound(incoming_value, outgoing_value, bound))
     return false;
+
+  return InBounds(position, bound);
+}
+
+// Inherited from Environment, but can be overwritten by child classes.
+// Looks up the tracking bound once for the whole batch.
+void Box::IsValidBatch(const std::vector<Vector3d>& points,
+                       ValueFunctionId incoming_value,
+                       ValueFunctionId outgoing_value,
+                       std::vector<bool>& out_mask) const {
+  out_mask.assign(points.size(), false);
+
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (!initialized_) {
+    ROS_WARN("%s: Tried to collision check an uninitialized Box.",
+             name_.c_str());
+    return;
   }
+#endif
 
-  // No obstacles. Just check bounds.
-  value_function_srvs::SwitchingTrackingBoundBox bound;
-  bound.request.from_id = incoming_value;
-  bound.request.to_id = outgoing_value;
-  if (!switching_bound_srv_.call(bound)) {
+  Vector3d bound;
+  if (!SwitchingBound(incoming_value, outgoing_value, bound))
+    return;
+
+  for (size_t ii = 0; ii < points.size(); ii++)
+    out_mask[ii] = InBounds(points[ii], bound);
+}
+
+// Request the switching tracking bound for every pair of the given number
+// of value functions up front. Pairs the server does not know about are
+// skipped, and will be requested again if they are ever used.
+size_t Box::CacheSwitchingBounds(size_t num_values) {
+  size_t num_cached = 0;
+  for (ValueFunctionId ii = 0; ii < num_values; ii++) {
+    for (ValueFunctionId jj = 0; jj < num_values; jj++) {
+      Vector3d bound;
+      if (SwitchingBound(ii, jj, bound))
+        num_cached++;
+    }
+  }
+
+  return num_cached;
+}
+
+// Query the switching tracking bound for this pair of value functions.
+// Returns false if the server could not be reached. Lookups read the
+// current version of the cache without locking.
+bool Box::SwitchingBound(ValueFunctionId incoming_value,
+                         ValueFunctionId outgoing_value,
+                         Vector3d& bound) const {
+  const std::shared_ptr<const BoundMap> cache =
+    std::atomic_load(&bound_cache_);
+
+  const auto iter = cache->find(std::make_pair(incoming_value, outgoing_value));
+  if (iter != cache->end()) {
+    bound = iter->second;
+    return true;
+  }
+
+  return RequestSwitchingBound(incoming_value, outgoing_value, bound);
+}
+
+// Ask the server for the switching tracking bound for this pair of value
+// functions, and add it to the cache. The persistent service client may not
+// be shared between threads, so each request opens its own connection. This
+// only happens for pairs that were not cached up front.
+bool Box::RequestSwitchingBound(ValueFunctionId incoming_value,
+                                ValueFunctionId outgoing_value,
+                                Vector3d& bound) const {
+  value_function_srvs::SwitchingTrackingBoundBox b;
+  b.request.from_id = incoming_value;
+  b.request.to_id = outgoing_value;
+  if (!ros::service::call(switching_bound_name_, b)) {
     ROS_ERROR("%s: Error calling switching bound server.", name_.c_str());
     return false;
   }
 
-  if (position(0) < lower_(0) + bound.response.x ||
-      position(0) > upper_(0) - bound.response.x ||
-      position(1) < lower_(1) + bound.response.y ||
-      position(1) > upper_(1) - bound.response.y ||
-      position(2) < lower_(2) + bound.response.z ||
-      position(2) > upper_(2) - bound.response.z)
-      return false;
+  bound = Vector3d(b.response.x, b.response.y, b.response.z);
+
+  // Publish a copy of the cache with this bound added. Another thread may
+  // have beaten us to it, in which case there is nothing to do.
+  std::lock_guard<std::mutex> lock(bound_write_mutex_);
+  const std::shared_ptr<const BoundMap> cache =
+    std::atomic_load(&bound_cache_);
+
+  const std::pair<ValueFunctionId, ValueFunctionId> key(
+    incoming_value, outgoing_value);
+  if (cache->count(key) > 0)
+    return true;
 
+  const std::shared_ptr<BoundMap> next(new BoundMap(*cache));
+  next->insert({ key, bound });
+  std::atomic_store(&bound_cache_, std::shared_ptr<const BoundMap>(next));
   return true;
 }
 
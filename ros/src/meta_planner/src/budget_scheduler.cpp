@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the BudgetScheduler class, which chooses how much time to give
+// each Planner for each call. Calls are grouped into cells by planner,
+// segment length, and number of nearby obstacles. Within each cell, the
+// scheduler estimates the distribution of time-to-success from past calls
+// (Kaplan-Meier, treating failed and cancelled calls as censored) and picks
+// the budget which maximizes expected successes per second of planning.
+// Every so often a call is given the maximum budget instead.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/budget_scheduler.h>
+
+#include <algorithm>
+#include <fstream>
+#include <math.h>
+
+namespace meta {
+
+const size_t BudgetScheduler::kNumLengthBins;
+const size_t BudgetScheduler::kNumDensityBins;
+const size_t BudgetScheduler::kNumBuckets;
+const size_t BudgetScheduler::kMinAttempts;
+const size_t BudgetScheduler::kExplorationPeriod;
+
+// Factory method.
+BudgetScheduler::Ptr BudgetScheduler::Create(size_t num_planners,
+                                             double max_length,
+                                             double default_budget,
+                                             double max_budget) {
+  BudgetScheduler::Ptr ptr(new BudgetScheduler(
+    num_planners, max_length, default_budget, max_budget));
+  return ptr;
+}
+
+// Constructor.
+BudgetScheduler::BudgetScheduler(size_t num_planners, double max_length,
+                                 double default_budget, double max_budget)
+  : num_planners_(num_planners),
+    max_length_(max_length),
+    default_budget_(default_budget),
+    max_budget_(max_budget),
+    bucket_width_(max_budget / kNumBuckets),
+    cells_(num_planners * kNumLengthBins * kNumDensityBins) {}
+
+// Budget (seconds) for a planner to plan a segment of the given length,
+// with the given number of obstacles nearby. Calls never run past their
+// budget, so without the occasional maximum budget nothing would ever be
+// learned about longer ones and budgets could only shrink.
+double BudgetScheduler::Budget(size_t planner_id, double length,
+                               size_t num_nearby) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Cell& cell = cells_[CellIndex(planner_id, length, num_nearby)];
+
+  cell.num_budgets_++;
+  if (cell.num_budgets_ % kExplorationPeriod == 0)
+    return max_budget_;
+
+  return CellBudget(cell);
+}
+
+// Record a call which ran for the given time before it succeeded, failed,
+// or was cancelled.
+void BudgetScheduler::Record(size_t planner_id, double length,
+                             size_t num_nearby, double elapsed,
+                             bool succeeded) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Cell& cell = cells_[CellIndex(planner_id, length, num_nearby)];
+
+  // The call was running at the start of every bucket up to and including
+  // the one it stopped in.
+  const size_t last_bucket = std::min(
+    static_cast<size_t>(std::max(elapsed, 0.0) / bucket_width_),
+    kNumBuckets - 1);
+
+  for (size_t ii = 0; ii <= last_bucket; ii++)
+    cell.exposures_[ii] += 1.0;
+
+  cell.num_attempts_++;
+  if (succeeded && elapsed <= max_budget_) {
+    cell.successes_[last_bucket] += 1.0;
+    cell.num_successes_++;
+    cell.total_success_latency_ += elapsed;
+  }
+}
+
+// Index of the cell for the given planner, length, and density.
+size_t BudgetScheduler::CellIndex(size_t planner_id, double length,
+                                  size_t num_nearby) const {
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (planner_id >= num_planners_) {
+    ROS_ERROR("BudgetScheduler: planner id %zu is out of range.", planner_id);
+    planner_id = num_planners_ - 1;
+  }
+#endif
+
+  const size_t length_bin = std::min(static_cast<size_t>(
+    kNumLengthBins * std::max(length, 0.0) / max_length_),
+    kNumLengthBins - 1);
+
+  // Densities are binned logarithmically: 0, 1, 2-3, 4+ obstacles.
+  const size_t density_bin = std::min(static_cast<size_t>(
+    std::log2(static_cast<double>(num_nearby) + 1.0)), kNumDensityBins - 1);
+
+  return (planner_id * kNumLengthBins + length_bin) * kNumDensityBins +
+    density_bin;
+}
+
+// Budget for the given cell. Assumes the lock is held.
+double BudgetScheduler::CellBudget(const Cell& cell) const {
+  if (cell.num_attempts_ < kMinAttempts || cell.num_successes_ == 0)
+    return default_budget_;
+
+  // Walk through the buckets, tracking the probability that a call is
+  // still running (survival) and the expected time spent on a call if it
+  // were cut off at the end of the current bucket. Expected successes per
+  // second is the ratio of success probability to expected time.
+  double survival = 1.0;
+  double expected_time = 0.0;
+  double best_rate = 0.0;
+  double best_budget = default_budget_;
+
+  for (size_t ii = 0; ii < kNumBuckets; ii++) {
+    if (cell.exposures_[ii] <= 0.0)
+      break;
+
+    const double hazard = cell.successes_[ii] / cell.exposures_[ii];
+
+    // Successful calls in this bucket stop halfway through on average.
+    expected_time += bucket_width_ * survival * (1.0 - 0.5 * hazard);
+    survival *= 1.0 - hazard;
+
+    const double rate = (1.0 - survival) / expected_time;
+    if (rate > best_rate) {
+      best_rate = rate;
+      best_budget = bucket_width_ * (ii + 1);
+    }
+  }
+
+  return best_budget;
+}
+
+// Load statistics from a file.
+bool BudgetScheduler::Load(const std::string& file_name) {
+  std::ifstream file(file_name.c_str());
+  if (!file.is_open())
+    return false;
+
+  size_t num_planners, num_length_bins, num_density_bins, num_buckets;
+  double max_budget;
+  if (!(file >> num_planners >> num_length_bins >> num_density_bins >>
+        num_buckets >> max_budget) ||
+      num_planners != num_planners_ ||
+      num_length_bins != kNumLengthBins ||
+      num_density_bins != kNumDensityBins ||
+      num_buckets != kNumBuckets ||
+      std::abs(max_budget - max_budget_) > 1e-8) {
+    ROS_WARN("BudgetScheduler: %s does not match this configuration.",
+             file_name.c_str());
+    return false;
+  }
+
+  std::vector<Cell> cells(cells_.size());
+  for (auto& cell : cells) {
+    if (!(file >> cell.num_attempts_ >> cell.num_successes_ >>
+          cell.total_success_latency_)) {
+      ROS_WARN("BudgetScheduler: %s is truncated.", file_name.c_str());
+      return false;
+    }
+
+    for (size_t ii = 0; ii < kNumBuckets; ii++)
+      file >> cell.exposures_[ii] >> cell.successes_[ii];
+  }
+
+  if (!file) {
+    ROS_WARN("BudgetScheduler: %s is truncated.", file_name.c_str());
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  cells_.swap(cells);
+  return true;
+}
+
+// Save statistics to a file.
+bool BudgetScheduler::Save(const std::string& file_name) const {
+  std::ofstream file(file_name.c_str());
+  if (!file.is_open())
+    return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  file.precision(17);
+  file << num_planners_ << " " << kNumLengthBins << " " << kNumDensityBins
+       << " " << kNumBuckets << " " << max_budget_ << std::endl;
+
+  for (const auto& cell : cells_) {
+    file << cell.num_attempts_ << " " << cell.num_successes_ << " "
+         << cell.total_success_latency_;
+
+    for (size_t ii = 0; ii < kNumBuckets; ii++)
+      file << " " << cell.exposures_[ii] << " " << cell.successes_[ii];
+
+    file << std::endl;
+  }
+
+  return static_cast<bool>(file);
+}
+
+// Convert to ROS message.
+meta_planner_msgs::BudgetStatistics BudgetScheduler::ToRosMessage() const {
+  meta_planner_msgs::BudgetStatistics msg;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t ii = 0; ii < num_planners_; ii++) {
+    for (size_t jj = 0; jj < kNumLengthBins; jj++) {
+      for (size_t kk = 0; kk < kNumDensityBins; kk++) {
+        const Cell& cell =
+          cells_[(ii * kNumLengthBins + jj) * kNumDensityBins + kk];
+
+        msg.planner_ids.push_back(ii);
+        msg.length_bins.push_back(jj);
+        msg.density_bins.push_back(kk);
+        msg.num_attempts.push_back(cell.num_attempts_);
+        msg.num_successes.push_back(cell.num_successes_);
+        msg.mean_success_latencies.push_back((cell.num_successes_ > 0) ?
+          cell.total_success_latency_ / cell.num_successes_ : 0.0);
+        msg.budgets.push_back(CellBudget(cell));
+      }
+    }
+  }
+
+  return msg;
+}
+
+} //\namespace meta
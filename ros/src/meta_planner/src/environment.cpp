@@ -62,6 +62,16 @@ bool Environment::Initialize(const ros::NodeHandle& n) {
   return true;
 }
 
+// Batch collision checker. Default implementation checks points one by one.
+void Environment::IsValidBatch(const std::vector<Vector3d>& points,
+                               ValueFunctionId incoming_value,
+                               ValueFunctionId outgoing_value,
+                               std::vector<bool>& out_mask) const {
+  out_mask.resize(points.size());
+  for (size_t ii = 0; ii < points.size(); ii++)
+    out_mask[ii] = IsValid(points[ii], incoming_value, outgoing_value);
+}
+
 // Load all parameters.
 bool Environment::LoadParameters(const ros::NodeHandle& n) {
   ros::NodeHandle nl(n);
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the Frontier class, a priority queue of the waypoints in a
+// WaypointTree ranked by arrival time plus a lower bound on the time from
+// there to the goal. Taking a waypoint puts it back at a lower rank, so that
+// the most promising waypoints are expanded most often but none forever.
+// Waypoints may be pushed and taken from multiple threads at once.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/frontier.h>
+
+namespace meta {
+
+// Factory method. Use this instead of the constructor.
+Frontier::Ptr Frontier::Create() {
+  Ptr ptr(new Frontier());
+  return ptr;
+}
+
+// Remove all waypoints.
+void Frontier::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  queue_ = std::priority_queue<
+    Entry, std::vector<Entry>, std::greater<Entry> >();
+}
+
+// Add a waypoint, given its arrival time plus a lower bound on the time
+// from there to the goal.
+void Frontier::Push(const Waypoint::ConstPtr& waypoint, double cost) {
+  const Entry entry = { cost, cost, 0, waypoint };
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  queue_.push(entry);
+}
+
+// Take the most promising waypoint, or null if there are none. Each time a
+// waypoint is taken, its priority grows by its cost, so a waypoint taken k
+// times competes with fresh ones costing k + 1 times as much.
+Waypoint::ConstPtr Frontier::Next(double& cost) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (queue_.empty())
+    return nullptr;
+
+  Entry entry = queue_.top();
+  queue_.pop();
+
+  cost = entry.cost_;
+
+  entry.num_taken_++;
+  entry.priority_ = entry.cost_ * static_cast<double>(entry.num_taken_ + 1);
+  queue_.push(entry);
+
+  return entry.waypoint_;
+}
+
+// Number of waypoints.
+size_t Frontier::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size();
+}
+
+} //\namespace meta
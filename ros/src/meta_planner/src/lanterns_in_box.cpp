@@ -38,7 +38,8 @@
 //
 // Defines a Box environment with spherical obstacles. For simplicity, this
 // does not bother with a kdtree index to speed up collision queries, since
-// it is only for a simulated demo.
+// it is only for a simulated demo. Lanterns move at constant velocity, so
+// future collision checks are made against their predicted positions.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -55,6 +56,9 @@ LanternsInBox::Ptr LanternsInBox::Create() {
 // Constructor. Don't use this. Use the factory method instead.
 LanternsInBox::LanternsInBox()
   : Box(),
+    velocity_smoothing_(1.0),
+    prediction_horizon_(0.0),
+    prediction_bin_dt_(0.0),
     tf_listener_(tf_buffer_) {}
 
 // Initialize this environment.
@@ -92,11 +96,23 @@ bool LanternsInBox::LoadParameters(const ros::NodeHandle& n) {
   // Frames.
   if (!nl.getParam("frames/fixed", fixed_frame_id_)) return false;
   if (!nl.getParam("frames/lanterns", lantern_frame_ids_)) return false;
-  points_.resize(lantern_frame_ids_.size());
+
+  const size_t num_lanterns = lantern_frame_ids_.size();
+  last_points_.resize(num_lanterns, Vector3d::Zero());
+  last_stamps_.resize(num_lanterns, -1.0);
+  velocities_.resize(num_lanterns, Vector3d::Zero());
 
   // Radius of lanterns.
   if (!nl.getParam("lantern/radius", radius_)) return false;
 
+  // Motion model.
+  if (!nl.getParam("lantern/velocity_smoothing", velocity_smoothing_))
+    return false;
+  if (!nl.getParam("obstacles/prediction_horizon", prediction_horizon_))
+    return false;
+  if (!nl.getParam("obstacles/prediction_bin_dt", prediction_bin_dt_))
+    return false;
+
   return true;
 }
 
@@ -132,6 +148,7 @@ void LanternsInBox::UpdateLanternPositions() {
 
   // Get the current transform from tf.
   geometry_msgs::TransformStamped tf;
+  bool updated = false;
 
   for (size_t ii = 0; ii < lantern_frame_ids_.size(); ii++) {
     try {
@@ -145,10 +162,58 @@ void LanternsInBox::UpdateLanternPositions() {
     }
 
     // Extract translation.
-    points_[ii] = Vector3d(tf.transform.translation.x,
-                           tf.transform.translation.y,
-                           tf.transform.translation.z);
+    const Vector3d point(tf.transform.translation.x,
+                         tf.transform.translation.y,
+                         tf.transform.translation.z);
+    const double stamp = tf.header.stamp.toSec();
+
+    // Update the velocity estimate by finite differences, but only if tf
+    // actually has a newer pose for this lantern.
+    if (last_stamps_[ii] >= 0.0) {
+      const double dt = stamp - last_stamps_[ii];
+      if (dt <= 1e-8)
+        continue;
+
+      const Vector3d velocity = (point - last_points_[ii]) / dt;
+      velocities_[ii] = velocity_smoothing_ * velocity +
+        (1.0 - velocity_smoothing_) * velocities_[ii];
+    }
+
+    last_points_[ii] = point;
+    last_stamps_[ii] = stamp;
+    updated = true;
   }
+
+  if (!updated)
+    return;
+
+  // Publish a new version of the motion models, and index the volumes the
+  // lanterns are predicted to sweep out from now on. Lanterns which are
+  // barely moving are treated as static, so that tf jitter does not make
+  // them look like moving obstacles.
+  const double kStaticSpeed = 0.05;
+
+  obstacles_.Update([&](ObstacleStore& obstacles) {
+      for (size_t ii = 0; ii < lantern_frame_ids_.size(); ii++) {
+        if (last_stamps_[ii] < 0.0)
+          continue;
+
+        const Vector3d velocity = (velocities_[ii].norm() < kStaticSpeed) ?
+          Vector3d::Zero() : velocities_[ii];
+
+        const int jj = obstacles.Find(ii);
+        if (jj < 0)
+          obstacles.Add(ii, last_points_[ii], radius_, velocity,
+                        last_stamps_[ii]);
+        else
+          obstacles.SetMotion(jj, last_points_[ii], velocity,
+                              last_stamps_[ii]);
+      }
+
+      obstacles.BuildSweptIndex(
+        right_now.toSec(), prediction_horizon_, prediction_bin_dt_);
+      return true;
+    });
 }
 
 // Timer callback to update lantern positions.
@@ -169,80 +234,82 @@ bool LanternsInBox::IsValid(const Vector3d& position,
   }
 #endif
 
-  // Make sure server is up.
-  if (!switching_bound_srv_) {
-    ROS_WARN("%s: Switching bound server disconnected.", name_.c_str());
+  Vector3d bound;
+  if (!SwitchingBound(incoming_value, outgoing_value, bound))
+    return false;
 
-    ros::NodeHandle nl;
-    switching_bound_srv_ = nl.serviceClient<value_function_srvs::SwitchingTrackingBoundBox>(
-      switching_bound_name_.c_str(), true);
+  // Check bounds, then check against each lantern.
+  if (!InBounds(position, bound))
+    return false;
 
+  return obstacles_.Get()->CheckPoint(position, bound);
+}
+
+// Spatio-temporal collision checker. Checks against the predicted
+// positions of all lanterns at the given time.
+bool LanternsInBox::IsValid(const Vector3d& position, double time,
+                            ValueFunctionId incoming_value,
+                            ValueFunctionId outgoing_value) const {
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (!initialized_) {
+    ROS_WARN("%s: Tried to collision check an uninitialized LanternsInBox.",
+             name_.c_str());
     return false;
   }
+#endif
 
-  // No obstacles. Just check bounds.
-  value_function_srvs::SwitchingTrackingBoundBox bound;
-  bound.request.from_id = incoming_value;
-  bound.request.to_id = outgoing_value;
-  if (!switching_bound_srv_.call(bound)) {
-    ROS_ERROR("%s: Error calling switching bound server.", name_.c_str());
+  Vector3d bound;
+  if (!SwitchingBound(incoming_value, outgoing_value, bound))
     return false;
-  }
 
-  if (position(0) < lower_(0) + bound.response.x ||
-      position(0) > upper_(0) - bound.response.x ||
-      position(1) < lower_(1) + bound.response.y ||
-      position(1) > upper_(1) - bound.response.y ||
-      position(2) < lower_(2) + bound.response.z ||
-      position(2) > upper_(2) - bound.response.z)
+  if (!InBounds(position, bound))
     return false;
 
-  // Check against each obstacle.
-  const Vector3d bound_vector(
-    bound.response.x, bound.response.y, bound.response.z);
+  return obstacles_.Get()->CheckPoint(position, time, bound);
+}
 
-  for (size_t ii = 0; ii < points_.size(); ii++) {
-    const Vector3d& p = points_[ii];
+// Checks for obstacles within a sensing radius. Returns true if at least
+// one obstacle was found.
+bool LanternsInBox::SenseObstacles(const Vector3d& position, double sensor_radius,
+                                std::vector<Vector3d>& obstacle_positions,
+                                std::vector<double>& obstacle_radii) const {
+  obstacle_positions.clear();
+  obstacle_radii.clear();
 
-    // Compute signed distance between position and obstacle center.
-    const Vector3d signed_distance = p - position;
+  const ObstacleStore::ConstPtr obstacles = obstacles_.Current();
+  for (size_t ii = 0; ii < obstacles->Size(); ii++){
+    const Vector3d point = obstacles->Point(ii);
 
-    // Find closest point in the tracking bound to the obstacle center.
-    Vector3d closest_point;
-    for (size_t jj = 0; jj < 3; jj++) {
-      if (signed_distance(jj) >= 0.0) {
-        if (signed_distance(jj) >= bound_vector(jj))
-          closest_point(jj) = position(jj) + bound_vector(jj);
-        else
-          closest_point(jj) = p(jj);
-      } else {
-        if (signed_distance(jj) <= -bound_vector(jj))
-          closest_point(jj) = position(jj) - bound_vector(jj);
-        else
-          closest_point(jj) = p(jj);
-      }
+    if ((position - point).norm() <= radius_ + sensor_radius) {
+      obstacle_positions.push_back(point);
+      obstacle_radii.push_back(radius_);
     }
-
-    // Check distance to closest point.
-    if ((closest_point - p).norm() <= radius_)
-      return false;
   }
 
-  return true;
+  return obstacle_positions.size() > 0;
 }
 
-
-// Checks for obstacles within a sensing radius. Returns true if at least
-// one obstacle was found.
-bool LanternsInBox::SenseObstacles(const Vector3d& position, double sensor_radius,
-                                std::vector<Vector3d>& obstacle_positions,
-                                std::vector<double>& obstacle_radii) const {
+// Same as above, but reports the IDs and predicted positions of all
+// obstacles at the given time, along with their estimated velocities.
+bool LanternsInBox::SenseObstacles(const Vector3d& position,
+                                   double sensor_radius, double time,
+                                   std::vector<uint64_t>& obstacle_ids,
+                                   std::vector<Vector3d>& obstacle_positions,
+                                   std::vector<Vector3d>& obstacle_velocities,
+                                   std::vector<double>& obstacle_radii) const {
+  obstacle_ids.clear();
   obstacle_positions.clear();
+  obstacle_velocities.clear();
   obstacle_radii.clear();
 
-  for (size_t ii = 0; ii < points_.size(); ii++){
-    if ((position - points_[ii]).norm() <= radius_ + sensor_radius) {
-      obstacle_positions.push_back(points_[ii]);
+  const ObstacleStore::ConstPtr obstacles = obstacles_.Current();
+  for (size_t ii = 0; ii < obstacles->Size(); ii++){
+    const Vector3d point = obstacles->PointAt(ii, time);
+
+    if ((position - point).norm() <= radius_ + sensor_radius) {
+      obstacle_ids.push_back(obstacles->Id(ii));
+      obstacle_positions.push_back(point);
+      obstacle_velocities.push_back(obstacles->Velocity(ii));
       obstacle_radii.push_back(radius_);
     }
   }
@@ -253,8 +320,9 @@ bool LanternsInBox::SenseObstacles(const Vector3d& position, double sensor_radiu
 // Checks if a given obstacle is in the environment.
 bool LanternsInBox::IsObstacle(const Vector3d& obstacle_position,
                             double obstacle_radius) const {
-  for (size_t ii = 0; ii < points_.size(); ii++)
-    if ((obstacle_position - points_[ii]).norm() < 1e-8 &&
+  const ObstacleStore::ConstPtr obstacles = obstacles_.Current();
+  for (size_t ii = 0; ii < obstacles->Size(); ii++)
+    if ((obstacle_position - obstacles->Point(ii)).norm() < 1e-8 &&
         std::abs(obstacle_radius - radius_) < 1e-8)
       return true;
 
@@ -303,7 +371,8 @@ void LanternsInBox::Visualize(const ros::Publisher& pub,
   pub.publish(cube);
 
   // Visualize obstacles as spheres.
-  for (size_t ii = 0; ii < points_.size(); ii++){
+  const ObstacleStore::ConstPtr obstacles = obstacles_.Current();
+  for (size_t ii = 0; ii < obstacles->Size(); ii++){
     visualization_msgs::Marker sphere;
     sphere.ns = "sphere";
     sphere.header.frame_id = frame_id;
@@ -322,7 +391,7 @@ void LanternsInBox::Visualize(const ros::Publisher& pub,
     sphere.color.b = 0.5;
 
     geometry_msgs::Point p;
-    const Vector3d point = points_[ii];
+    const Vector3d point = obstacles->Point(ii);
     p.x = point(0);
     p.y = point(1);
     p.z = point(2);
@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the LatticePlanner class, which inherits from Planner. It runs A*
+// over a 3D lattice anchored at the start point, moving between cells with a
+// precomputed MotionPrimitives library and guided by the best possible time
+// to the stop point. Moves are only collision checked when they would reach
+// a cell sooner than any move so far, and the number of expansions is capped,
+// so every call takes a bounded and repeatable amount of time. The stop point
+// is joined with a straight line from the cell containing it, or from any
+// cell next to that one.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/lattice_planner.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace meta {
+
+namespace {
+
+typedef std::array<int, 3> Cell;
+
+// Cells are packed into 21 bits per axis, relative to the start cell.
+const int kCellOffset = 1 << 20;
+
+inline uint64_t Pack(const Cell& cell) {
+  return (static_cast<uint64_t>(cell[0] + kCellOffset) << 42) |
+    (static_cast<uint64_t>(cell[1] + kCellOffset) << 21) |
+    static_cast<uint64_t>(cell[2] + kCellOffset);
+}
+
+// Marks an unused slot. No packed cell has every bit set.
+const uint64_t kEmpty = ~static_cast<uint64_t>(0);
+
+// Hash table from packed cells to indices, with open addressing and linear
+// probing in one flat array. Entries are never removed during a search.
+class CellTable {
+public:
+  explicit CellTable(size_t expected_size)
+    : size_(0) {
+    size_t capacity = 16;
+    while (capacity < 2 * expected_size)
+      capacity *= 2;
+
+    slots_.assign(capacity, Slot(kEmpty, 0));
+  }
+
+  // Insert a key with the given value, unless it is already there. Returns
+  // the value stored for the key, and whether it was inserted.
+  std::pair<uint32_t, bool> Insert(uint64_t key, uint32_t value) {
+    if (2 * (size_ + 1) > slots_.size())
+      Grow();
+
+    size_t ii = Hash(key);
+    while (slots_[ii].first != kEmpty) {
+      if (slots_[ii].first == key)
+        return std::make_pair(slots_[ii].second, false);
+
+      ii = (ii + 1) & (slots_.size() - 1);
+    }
+
+    slots_[ii] = Slot(key, value);
+    size_++;
+    return std::make_pair(value, true);
+  }
+
+  // Value stored for a key which must be in the table.
+  uint32_t At(uint64_t key) const {
+    size_t ii = Hash(key);
+    while (slots_[ii].first != key)
+      ii = (ii + 1) & (slots_.size() - 1);
+
+    return slots_[ii].second;
+  }
+
+private:
+  typedef std::pair<uint64_t, uint32_t> Slot;
+
+  // Fibonacci hashing onto a power-of-two number of slots.
+  inline size_t Hash(uint64_t key) const {
+    return static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> 32) &
+      (slots_.size() - 1);
+  }
+
+  // Double the number of slots and reinsert everything.
+  void Grow() {
+    std::vector<Slot> old_slots(2 * slots_.size(), Slot(kEmpty, 0));
+    old_slots.swap(slots_);
+    size_ = 0;
+
+    for (const auto& slot : old_slots) {
+      if (slot.first != kEmpty)
+        Insert(slot.first, slot.second);
+    }
+  }
+
+  std::vector<Slot> slots_;
+  size_t size_;
+};
+
+// Best known time to reach a cell, and whether it has been expanded.
+struct CellRecord {
+  double g_;
+  bool closed_;
+};
+
+// A way of reaching a cell: from which node, with which primitive, and when.
+struct Node {
+  Cell cell_;
+  uint32_t parent_;
+  uint32_t primitive_;
+  double g_;
+};
+
+const uint32_t kNoParent = std::numeric_limits<uint32_t>::max();
+
+// An entry in the open list. Ties in f are broken toward the stop point,
+// since the L-infinity heuristic leaves many cells with equal f.
+struct Entry {
+  double f_;
+  double h_;
+  uint32_t node_;
+
+  Entry(double f, double h, uint32_t node)
+    : f_(f), h_(h), node_(node) {}
+
+  inline bool operator>(const Entry& other) const {
+    if (f_ != other.f_) return f_ > other.f_;
+    if (h_ != other.h_) return h_ > other.h_;
+    return node_ > other.node_;
+  }
+};
+
+// Number of expansions between checks of the clock.
+const size_t kClockInterval = 32;
+
+// Joins to the stop point shorter than this (seconds) are dropped.
+const double kMinDuration = 1e-9;
+
+} //\namespace
+
+LatticePlanner::LatticePlanner(ValueFunctionId incoming_value,
+                               ValueFunctionId outgoing_value,
+                               const Box::ConstPtr& space,
+                               const Dynamics::ConstPtr& dynamics,
+                               const MotionPrimitives::ConstPtr& primitives,
+                               size_t max_expansions)
+  : Planner(incoming_value, outgoing_value, space, dynamics),
+    primitives_(primitives),
+    max_expansions_(max_expansions) {}
+
+// Factory method. Use this instead of the constructor.
+Planner::Ptr LatticePlanner::
+Create(ValueFunctionId incoming_value,
+       ValueFunctionId outgoing_value,
+       const Box::ConstPtr& space,
+       const Dynamics::ConstPtr& dynamics,
+       const MotionPrimitives::ConstPtr& primitives,
+       size_t max_expansions) {
+  Planner::Ptr ptr(new LatticePlanner(incoming_value, outgoing_value,
+                                      space, dynamics, primitives,
+                                      max_expansions));
+  return ptr;
+}
+
+// Plan a trajectory between two points.
+Trajectory::Ptr LatticePlanner::
+Plan(const Vector3d& start, const Vector3d& stop,
+     double start_time, double budget) const {
+  const std::atomic<bool> cancel(false);
+  return Plan(start, stop, start_time, budget, cancel);
+}
+
+// Same as above, but give up as soon as cancel becomes true.
+Trajectory::Ptr LatticePlanner::
+Plan(const Vector3d& start, const Vector3d& stop,
+     double start_time, double budget,
+     const std::atomic<bool>& cancel) const {
+  const double end_time = ros::Time::now().toSec() + budget;
+
+  if (!space_->IsValid(start, start_time, incoming_value_, outgoing_value_))
+    return nullptr;
+
+  const double resolution = primitives_->Resolution();
+  const std::vector<MotionPrimitives::Primitive>& moves =
+    primitives_->Primitives();
+  const Vector3d& lower = space_->LowerBounds();
+  const Vector3d& upper = space_->UpperBounds();
+
+  // Cell containing the stop point.
+  const Vector3d goal_offset = (stop - start) / resolution;
+  const Cell goal = {{ static_cast<int>(std::round(goal_offset(0))),
+                       static_cast<int>(std::round(goal_offset(1))),
+                       static_cast<int>(std::round(goal_offset(2))) }};
+
+  // Search state. The open list may hold several entries per cell; only the
+  // one with the best time to reach the cell is expanded.
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+  std::vector<Node> nodes;
+  std::vector<CellRecord> records;
+  CellTable table(max_expansions_);
+
+  const Node root = { {{ 0, 0, 0 }}, kNoParent, 0, 0.0 };
+  nodes.push_back(root);
+  records.push_back({ 0.0, false });
+  table.Insert(Pack(root.cell_), 0);
+  const double root_h = primitives_->BestPossibleTime(start, stop);
+  open.push(Entry(root_h, root_h, 0));
+
+  // Check the straight line from a cell to the stop point, leaving the cell
+  // at the given time and taking the given duration.
+  const auto clear_to_stop = [&](const Vector3d& position, double time,
+                                 double duration) {
+    const size_t num_points = std::max<size_t>(1, static_cast<size_t>(
+      std::ceil(2.0 * (stop - position).norm() / resolution)));
+
+    std::vector<Vector3d> points;
+    std::vector<double> times;
+    for (size_t ii = 1; ii <= num_points; ii++) {
+      const double fraction =
+        static_cast<double>(ii) / static_cast<double>(num_points);
+      points.push_back(fraction * (stop - position));
+      times.push_back(fraction * duration);
+    }
+
+    return IsValidMove(position, time, points, times);
+  };
+
+  size_t num_expansions = 0;
+  while (!open.empty() && num_expansions < max_expansions_) {
+    if (cancel)
+      return nullptr;
+
+    const uint32_t node_index = open.top().node_;
+    open.pop();
+
+    const Node node = nodes[node_index];
+    CellRecord& record = records[table.At(Pack(node.cell_))];
+    if (record.closed_ || node.g_ > record.g_)
+      continue;
+
+    const Vector3d position = start + resolution *
+      Vector3d(node.cell_[0], node.cell_[1], node.cell_[2]);
+
+    record.closed_ = true;
+    num_expansions++;
+
+    if (num_expansions % kClockInterval == 0 &&
+        ros::Time::now().toSec() > end_time)
+      return nullptr;
+
+    // Try to join the stop point from the cell containing it, or from any
+    // cell next to that one, since the nearest cell may be out of bounds or
+    // blocked even when the stop point is not. If the join is clear, read
+    // back the path. Otherwise, expand the cell like any other.
+    const bool near_goal = std::abs(node.cell_[0] - goal[0]) <= 1 &&
+      std::abs(node.cell_[1] - goal[1]) <= 1 &&
+      std::abs(node.cell_[2] - goal[2]) <= 1;
+    const double duration = (near_goal) ?
+      primitives_->BestPossibleTime(position, stop) : 0.0;
+
+    if (near_goal && clear_to_stop(position, start_time + node.g_, duration)) {
+      std::vector<Vector3d> positions = { stop };
+      std::vector<double> waypoint_times = { start_time + node.g_ + duration };
+
+      // Consecutive repeats of the same primitive form one straight segment
+      // at constant speed, so only keep the cells where the move changes.
+      // The last cell is only kept if it is not already at the stop point.
+      uint32_t next_primitive = kNoParent;
+      for (uint32_t ii = node_index; ii != kNoParent; ii = nodes[ii].parent_) {
+        const Node& waypoint = nodes[ii];
+        const bool keep = (ii == node_index) ? duration > kMinDuration :
+          (waypoint.parent_ == kNoParent ||
+           waypoint.primitive_ != next_primitive);
+
+        if (keep) {
+          positions.push_back(start + resolution *
+            Vector3d(waypoint.cell_[0], waypoint.cell_[1], waypoint.cell_[2]));
+          waypoint_times.push_back(start_time + waypoint.g_);
+        }
+
+        next_primitive = waypoint.primitive_;
+      }
+
+      std::reverse(positions.begin(), positions.end());
+      std::reverse(waypoint_times.begin(), waypoint_times.end());
+
+      // Convert to full state space. Make sure to use the INCOMING VALUE!
+      const std::vector<ValueFunctionId> values(
+        positions.size(), incoming_value_);
+
+      return Trajectory::Create(
+        waypoint_times,
+        dynamics_->LiftGeometricTrajectory(positions, waypoint_times),
+        values, values);
+    }
+
+    // Push every unexpanded neighbor this move would reach sooner, as long as
+    // the move is clear. Only clear moves ever set the time to reach a cell,
+    // so a blocked move can never hide a slower route that works.
+    for (uint32_t ii = 0; ii < moves.size(); ii++) {
+      const MotionPrimitives::Primitive& move = moves[ii];
+      const Cell cell = {{ node.cell_[0] + move.offset_[0],
+                           node.cell_[1] + move.offset_[1],
+                           node.cell_[2] + move.offset_[2] }};
+
+      const Vector3d next = position + move.displacement_;
+      if ((next.array() < lower.array()).any() ||
+          (next.array() > upper.array()).any() ||
+          std::abs(cell[0]) >= kCellOffset ||
+          std::abs(cell[1]) >= kCellOffset ||
+          std::abs(cell[2]) >= kCellOffset)
+        continue;
+
+      const double g = node.g_ + move.duration_;
+      const std::pair<uint32_t, bool> inserted =
+        table.Insert(Pack(cell), static_cast<uint32_t>(records.size()));
+
+      if (inserted.second) {
+        records.push_back({ std::numeric_limits<double>::infinity(), false });
+      } else {
+        const CellRecord& neighbor = records[inserted.first];
+        if (neighbor.closed_ || g >= neighbor.g_)
+          continue;
+      }
+
+      if (!IsValidMove(position, start_time + node.g_,
+                       move.points_, move.times_))
+        continue;
+
+      records[inserted.first].g_ = g;
+
+      const Node neighbor_node = { cell, node_index, ii, g };
+      nodes.push_back(neighbor_node);
+
+      const double h = primitives_->BestPossibleTime(next, stop);
+      open.push(Entry(g + h, h, static_cast<uint32_t>(nodes.size() - 1)));
+    }
+  }
+
+  return nullptr;
+}
+
+// Check the straight line from start (reached at start_time) to
+// start + points[ii] at start_time + times[ii], for all ii.
+bool LatticePlanner::IsValidMove(const Vector3d& start, double start_time,
+                                 const std::vector<Vector3d>& points,
+                                 const std::vector<double>& times) const {
+  for (size_t ii = 0; ii < points.size(); ii++) {
+    if (!space_->IsValid(start + points[ii], start_time + times[ii],
+                         incoming_value_, outgoing_value_))
+      return false;
+  }
+
+  return true;
+}
+
+} //\namespace meta
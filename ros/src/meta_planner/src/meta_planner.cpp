@@ -98,10 +98,44 @@ bool MetaPlanner::Initialize(const ros::NodeHandle& n) {
 
   space_->Seed(seed_);
 
+  // Collision checks should never wait on the tracking bound server.
+  const size_t num_bounds = space_->CacheSwitchingBounds(num_value_functions_);
+  if (num_bounds < num_value_functions_ * num_value_functions_)
+    ROS_WARN("%s: Only cached %zu of %zu switching tracking bounds.",
+             name_.c_str(), num_bounds,
+             num_value_functions_ * num_value_functions_);
+
   // Create planners.
   for (ValueFunctionId ii = 0; ii < num_value_functions_ - 1; ii += 2) {
-    const Planner::Ptr planner =
-      OmplPlanner<og::BITstar>::Create(ii, ii + 1, space_, dynamics_);
+    // Straight lines, to try before each planner and for shortcutting.
+    const Planner::Ptr straight_line =
+      StraightLinePlanner::Create(ii, ii + 1, space_, dynamics_);
+
+    if (!straight_line->Initialize(n)) {
+      ROS_ERROR("%s: Failed to initialize straight line planner.",
+                name_.c_str());
+      return false;
+    }
+
+    straight_lines_.push_back(straight_line);
+
+    Planner::Ptr planner;
+    if (lattice_) {
+      const MotionPrimitives::ConstPtr primitives =
+        LoadMotionPrimitives(straight_line);
+
+      if (!primitives) {
+        ROS_ERROR("%s: Failed to load motion primitives.", name_.c_str());
+        return false;
+      }
+
+      planner = LatticePlanner::Create(ii, ii + 1, space_, dynamics_,
+                                       primitives, lattice_max_expansions_);
+    } else {
+      planner = OmplPlanner<og::BITstar>::Create(
+        ii, ii + 1, space_, dynamics_,
+        threads_per_query_, parallel_min_budget_);
+    }
 
     if (!planner->Initialize(n)) {
       ROS_ERROR("%s: Failed to initialize planner.", name_.c_str());
@@ -109,8 +143,62 @@ bool MetaPlanner::Initialize(const ros::NodeHandle& n) {
     }
 
     planners_.push_back(planner);
+
+    // Roadmaps, picking up where the last run left off if possible.
+    if (roadmaps_enabled_) {
+      const RoadmapPlanner::Ptr roadmap = RoadmapPlanner::Create(
+        ii, ii + 1, space_, dynamics_,
+        roadmap_max_vertices_, max_connection_radius_);
+
+      if (!roadmap->Initialize(n)) {
+        ROS_ERROR("%s: Failed to initialize roadmap.", name_.c_str());
+        return false;
+      }
+
+      const std::string file_name =
+        roadmap_directory_ + "roadmap_" + std::to_string(ii) + ".txt";
+      if (roadmap->Load(file_name))
+        ROS_INFO("%s: Loaded a roadmap of %zu vertices from %s.",
+                 name_.c_str(), roadmap->Size(), file_name.c_str());
+
+      roadmaps_.push_back(roadmap);
+      roadmap_files_.push_back(file_name);
+      roadmap_saved_sizes_.push_back(roadmap->Size());
+    }
+  }
+
+  // Grow the roadmaps whenever there is nothing else to do.
+  if (roadmaps_enabled_) {
+    roadmap_saved_time_ = ros::Time::now().toSec();
+
+    ros::NodeHandle nl(n);
+    roadmap_timer_ = nl.createTimer(ros::Duration(roadmap_grow_period_),
+                                    &MetaPlanner::GrowRoadmapsCallback, this);
+  }
+
+  // One random engine and one expansion worker per thread, plus one planner
+  // worker per planner per thread so that every candidate planner for a
+  // connection can run at the same time.
+  for (size_t ii = 0; ii < num_threads_; ii++) {
+    std::seed_seq seeds = { seed_, static_cast<unsigned int>(ii) };
+    rngs_.emplace_back(seeds);
   }
 
+  shortcut_rng_.seed(seed_);
+  frontier_ = Frontier::Create();
+
+  expansion_pool_.reset(new ThreadPool(num_threads_));
+  planner_pool_.reset(new ThreadPool(num_threads_ * planners_.size()));
+
+  // Budget scheduler. Start from the old heuristic of 10% of the total
+  // runtime per call, and allow up to twice that. Pick up where the last
+  // run left off, if possible.
+  budgets_ = BudgetScheduler::Create(planners_.size(), max_connection_radius_,
+                                     0.1 * max_runtime_, 0.2 * max_runtime_);
+  if (!budget_file_.empty() && budgets_->Load(budget_file_))
+    ROS_INFO("%s: Loaded planning budget statistics from %s.",
+             name_.c_str(), budget_file_.c_str());
+
   // Set OMPL log level.
   ompl::msg::setLogLevel(ompl::msg::LogLevel::LOG_ERROR);
 
@@ -136,6 +224,46 @@ bool MetaPlanner::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("max_connection_radius", max_connection_radius_))
     return false;
 
+  int num_threads = 1;
+  if (!nl.getParam("num_threads", num_threads)) return false;
+  num_threads_ = static_cast<size_t>(std::max(num_threads, 1));
+
+  if (!nl.getParam("budget/statistics_file", budget_file_)) return false;
+  if (!nl.getParam("straight_line/enabled", straight_lines_enabled_))
+    return false;
+  if (!nl.getParam("shortcut/enabled", shortcut_)) return false;
+
+  if (!nl.getParam("best_first/enabled", best_first_)) return false;
+  if (!nl.getParam("best_first/random_fraction", random_fraction_))
+    return false;
+  random_fraction_ = std::min(std::max(random_fraction_, 0.0), 1.0);
+
+  if (!nl.getParam("lazy/enabled", lazy_)) return false;
+
+  if (!nl.getParam("roadmap/enabled", roadmaps_enabled_)) return false;
+  if (!nl.getParam("roadmap/directory", roadmap_directory_)) return false;
+  if (!nl.getParam("roadmap/grow_period", roadmap_grow_period_))
+    return false;
+
+  int max_vertices = 1;
+  if (!nl.getParam("roadmap/max_vertices", max_vertices)) return false;
+  roadmap_max_vertices_ = static_cast<size_t>(std::max(max_vertices, 1));
+
+  int max_step = 1, max_expansions = 1;
+  if (!nl.getParam("lattice/enabled", lattice_)) return false;
+  if (!nl.getParam("lattice/directory", lattice_directory_)) return false;
+  if (!nl.getParam("lattice/resolution", lattice_resolution_)) return false;
+  if (!nl.getParam("lattice/max_step", max_step)) return false;
+  if (!nl.getParam("lattice/max_expansions", max_expansions)) return false;
+  lattice_max_step_ = static_cast<size_t>(max_step);
+  lattice_max_expansions_ = static_cast<size_t>(max_expansions);
+
+  if (!nl.getParam("deadline/enabled", deadline_mode_)) return false;
+  if (!nl.getParam("deadline/publish_margin", publish_margin_)) return false;
+  if (!nl.getParam("deadline/min_slack", min_slack_)) return false;
+  if (!nl.getParam("anytime/enabled", anytime_)) return false;
+  if (!nl.getParam("anytime/optimality_gap", optimality_gap_)) return false;
+
   int dimension = 1;
   if (!nl.getParam("control/dim", dimension)) return false;
   control_dim_ = static_cast<size_t>(dimension);
@@ -161,6 +289,13 @@ bool MetaPlanner::LoadParameters(const ros::NodeHandle& n) {
     return false;
   }
 
+  int threads_per_query = 1;
+  if (!nl.getParam("planners/threads_per_query", threads_per_query))
+    return false;
+  if (!nl.getParam("planners/parallel_min_budget", parallel_min_budget_))
+    return false;
+  threads_per_query_ = static_cast<size_t>(std::max(threads_per_query, 1));
+
   // State space parameters.
   if (!nl.getParam("state/dim", dimension)) return false;
   state_dim_ = static_cast<size_t>(dimension);
@@ -190,6 +325,7 @@ bool MetaPlanner::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("topics/request_traj", request_traj_topic_)) return false;
   if (!nl.getParam("topics/trigger_replan", trigger_replan_topic_)) return false;
   if (!nl.getParam("topics/in_flight", in_flight_topic_)) return false;
+  if (!nl.getParam("topics/budget_statistics", budget_topic_)) return false;
 
   if (!nl.getParam("frames/fixed", fixed_frame_id_)) return false;
 
@@ -205,6 +341,13 @@ bool MetaPlanner::RegisterCallbacks(const ros::NodeHandle& n) {
   bound_srv_ = nl.serviceClient<value_function_srvs::TrackingBoundBox>(
     bound_name_.c_str(), true);
 
+  // Tracking bounds are needed from every thread, so fetch them all before
+  // any callbacks can run.
+  if (!CacheTrackingBounds()) {
+    ROS_ERROR("%s: Failed to get tracking bounds.", name_.c_str());
+    return false;
+  }
+
   ros::service::waitForService(best_time_name_.c_str());
   best_time_srv_ = nl.serviceClient<value_function_srvs::GeometricPlannerTime>(
     best_time_name_.c_str(), true);
@@ -217,9 +360,18 @@ bool MetaPlanner::RegisterCallbacks(const ros::NodeHandle& n) {
   switching_distance_srv_ = nl.serviceClient<value_function_srvs::GuaranteedSwitchingDistance>(
     switching_distance_name_.c_str(), true);
 
-  // Subscribers.
-  sensor_sub_ = nl.subscribe(
-    sensor_topic_.c_str(), 1, &MetaPlanner::SensorCallback, this);
+  // Every expansion needs switching distances, so fetch them all up front.
+  if (!CacheSwitchingDistances()) {
+    ROS_ERROR("%s: Failed to get switching distances.", name_.c_str());
+    return false;
+  }
+
+  // Subscribers. Sensor measurements get their own queue and thread.
+  ros::NodeHandle ns(n);
+  ns.setCallbackQueue(&sensor_queue_);
+  sensor_sub_ = ns.subscribe(
+    sensor_topic_.c_str(), 10, &MetaPlanner::SensorCallback, this);
+  sensor_spinner_.start();
 
   state_sub_ = nl.subscribe(
     state_topic_.c_str(), 1, &MetaPlanner::StateCallback, this);
@@ -242,6 +394,10 @@ bool MetaPlanner::RegisterCallbacks(const ros::NodeHandle& n) {
   traj_pub_ = nl.advertise<meta_planner_msgs::Trajectory>(
     traj_topic_.c_str(), 1, false);
 
+  // Planning budget statistics, for inspection.
+  budget_pub_ = nl.advertise<meta_planner_msgs::BudgetStatistics>(
+    budget_topic_.c_str(), 1, true);
+
   return true;
 }
 
@@ -261,30 +417,199 @@ SensorCallback(const meta_planner_msgs::SensorMeasurement::ConstPtr& msg) {
   if (!in_flight_)
     return;
 
-  bool unseen_obstacle = false;
+  std::vector<Vector3d> points;
+  std::vector<Vector3d> velocities;
+  std::vector<double> radii;
 
   for (size_t ii = 0; ii < msg->num_obstacles; ii++) {
-    const double radius = msg->radii[ii];
-    const Vector3d point(msg->positions[ii].x,
-                         msg->positions[ii].y,
-                         msg->positions[ii].z);
-
-    // Check if our version of the map has already seen this point.
-    if (!(space_->IsObstacle(point, radius))) {
-      space_->AddObstacle(point, radius);
-      unseen_obstacle = true;
+    radii.push_back(msg->radii[ii]);
+    points.push_back(Vector3d(msg->positions[ii].x,
+                              msg->positions[ii].y,
+                              msg->positions[ii].z));
+  }
+
+  // Older sensors do not report velocities, stamps or IDs. Treat those
+  // obstacles as static, measured right now.
+  if (msg->velocities.size() == msg->num_obstacles) {
+    for (size_t ii = 0; ii < msg->num_obstacles; ii++)
+      velocities.push_back(Vector3d(msg->velocities[ii].x,
+                                    msg->velocities[ii].y,
+                                    msg->velocities[ii].z));
+  }
+
+  const double stamp = (msg->stamp.isZero()) ?
+    ros::Time::now().toSec() : msg->stamp.toSec();
+
+  bool unseen_obstacle = false;
+  std::vector<size_t> changed;
+
+  if (msg->ids.size() == msg->num_obstacles) {
+    // Incremental update. Look obstacles up by ID. If we have missed any
+    // messages, the next full resync will catch us up.
+    if (!msg->full_resync && msg->sequence != last_sensor_sequence_ + 1)
+      ROS_WARN_THROTTLE(1.0, "%s: Missed %ld sensor messages.", name_.c_str(),
+                        static_cast<long>(msg->sequence) -
+                        static_cast<long>(last_sensor_sequence_) - 1);
+
+    last_sensor_sequence_ = msg->sequence;
+    unseen_obstacle = space_->ApplyObstacleDeltas(
+      msg->ids, points, radii, velocities, msg->removed_ids,
+      msg->full_resync, stamp, changed);
+  } else {
+    // Older sensors do not report IDs. Check if our version of the map has
+    // already seen these points, taking into account where known obstacles
+    // were predicted to be, and publish a new version of the map if
+    // anything changed.
+    unseen_obstacle =
+      space_->MergeObstacles(points, radii, velocities, stamp, changed);
+  }
+
+  // Only replan if a new or changed obstacle actually conflicts with the
+  // rest of the trajectory we are flying. Without a trajectory to check,
+  // replan whenever something new shows up. Obstacles which have not changed
+  // were already checked when they were last reported, or when the monitor
+  // was built.
+  const TrajectoryMonitor::ConstPtr monitor = std::atomic_load(&monitor_);
+
+  bool conflict = (monitor == nullptr) && unseen_obstacle;
+  for (size_t ii = 0; ii < changed.size() && monitor != nullptr; ii++) {
+    const size_t jj = changed[ii];
+    const Vector3d velocity = (velocities.size() == points.size()) ?
+      velocities[jj] : Vector3d::Zero();
+
+    if (Conflicts(*monitor, points[jj], radii[jj], velocity, stamp)) {
+      conflict = true;
+      break;
     }
   }
 
-  if (unseen_obstacle) {
-    // Trigger a replan.
+  // Trigger a replan.
+  if (conflict)
     trigger_replan_pub_.publish(std_msgs::Empty());
 
-    // Publish environment.
+  // Publish environment.
+  if (unseen_obstacle || conflict)
     space_->Visualize(env_pub_, fixed_frame_id_);
+}
+
+// Publish a new trajectory and start monitoring it for conflicts with
+// sensed obstacles, including any sensed while it was being planned.
+void MetaPlanner::PublishTrajectory(const Trajectory::ConstPtr& traj) {
+  traj_ = traj;
+  traj_pub_.publish(traj->ToRosMessage());
+
+  const TrajectoryMonitor::ConstPtr monitor = Monitor(traj);
+  if (monitor == nullptr)
+    ROS_WARN("%s: Could not monitor new trajectory.", name_.c_str());
+
+  std::atomic_store(&monitor_, monitor);
+
+  if (monitor == nullptr)
+    return;
+
+  // The sensor thread checked anything sensed during planning against the
+  // previous trajectory, so check the whole map against this one.
+  const ObstacleStore::ConstPtr obstacles = space_->Obstacles();
+  for (size_t ii = 0; ii < obstacles->Size(); ii++) {
+    if (Conflicts(*monitor, obstacles->Point(ii), obstacles->Radius(ii),
+                  obstacles->Velocity(ii), obstacles->Stamp(ii))) {
+      trigger_replan_pub_.publish(std_msgs::Empty());
+      break;
+    }
   }
 }
 
+// Build a monitor for the given trajectory. Returns null if the tracking
+// bound of any of its bound value functions is unavailable.
+TrajectoryMonitor::ConstPtr MetaPlanner::Monitor(
+  const Trajectory::ConstPtr& traj) {
+  // Look up the tracking bound of every bound value function it uses.
+  std::vector<double> times;
+  std::vector<VectorXd> states;
+  std::vector<ValueFunctionId> bound_values;
+  traj->Waypoints(times, states, bound_values);
+
+  std::map<ValueFunctionId, Vector3d> bounds;
+  for (size_t ii = 0; ii < bound_values.size(); ii++) {
+    Vector3d bound;
+    if (!TrackingBound(bound_values[ii], bound))
+      return nullptr;
+
+    bounds[bound_values[ii]] = bound;
+  }
+
+  return TrajectoryMonitor::Create(traj, dynamics_, bounds);
+}
+
+// Check a sensed obstacle against the monitored trajectory. Returns true,
+// and reports the offending segment, if they conflict.
+bool MetaPlanner::Conflicts(const TrajectoryMonitor& monitor,
+                            const Vector3d& point, double radius,
+                            const Vector3d& velocity, double stamp) const {
+  const int segment = monitor.Conflict(
+    point, radius, velocity, stamp, ros::Time::now().toSec());
+
+  if (segment < 0)
+    return false;
+
+  ROS_INFO("%s: Obstacle at (%f, %f, %f) conflicts with trajectory segment "
+           "%d of %zu (%f to %f).", name_.c_str(), point(0), point(1),
+           point(2), segment, monitor.NumSegments(),
+           monitor.SegmentStartTime(segment), monitor.SegmentStopTime(segment));
+  return true;
+}
+
+// Get the tracking bound of every value function from the server. Bounds
+// never change, so this only needs to happen once.
+bool MetaPlanner::CacheTrackingBounds() {
+  for (ValueFunctionId ii = 0; ii < num_value_functions_; ii++) {
+    value_function_srvs::TrackingBoundBox b;
+    b.request.id = ii;
+    if (!bound_srv_.call(b)) {
+      ROS_ERROR("%s: Error calling tracking bound server.", name_.c_str());
+      return false;
+    }
+
+    tracking_bounds_[ii] = Vector3d(b.response.x, b.response.y, b.response.z);
+  }
+
+  return true;
+}
+
+// Get the guaranteed switching distance of every planner, i.e. between the
+// incoming and outgoing value functions of each pair, from the server. These
+// never change, so this only needs to happen once.
+bool MetaPlanner::CacheSwitchingDistances() {
+  for (ValueFunctionId ii = 0; ii + 1 < num_value_functions_; ii += 2) {
+    value_function_srvs::GuaranteedSwitchingDistance d;
+    d.request.from_id = ii;
+    d.request.to_id = ii + 1;
+    if (!switching_distance_srv_.call(d)) {
+      ROS_ERROR("%s: Error calling switching distance server.", name_.c_str());
+      return false;
+    }
+
+    switching_distances_[std::make_pair(ii, ii + 1)] =
+      Vector3d(d.response.x, d.response.y, d.response.z);
+  }
+
+  return true;
+}
+
+// Get the tracking bound of a value function from the cache. Returns false
+// if there is no such value function.
+bool MetaPlanner::TrackingBound(ValueFunctionId value, Vector3d& bound) const {
+  const auto iter = tracking_bounds_.find(value);
+  if (iter == tracking_bounds_.end()) {
+    ROS_ERROR("%s: No tracking bound for value function %zu.",
+              name_.c_str(), value);
+    return false;
+  }
+
+  bound = iter->second;
+  return true;
+}
+
 // Callback to handle requests for new trajectory.
 void MetaPlanner::RequestTrajectoryCallback(
   const meta_planner_msgs::TrajectoryRequest::ConstPtr& msg) {
@@ -340,68 +665,131 @@ void MetaPlanner::RequestTrajectoryCallback(
   if (reached_goal_) {
     ROS_INFO("%s: Reached end of trajectory. Hovering in place.", name_.c_str());
 
-    // Same point == goal, but three times.
-    const std::vector<Vector3d> positions = { goal_, goal_, goal_ };
+    const Trajectory::Ptr hover = Hover(goal_, current_time.toSec());
+    if (hover == nullptr)
+      return;
+
+    PublishTrajectory(hover);
 
-    // Get the bound value.
-    const ValueFunctionId bound_value = (traj_ == nullptr) ?
-      planners_.front()->GetIncomingValueFunction() :
-      traj_->GetControlValueFunction(current_time.toSec());
+    // Nothing left of the previous tree is useful from here on.
+    previous_tree_.reset();
+    previous_obstacles_.reset();
+    return;
+  }
 
-    // Get control value.
-    const ValueFunctionId control_value =
-      planners_.back()->GetOutgoingValueFunction();
+  // Plan until the deadline. In deadline mode, that is when the vehicle
+  // needs the new trajectory, less a margin for publishing it. Otherwise,
+  // it is a fixed time from now.
+  const double deadline = (deadline_mode_) ?
+    start_time - publish_margin_ : current_time.toSec() + max_runtime_;
+  const double available = deadline - current_time.toSec();
 
-    // Make sure switching time server is up.
-    if (!switching_time_srv_) {
-      ROS_WARN("%s: Switching time server disconnected.", name_.c_str());
+  // If the request arrived too late to plan, answer right away.
+  if (available < min_slack_) {
+    ROS_WARN("%s: Only %2.5f seconds left to plan. Falling back.",
+             name_.c_str(), available);
 
-      ros::NodeHandle nl;
-      switching_time_srv_ = nl.serviceClient<value_function_srvs::GuaranteedSwitchingTime>(
-        switching_time_name_.c_str(), true);
-      return;
-    }
+    if (!FallBack(start_position, start_time))
+      ROS_ERROR("%s: Could not fall back.", name_.c_str());
 
-    // Get times.
-    double switching_time = 10.0;
-    value_function_srvs::GuaranteedSwitchingTime t;
-    t.request.from_id = bound_value;
-    t.request.to_id = control_value;
-    if (!switching_time_srv_.call(t))
-      ROS_ERROR("%s: Error calling switching time server.", name_.c_str());
-    else
-      switching_time = std::max(std::max(t.response.x, t.response.y),
-                                t.response.z);
-
-    const std::vector<double> times =
-      { current_time.toSec(),
-        current_time.toSec() + switching_time + 0.1,
-        current_time.toSec() + switching_time + 100.0 };
-
-    // Set up values.
-    const std::vector<ValueFunctionId> bound_values =
-      { bound_value, control_value, control_value };
-    const std::vector<ValueFunctionId> control_values =
-      { control_value, control_value, control_value };
-    const std::vector<VectorXd> states =
-      dynamics_->LiftGeometricTrajectory(positions, times);
-
-    // Construct trajectory and publish.
-    const Trajectory::Ptr hover =
-      Trajectory::Create(times, states, control_values, bound_values);
-    traj_ = hover;
-
-    traj_pub_.publish(hover->ToRosMessage());
     return;
   }
 
-  if (!Plan(start_position, goal_, start_time)) {
+  const bool planned = Plan(start_position, goal_, start_time, deadline);
+  const double used = (ros::Time::now() - current_time).toSec();
+
+  if (!planned) {
     ROS_ERROR("%s: MetaPlanner failed. Please come again.", name_.c_str());
-    return;
+
+    // The vehicle still needs something to follow at the start time.
+    if (deadline_mode_ && !FallBack(start_position, start_time))
+      ROS_ERROR("%s: Could not fall back.", name_.c_str());
   }
 
-  ROS_INFO("%s: MetaPlanner succeeded after %2.5f seconds.",
-           name_.c_str(), (ros::Time::now() - current_time).toSec());
+  // Report how much of the deadline was used.
+  ROS_INFO("%s: MetaPlanner %s after %2.5f seconds (%2.1f%% of the %2.5f "
+           "seconds available).", name_.c_str(),
+           (planned) ? "succeeded" : "failed", used,
+           100.0 * used / available, available);
+}
+
+// Publish a cheap trajectory without meta planning: the rest of the current
+// trajectory from the start time if it is still collision free, and
+// otherwise a hover at the start. Returns true if anything was published.
+bool MetaPlanner::FallBack(const Vector3d& start, double start_time) {
+  if (traj_ != nullptr && traj_->LastTime() > start_time) {
+    const Trajectory::Ptr remainder = Trajectory::Create(traj_, start_time);
+
+    if (IsClear(remainder, *space_->Obstacles(), start_time)) {
+      ROS_INFO("%s: Keeping the rest of the current trajectory.",
+               name_.c_str());
+      PublishTrajectory(remainder);
+      return true;
+    }
+  }
+
+  ROS_INFO("%s: Hovering at the start.", name_.c_str());
+  const Trajectory::Ptr hover = Hover(start, start_time);
+  if (hover == nullptr)
+    return false;
+
+  PublishTrajectory(hover);
+  return true;
+}
+
+// Hover trajectory at the given position, starting at the given time.
+// Allows enough time to switch to the least aggressive planner's value
+// function before settling. Returns null if the switching time server
+// is unavailable.
+Trajectory::Ptr MetaPlanner::Hover(const Vector3d& position, double time) {
+  // Same point, but three times.
+  const std::vector<Vector3d> positions = { position, position, position };
+
+  // Get the bound value.
+  const ValueFunctionId bound_value = (traj_ == nullptr) ?
+    planners_.front()->GetIncomingValueFunction() :
+    traj_->GetControlValueFunction(time);
+
+  // Get control value.
+  const ValueFunctionId control_value =
+    planners_.back()->GetOutgoingValueFunction();
+
+  // Make sure switching time server is up.
+  if (!switching_time_srv_) {
+    ROS_WARN("%s: Switching time server disconnected.", name_.c_str());
+
+    ros::NodeHandle nl;
+    switching_time_srv_ = nl.serviceClient<value_function_srvs::GuaranteedSwitchingTime>(
+      switching_time_name_.c_str(), true);
+    return nullptr;
+  }
+
+  // Get times.
+  double switching_time = 10.0;
+  value_function_srvs::GuaranteedSwitchingTime t;
+  t.request.from_id = bound_value;
+  t.request.to_id = control_value;
+  if (!switching_time_srv_.call(t))
+    ROS_ERROR("%s: Error calling switching time server.", name_.c_str());
+  else
+    switching_time = std::max(std::max(t.response.x, t.response.y),
+                              t.response.z);
+
+  const std::vector<double> times =
+    { time,
+      time + switching_time + 0.1,
+      time + switching_time + 100.0 };
+
+  // Set up values.
+  const std::vector<ValueFunctionId> bound_values =
+    { bound_value, control_value, control_value };
+  const std::vector<ValueFunctionId> control_values =
+    { control_value, control_value, control_value };
+  const std::vector<VectorXd> states =
+    dynamics_->LiftGeometricTrajectory(positions, times);
+
+  // Construct trajectory.
+  return Trajectory::Create(times, states, control_values, bound_values);
 }
 
 // Plan a trajectory using the given (ordered) list of Planners.
@@ -411,236 +799,1261 @@ void MetaPlanner::RequestTrajectoryCallback(
 // (4) Plan a trajectory (starting with most aggressive planner).
 // (5) Try to connect to the goal point.
 // (6) Stop when we have a feasible trajectory. Otherwise go to (2).
-// (7) When finished, convert to a message and publish.
+// (7) When finished (or, in anytime mode, whenever the best trajectory
+//     improves), convert to a message and publish.
+// Steps (2) - (6) run on several threads at once, all growing the same tree.
 bool MetaPlanner::Plan(const Vector3d& start, const Vector3d& stop,
-                       double start_time) {
+                       double start_time, double deadline) {
   // Only plan if position has been updated.
   if (!been_updated_)
     return false;
 
   // (1) Set up a new RRT-like structure to hold the meta plan.
-  const ros::Time current_time = ros::Time::now();
+  // Pin one version of the environment for the whole episode, so that
+  // obstacles sensed in the meantime cannot change it under our feet.
+  const ScopedPin pin(*space_);
+  deadline_ = deadline;
+  informed_ = planners_.front()->MaxSpeed(max_speed_);
+  num_calls_ = 0;
+  num_straight_lines_ = 0;
+  num_roadmap_paths_ = 0;
+
   const ValueFunctionId start_value = (traj_ == nullptr) ?
     planners_.back()->GetOutgoingValueFunction() :
     traj_->GetBoundValueFunction(start_time);
 
-  WaypointTree tree(start, start_value, start_time);
+  // Measure distances between waypoints as the time the fastest planner
+  // would need at best, scaled back to a length along its fastest axis. This
+  // is the weighted L-infinity distance, or plain L-infinity without speeds.
+  metric_weights_ = Vector3d::Ones();
+  if (informed_ && (max_speed_.array() > 0.0).all())
+    metric_weights_ = max_speed_.maxCoeff() * max_speed_.cwiseInverse();
+
+  const WaypointTree::Ptr tree(
+    new WaypointTree(start, start_value, start_time, metric_weights_));
+  const ObstacleStore::ConstPtr obstacles = space_->PinnedObstacles();
+
+  // Start from whatever is still valid in the previous tree.
+  const size_t num_reused =
+    ReusePreviousTree(*tree, *obstacles, start, stop, start_time);
+  if (num_reused > 0)
+    ROS_INFO("%s: Reused %zu waypoints from the previous tree.",
+             name_.c_str(), num_reused);
+
+  // In lazy mode, start the lazy tree from everything in the real tree.
+  if (lazy_) {
+    std::lock_guard<std::mutex> lock(lazy_mutex_);
+    lazy_tree_.reset(
+      new WaypointTree(start, start_value, start_time, metric_weights_));
+    realized_.clear();
+    invalidated_.clear();
+    lazy_goals_.clear();
+    num_lazy_edges_ = 0;
+    num_evaluated_edges_ = 0;
+
+    realized_[lazy_tree_->Root().get()] = tree->Root();
+    for (const auto& waypoint : tree->Waypoints()) {
+      if (waypoint == tree->Root())
+        continue;
+
+      lazy_tree_->Insert(waypoint, false);
+      realized_[waypoint.get()] = waypoint;
+    }
+  }
+
+  // Seed the frontier with everything in the tree being grown that has not
+  // yet reached the goal.
+  frontier_->Clear();
+  if (best_first_) {
+    const WaypointTree::ConstPtr grown = (lazy_) ? lazy_tree_ : tree;
+    for (const auto& waypoint : grown->Waypoints()) {
+      if (waypoint->point_ != stop)
+        PushFrontier(waypoint, stop, start_time);
+    }
+  }
+
+  // Expand the tree from every worker until time runs out, until one of
+  // them fails outright, or until the best trajectory is good enough.
+  std::atomic<bool> done(false);
+  std::atomic<bool> failed(false);
+
+  std::vector< std::future<void> > workers;
+  for (size_t ii = 0; ii < rngs_.size(); ii++) {
+    workers.push_back(expansion_pool_->Submit([&, ii]() {
+      HaltonSequence sequence(rngs_[ii]);
+      while (!done && !failed && ros::Time::now().toSec() < deadline) {
+        bool reached_goal = false;
+        if (!Expand(*tree, start, stop, start_time, sequence, rngs_[ii],
+                    reached_goal))
+          failed = true;
+      }
+    }));
+  }
+
+  // No trajectory can be faster than the fastest planner going straight
+  // to the goal.
+  const double lower_bound = planners_.front()->BestPossibleTime(start, stop);
+
+  // (7) Publish as soon as the tree reaches the goal, and again each time
+  // it finds a strictly faster trajectory (in anytime mode), until the
+  // workers are done.
+  Trajectory::ConstPtr published;
+  double considered_time = std::numeric_limits<double>::infinity();
+  const auto publish_if_better = [&]() {
+    const double best_time = tree->BestTime();
+    if (std::isinf(best_time) || best_time == considered_time)
+      return;
+
+    considered_time = best_time;
+
+    // Straighten out what the tree found, without touching anything the
+    // vehicle may already be flying.
+    const Trajectory::ConstPtr best = (shortcut_) ?
+      Shortcut(tree->BestTrajectory(),
+               std::max(start_time, ros::Time::now().toSec())) :
+      tree->BestTrajectory();
+
+    if (published != nullptr && best->LastTime() >= published->LastTime())
+      return;
+
+    // Never publish a trajectory that disagrees with what the vehicle has
+    // already been told to do.
+    if (!AgreesWithPrefix(best, start, start_time, published)) {
+      ROS_INFO_THROTTLE(1.0, "%s: Faster trajectory disagrees with the "
+                        "published prefix.", name_.c_str());
+      return;
+    }
+
+    ROS_INFO("%s: Publishing trajectory of length %zu, taking %f seconds.",
+             name_.c_str(), best->Size(), best->LastTime() - start_time);
+
+    PublishTrajectory(best);
+    published = best;
+
+    // Stop early if we are already close to the lower bound.
+    if (best->LastTime() - start_time <= (1.0 + optimality_gap_) * lower_bound)
+      done = true;
+  };
+
+  const double kPollPeriod = 0.005;
+  while (!failed && ros::Time::now().toSec() < deadline) {
+    if (anytime_)
+      publish_if_better();
+
+    if (done)
+      break;
 
-  bool found = false;
-  while ((ros::Time::now() - current_time).toSec() < max_runtime_) {
-    // (2) Sample a new point in the state space.
-    Vector3d sample = space_->Sample();
+    std::this_thread::sleep_for(std::chrono::duration<double>(kPollPeriod));
+  }
+
+  done = true;
+  for (auto& worker : workers)
+    worker.get();
+
+  if (straight_lines_enabled_)
+    ROS_INFO("%s: Straight lines resolved %zu of %zu planner calls.",
+             name_.c_str(), num_straight_lines_.load(), num_calls_.load());
+  if (roadmaps_enabled_)
+    ROS_INFO("%s: Roadmaps resolved %zu of %zu planner calls.",
+             name_.c_str(), num_roadmap_paths_.load(), num_calls_.load());
+  if (lazy_) {
+    ROS_INFO("%s: Evaluated %zu of %zu lazy edges.", name_.c_str(),
+             num_evaluated_edges_.load(), num_lazy_edges_.load());
+
+    std::lock_guard<std::mutex> lock(lazy_mutex_);
+    lazy_tree_.reset();
+    lazy_goals_.clear();
+  }
+
+  // Keep this tree around for the next replan.
+  previous_tree_ = tree;
+  previous_obstacles_ = obstacles;
+
+  // Publish whatever the workers found after the last check. Even if a
+  // worker failed, anything already published (in anytime mode) stands, so
+  // this only counts as a failure if nothing was ever published.
+  publish_if_better();
+
+  // Share what the budget scheduler has learned. Only now, so that writing
+  // the statistics to disk never delays the trajectory.
+  budget_pub_.publish(budgets_->ToRosMessage());
+  if (!budget_file_.empty() && !budgets_->Save(budget_file_))
+    ROS_WARN_THROTTLE(10.0, "%s: Could not save planning budget statistics "
+                      "to %s.", name_.c_str(), budget_file_.c_str());
+
+  return published != nullptr;
+}
+
+// Graft the part of the previous tree that lies ahead of the new start onto
+// the given tree. Trajectories are indexed by absolute time, so only the
+// waypoint whose trajectory passes through the start at the start time, and
+// its descendants, can be reused. Waypoints whose trajectories conflict with
+// obstacles that are new or have changed since the previous tree was built
+// are dropped, along with all of their descendants. Returns the number of
+// waypoints reused.
+size_t MetaPlanner::ReusePreviousTree(WaypointTree& tree,
+                                      const ObstacleStore& obstacles,
+                                      const Vector3d& start,
+                                      const Vector3d& stop,
+                                      double start_time) {
+  if (previous_tree_ == nullptr || previous_obstacles_ == nullptr)
+    return 0;
+
+  const double kTimeTolerance = 1e-6;
+  const double kPositionTolerance = 1e-3;
+
+  // Find the children of every waypoint, and the waypoint whose trajectory
+  // passes through the new start. Prefer the branch that was published.
+  const auto passes_through_start = [&](const Waypoint::ConstPtr& waypoint) {
+    const Trajectory::ConstPtr traj = waypoint->traj_;
+    return traj != nullptr &&
+      traj->FirstTime() < start_time &&
+      traj->LastTime() >= start_time - kTimeTolerance &&
+      (dynamics_->Puncture(traj->GetState(start_time)) - start).norm() <
+      kPositionTolerance;
+  };
+
+  Waypoint::ConstPtr pivot;
+  for (Waypoint::ConstPtr waypoint = previous_tree_->Terminus();
+       waypoint != nullptr; waypoint = waypoint->parent_) {
+    if (passes_through_start(waypoint)) {
+      pivot = waypoint;
+      break;
+    }
+  }
 
-    // Throw out this sample if it could never lead to a faster trajectory than
-    // the best one currently.
-    // NOTE! This test assumes that the first planner is the fastest.
-    // NOTE! If no valid trajectory has been found, the tree's best time will
-    // be infinite, so this test will automatically fail.
-    if (planners_.front()->BestPossibleTime(start, sample) +
-        planners_.front()->BestPossibleTime(sample, stop) > tree.BestTime())
+  const std::vector<Waypoint::ConstPtr> waypoints = previous_tree_->Waypoints();
+
+  std::unordered_map< const Waypoint*, std::vector<Waypoint::ConstPtr> > children;
+  for (const auto& waypoint : waypoints) {
+    if (waypoint->parent_ != nullptr)
+      children[waypoint->parent_.get()].push_back(waypoint);
+
+    if (pivot == nullptr && passes_through_start(waypoint))
+      pivot = waypoint;
+  }
+
+  if (pivot == nullptr)
+    return 0;
+
+  // Obstacles that are new, have grown, or are predicted to move
+  // differently since the previous tree.
+  const double kMotionTolerance = 1e-6;
+
+  std::vector<size_t> changed;
+  for (size_t ii = 0; ii < obstacles.Size(); ii++) {
+    const int jj = previous_obstacles_->Find(obstacles.Id(ii));
+    if (jj < 0 ||
+        obstacles.Radius(ii) > previous_obstacles_->Radius(jj) ||
+        (obstacles.PointAt(ii, start_time) -
+         previous_obstacles_->PointAt(jj, start_time)).norm() >
+        kMotionTolerance ||
+        (obstacles.Velocity(ii) - previous_obstacles_->Velocity(jj)).norm() >
+        kMotionTolerance)
+      changed.push_back(ii);
+  }
+
+  // Check whether a trajectory conflicts with any changed obstacle.
+  const auto conflicts = [&](const Trajectory::ConstPtr& traj) {
+    if (changed.empty())
+      return false;
+
+    const TrajectoryMonitor::ConstPtr monitor = Monitor(traj);
+    if (monitor == nullptr)
+      return true;
+
+    for (size_t ii : changed) {
+      if (monitor->Conflict(obstacles.Point(ii), obstacles.Radius(ii),
+                            obstacles.Velocity(ii), obstacles.Stamp(ii),
+                            start_time) >= 0)
+        return true;
+    }
+
+    return false;
+  };
+
+  // The remainder of the pivot's trajectory hangs off the new root, unless
+  // the pivot ends right at the start.
+  size_t num_reused = 0;
+  Waypoint::ConstPtr new_pivot = tree.Root();
+  if (pivot->traj_->LastTime() > start_time + kTimeTolerance) {
+    const Trajectory::Ptr remainder =
+      Trajectory::Create(pivot->traj_, start_time, tree.GetArena());
+    if (conflicts(remainder))
+      return 0;
+
+    new_pivot = Waypoint::Create(
+      pivot->point_, pivot->value_, remainder, tree.Root(), tree.GetArena());
+    tree.Insert(new_pivot, pivot->point_ == stop);
+    num_reused++;
+  }
+
+  // Copy the pivot's descendants depth first, pruning at conflicts.
+  std::vector< std::pair<Waypoint::ConstPtr, Waypoint::ConstPtr> > stack;
+  for (const auto& child : children[pivot.get()])
+    stack.push_back({ child, new_pivot });
+
+  while (!stack.empty()) {
+    const Waypoint::ConstPtr waypoint = stack.back().first;
+    const Waypoint::ConstPtr parent = stack.back().second;
+    stack.pop_back();
+
+    if (conflicts(waypoint->traj_))
       continue;
 
-    // (3) Find the nearest neighbor.
-    const size_t kNumNeighbors = 1;
-    const std::vector<Waypoint::ConstPtr> neighbors =
-      tree.KnnSearch(sample, kNumNeighbors);
+    // Copy the trajectory too, so that nothing in the new tree refers to the
+    // previous tree's arena, which can then be released as a whole.
+    const Trajectory::Ptr traj = Trajectory::Create(
+      waypoint->traj_, waypoint->traj_->FirstTime(), tree.GetArena());
+    const Waypoint::ConstPtr copy = Waypoint::Create(
+      waypoint->point_, waypoint->value_, traj, parent, tree.GetArena());
+    tree.Insert(copy, waypoint->point_ == stop);
+    num_reused++;
+
+    for (const auto& child : children[waypoint.get()])
+      stack.push_back({ child, copy });
+  }
 
-    // Throw out this sample if too far from the nearest point.
-    if (neighbors.size() != kNumNeighbors ||
-        (neighbors[0]->point_ - sample).norm() > max_connection_radius_)
+  return num_reused;
+}
+
+// Timer callback to grow the roadmaps, and now and then save them. Shares a
+// queue with trajectory requests, so it only runs between them, and saving
+// here keeps disk writes out of planning.
+void MetaPlanner::GrowRoadmapsCallback(const ros::TimerEvent& e) {
+  // Small batches, so that a request arriving meanwhile is not held up.
+  const size_t kBatchSize = 20;
+
+  // Seconds between saves while the roadmaps are still growing. Each save
+  // rewrites every grown roadmap in full, so not after every batch.
+  const double kSavePeriod = 10.0;
+
+  bool filled = false;
+  for (const auto& roadmap : roadmaps_) {
+    if (roadmap->Full())
       continue;
 
-    Waypoint::ConstPtr neighbor = neighbors[0];
+    roadmap->Grow(kBatchSize);
+    filled = filled || roadmap->Full();
+  }
 
-    // Extract value function and corresponding planner ID from last waypoint.
-    // If value is null, (i.e. at root) then set to planners_.size() since
-    // any planner is valid from the root. Convert value ID to planner ID
-    // by dividing by 2 since each planner has two value functions.
-    const Trajectory::ConstPtr neighbor_traj = neighbor->traj_;
-    const ValueFunctionId neighbor_val = neighbor->value_;
+  // Save as soon as a roadmap is finished, and otherwise every so often.
+  const double now = ros::Time::now().toSec();
+  if (filled || now - roadmap_saved_time_ >= kSavePeriod) {
+    SaveRoadmaps();
+    roadmap_saved_time_ = now;
+  }
+}
 
-    const size_t neighbor_planner_id = neighbor_val / 2;
+// Save every roadmap which has grown since it was last saved.
+void MetaPlanner::SaveRoadmaps() {
+  for (size_t ii = 0; ii < roadmaps_.size(); ii++) {
+    const size_t size = roadmaps_[ii]->Size();
+    if (size == roadmap_saved_sizes_[ii])
+      continue;
 
-    // (4) Plan a trajectory (starting with the most aggressive planner and ending
-    // with the next-most cautious planner).
-    Trajectory::Ptr traj;
-    ValueFunctionId value_used;
-    for (size_t ii = 0;
-         ii < std::min(neighbor_planner_id + 2, planners_.size()); ii++) {
-      const Planner::ConstPtr planner = planners_[ii];
+    if (roadmaps_[ii]->Save(roadmap_files_[ii]))
+      roadmap_saved_sizes_[ii] = size;
+    else
+      ROS_WARN_THROTTLE(10.0, "%s: Could not save roadmap to %s.",
+                        name_.c_str(), roadmap_files_[ii].c_str());
+  }
+}
+
+// Load the motion primitive library for a planner, or generate it (and try
+// to save it for next time) if the saved one is missing or was made for a
+// different configuration.
+MotionPrimitives::ConstPtr MetaPlanner::
+LoadMotionPrimitives(const Planner::ConstPtr& planner) const {
+  Vector3d max_speed;
+  if (!planner->MaxSpeed(max_speed)) {
+    ROS_ERROR("%s: Maximum planner speeds are unavailable.", name_.c_str());
+    return nullptr;
+  }
+
+  const std::string file_name = lattice_directory_ + "motion_primitives_" +
+    std::to_string(planner->GetIncomingValueFunction()) + ".bin";
 
-      value_used = planner->GetIncomingValueFunction();
-      const ValueFunctionId possible_next_value =
-        planner->GetOutgoingValueFunction();
+  const MotionPrimitives::ConstPtr saved = MotionPrimitives::Load(file_name);
+  if (saved && saved->Matches(max_speed, lattice_resolution_,
+                              lattice_max_step_)) {
+    ROS_INFO("%s: Loaded %zu motion primitives from %s.",
+             name_.c_str(), saved->Size(), file_name.c_str());
+    return saved;
+  }
 
-      // Make sure switching distance server is up.
-      if (!switching_distance_srv_) {
-        ROS_WARN("%s: Switching distance server disconnected.", name_.c_str());
+  ROS_WARN("%s: No matching motion primitives in %s. Generating them now.",
+           name_.c_str(), file_name.c_str());
+
+  const MotionPrimitives::Ptr primitives = MotionPrimitives::Create(
+    max_speed, lattice_resolution_, lattice_max_step_);
+  if (!primitives->Save(file_name))
+    ROS_WARN("%s: Could not save motion primitives to %s.",
+             name_.c_str(), file_name.c_str());
+
+  return primitives;
+}
+
+// Check a trajectory against every obstacle in the given version, from the
+// given time on. Returns false if any tracking bound is unavailable.
+bool MetaPlanner::IsClear(const Trajectory::ConstPtr& traj,
+                          const ObstacleStore& obstacles, double from_time) {
+  const TrajectoryMonitor::ConstPtr monitor = Monitor(traj);
+  if (monitor == nullptr)
+    return false;
+
+  for (size_t ii = 0; ii < obstacles.Size(); ii++) {
+    if (monitor->Conflict(obstacles.Point(ii), obstacles.Radius(ii),
+                          obstacles.Velocity(ii), obstacles.Stamp(ii),
+                          from_time) >= 0)
+      return false;
+  }
+
+  return true;
+}
 
-        ros::NodeHandle nl;
-        switching_distance_srv_ = nl.serviceClient<value_function_srvs::GuaranteedSwitchingDistance>(
-          switching_distance_name_.c_str(), true);
+// Shorten a trajectory by replacing parts of it with straight lines, which
+// are fastest under the best possible time metric. First jump greedily from
+// each waypoint to the farthest one a straight line can reach faster, then
+// try shortcuts between random points along the way. Nothing before the
+// given time changes, and no shortcut crosses a switch of value functions.
+// Returns the original trajectory if it could not be shortened.
+Trajectory::ConstPtr MetaPlanner::Shortcut(const Trajectory::ConstPtr& traj,
+                                           double from_time) {
+  const double kTimeTolerance = 1e-6;
+  const size_t kNumRandomShortcuts = 20;
+
+  std::vector<double> times;
+  std::vector<VectorXd> states;
+  std::vector<ValueFunctionId> control_values;
+  std::vector<ValueFunctionId> bound_values;
+  traj->Waypoints(times, states, control_values, bound_values);
+
+  std::vector<Vector3d> positions;
+  for (const auto& state : states)
+    positions.push_back(dynamics_->Puncture(state));
+
+  // Waypoints whose full states have to be recomputed. All others, including
+  // any switches, keep their original states.
+  std::vector<char> relift(states.size(), false);
+
+  // Straight line planner for the segment starting at a waypoint, or null if
+  // that segment is not one that a single planner could have produced.
+  const auto line_from = [&](size_t ii) -> Planner::ConstPtr {
+    if (control_values[ii] != bound_values[ii])
+      return nullptr;
+
+    for (const auto& line : straight_lines_) {
+      if (line->GetIncomingValueFunction() == control_values[ii])
+        return line;
+    }
+
+    return nullptr;
+  };
+
+  // Whether segments ii through jj - 1 all use the same value functions.
+  const auto same_values = [&](size_t ii, size_t jj) {
+    for (size_t kk = ii + 1; kk < jj; kk++) {
+      if (control_values[kk] != control_values[ii] ||
+          bound_values[kk] != bound_values[ii])
         return false;
-      }
+    }
 
-      // Get the tracking bound for this planner.
-      double switch_x = 0.0;
-      double switch_y = 0.0;
-      double switch_z = 0.0;
-
-      value_function_srvs::GuaranteedSwitchingDistance d;
-      d.request.from_id = value_used;
-      d.request.to_id = possible_next_value;
-      if (!switching_distance_srv_.call(d))
-        ROS_ERROR("%s: Error calling switching distance server.", name_.c_str());
-      else {
-        switch_x = d.response.x;
-        switch_y = d.response.y;
-        switch_z = d.response.z;
+    return true;
+  };
+
+  // Replace waypoints ii + 1 through jj - 1 with new ones, and make every
+  // later waypoint earlier by the time saved. Waypoint ii now heads somewhere
+  // else, so its velocity changes too, unless it is before from_time (in
+  // which case the new segment lies along the old one).
+  const auto replace = [&](size_t ii, size_t jj,
+                           const std::vector<Vector3d>& new_positions,
+                           const std::vector<double>& new_times,
+                           double saved) {
+    for (size_t kk = jj; kk < times.size(); kk++)
+      times[kk] -= saved;
+
+    relift[ii] = relift[ii] || times[ii] >= from_time;
+    relift.erase(relift.begin() + ii + 1, relift.begin() + jj);
+    relift.insert(relift.begin() + ii + 1, new_positions.size(), true);
+    states.erase(states.begin() + ii + 1, states.begin() + jj);
+    states.insert(states.begin() + ii + 1, new_positions.size(), VectorXd());
+
+    positions.erase(positions.begin() + ii + 1, positions.begin() + jj);
+    times.erase(times.begin() + ii + 1, times.begin() + jj);
+    control_values.erase(control_values.begin() + ii + 1,
+                         control_values.begin() + jj);
+    bound_values.erase(bound_values.begin() + ii + 1,
+                       bound_values.begin() + jj);
+
+    positions.insert(positions.begin() + ii + 1,
+                     new_positions.begin(), new_positions.end());
+    times.insert(times.begin() + ii + 1, new_times.begin(), new_times.end());
+    control_values.insert(control_values.begin() + ii + 1,
+                          new_positions.size(), control_values[ii]);
+    bound_values.insert(bound_values.begin() + ii + 1,
+                        new_positions.size(), bound_values[ii]);
+  };
+
+  bool shortened = false;
+
+  // Greedy pass between waypoints.
+  for (size_t ii = 0; ii + 2 < positions.size(); ii++) {
+    const Planner::ConstPtr line = line_from(ii);
+    if (times[ii] < from_time || line == nullptr)
+      continue;
+
+    // Farthest waypoint reachable without crossing a switch.
+    size_t last = ii + 1;
+    while (last + 1 < positions.size() && same_values(ii, last + 1))
+      last++;
+
+    for (size_t jj = last; jj > ii + 1; jj--) {
+      const Trajectory::Ptr straight =
+        line->Plan(positions[ii], positions[jj], times[ii]);
+
+      if (straight != nullptr &&
+          straight->LastTime() < times[jj] - kTimeTolerance) {
+        replace(ii, jj, {}, {}, times[jj] - straight->LastTime());
+        shortened = true;
+        break;
       }
+    }
+  }
 
-      // Since we might always end up switching, make sure this point
-      // is not closer than the guaranteed switching distance.
-      // NOTE! This enforces backtracking only one planner at a time.
-      // In full generality, we would just need to replace possible_next_value
-      // with the most cautious value.
-      if (std::abs(neighbor->point_(0) - sample(0)) < switch_x &&
-          std::abs(neighbor->point_(1) - sample(1)) < switch_y &&
-          std::abs(neighbor->point_(2) - sample(2)) < switch_z)
-        continue;
+  // Random pass between points along segments.
+  for (size_t ii = 0; ii < kNumRandomShortcuts; ii++) {
+    if (from_time >= times.back())
+      break;
+
+    std::uniform_real_distribution<double> unif(from_time, times.back());
+    double start_time = unif(shortcut_rng_);
+    double stop_time = unif(shortcut_rng_);
+    if (start_time > stop_time)
+      std::swap(start_time, stop_time);
+
+    // Segments containing each point.
+    const size_t kk = std::upper_bound(times.begin(), times.end(),
+                                       start_time) - times.begin() - 1;
+    const size_t mm = std::upper_bound(times.begin(), times.end(),
+                                       stop_time) - times.begin() - 1;
+    if (kk >= mm || mm + 1 >= times.size() || !same_values(kk, mm + 1) ||
+        start_time - times[kk] < kTimeTolerance ||
+        times[mm + 1] - stop_time < kTimeTolerance)
+      continue;
 
-      // Plan using 10% of the available total runtime.
-      // NOTE! This is just a heuristic and could easily be changed.
-      const double time = (neighbor_traj == nullptr) ?
-        start_time : neighbor_traj->LastTime();
+    const Planner::ConstPtr line = line_from(kk);
+    if (line == nullptr)
+      continue;
+
+    const auto interpolate = [&](size_t jj, double time) {
+      const double fraction =
+        (time - times[jj]) / (times[jj + 1] - times[jj]);
+      return Vector3d(positions[jj] +
+                      fraction * (positions[jj + 1] - positions[jj]));
+    };
+
+    const Vector3d start = interpolate(kk, start_time);
+    const Vector3d stop = interpolate(mm, stop_time);
+    const Trajectory::Ptr straight = line->Plan(start, stop, start_time);
+
+    if (straight != nullptr &&
+        straight->LastTime() < stop_time - kTimeTolerance) {
+      replace(kk, mm + 1, { start, stop },
+              { start_time, straight->LastTime() },
+              stop_time - straight->LastTime());
+      shortened = true;
+    }
+  }
+
+  if (!shortened)
+    return traj;
+
+  // Only recompute the states of waypoints that were added or now head
+  // somewhere else. Everything else only moved in time.
+  const std::vector<VectorXd> lifted =
+    dynamics_->LiftGeometricTrajectory(positions, times);
+  for (size_t ii = 0; ii < states.size(); ii++) {
+    if (relift[ii])
+      states[ii] = lifted[ii];
+  }
+
+  const Trajectory::Ptr shortcut = Trajectory::Create(
+    times, states, control_values, bound_values);
+
+  // Everything after a shortcut now happens earlier, so make sure that
+  // moving obstacles are still out of the way.
+  if (!IsClear(shortcut, *space_->PinnedObstacles(), from_time))
+    return traj;
+
+  return shortcut;
+}
+
+// Check that a trajectory agrees with the part of the previously published
+// trajectory (if any) that the vehicle may already be following, i.e. up
+// to the current time. Either way, it must start at the given start point
+// and time.
+bool MetaPlanner::AgreesWithPrefix(const Trajectory::ConstPtr& traj,
+                                   const Vector3d& start, double start_time,
+                                   const Trajectory::ConstPtr& published) const {
+  const double kTimeTolerance = 1e-6;
+  const double kPositionTolerance = 1e-3;
+
+  if (std::abs(traj->FirstTime() - start_time) > kTimeTolerance ||
+      (dynamics_->Puncture(traj->FirstState()) - start).norm() >
+      kPositionTolerance)
+    return false;
+
+  if (published == nullptr)
+    return true;
+
+  // Compare at the published waypoints, and at the current time.
+  const double now = std::min(ros::Time::now().toSec(), traj->LastTime());
+  if (now <= start_time)
+    return true;
+
+  std::vector<double> times;
+  std::vector<VectorXd> states;
+  std::vector<ValueFunctionId> values;
+  published->Waypoints(times, states, values);
+
+  times.push_back(now);
+  for (size_t ii = 0; ii < times.size() && times[ii] <= now; ii++) {
+    const Vector3d expected = dynamics_->Puncture(published->GetState(times[ii]));
+    const Vector3d actual = dynamics_->Puncture(traj->GetState(times[ii]));
+
+    if ((expected - actual).norm() > kPositionTolerance)
+      return false;
+  }
+
+  return true;
+}
+
+// Lower bound on the time to go from one point to another with any planner.
+// NOTE! This assumes that the first planner is the fastest.
+double MetaPlanner::LowerBoundTime(const Vector3d& from,
+                                   const Vector3d& to) const {
+  if (informed_)
+    return (to - from).cwiseAbs().cwiseQuotient(max_speed_).maxCoeff();
+
+  return planners_.front()->BestPossibleTime(from, to);
+}
+
+// Add a waypoint to the frontier, ranked by its arrival time plus a lower
+// bound on the time from there to the goal. Times are measured from the start
+// of the episode, like WaypointTree::BestTime().
+void MetaPlanner::PushFrontier(const Waypoint::ConstPtr& waypoint,
+                               const Vector3d& stop, double start_time) {
+  const double arrival = (waypoint->traj_ == nullptr) ?
+    0.0 : waypoint->traj_->LastTime() - start_time;
+
+  frontier_->Push(waypoint, arrival + LowerBoundTime(waypoint->point_, stop));
+}
+
+// Run one iteration of steps (2) - (6) of Plan() on the given tree, drawing
+// samples from the given sequence. Sets reached_goal if the tree reached the goal
+// in this iteration. Returns false only if planning must stop altogether.
+bool MetaPlanner::Expand(WaypointTree& tree,
+                         const Vector3d& start, const Vector3d& stop,
+                         double start_time, HaltonSequence& sequence,
+                         std::default_random_engine& rng,
+                         bool& reached_goal) {
+  Vector3d sample;
+  Waypoint::ConstPtr neighbor;
+  const double best_time = tree.BestTime();
+
+  // (2) - (3) In best-first mode, usually take the most promising waypoint
+  // in the frontier and step from it toward the goal, perturbed toward a
+  // random sample so that repeated steps from the same waypoint differ.
+  // Skip waypoints that can no longer lead to a faster trajectory.
+  std::uniform_real_distribution<double> unif(0.0, 1.0);
+  if (best_first_ && unif(rng) >= random_fraction_) {
+    double cost = 0.0;
+    const Waypoint::ConstPtr best = frontier_->Next(cost);
+
+    if (best != nullptr && cost < best_time) {
+      // Stop a little short of the connection radius, leaving room for
+      // the perturbation.
+      const double kStepFraction = 0.8;
+      const double kPerturbation = 0.25;
+
+      const Vector3d to_stop = stop - best->point_;
+      const double distance = tree.Distance(best->point_, stop);
+      const double step =
+        kStepFraction * std::min(distance, max_connection_radius_);
+      const Vector3d steered = (distance > 0.0) ?
+        Vector3d(best->point_ + (step / distance) * to_stop) : best->point_;
+
+      // Move a bounded distance toward a uniform sample. This is a convex
+      // combination, so it never leaves the state space.
+      const Vector3d random = space_->Sample(sequence);
+      const double spread = tree.Distance(random, steered);
+      const double weight = (spread > 0.0) ?
+        std::min(1.0, kPerturbation * step / spread) : 0.0;
+
+      sample = steered + weight * (random - steered);
+      neighbor = best;
+    }
+  }
+
+  if (neighbor == nullptr) {
+    // (2) Sample a new point in the state space. Once a trajectory has been
+    // found, only sample points which could lead to a faster one.
+    // NOTE! This assumes that the first planner is the fastest.
+    if (std::isinf(best_time)) {
+      sample = space_->Sample(sequence);
+    } else if (informed_) {
+      if (!space_->SampleInformed(start, stop, max_speed_, best_time,
+                                  sequence, sample))
+        return true;
+    } else {
+      // Without the fastest planner's speeds, fall back to asking the server
+      // whether this sample could ever lead to a faster trajectory.
+      sample = space_->Sample(sequence);
+      if (planners_.front()->BestPossibleTime(start, sample) +
+          planners_.front()->BestPossibleTime(sample, stop) > best_time)
+        return true;
+    }
+
+    // (3) Find the nearest neighbor, in the lazy tree if in lazy mode.
+    double distance = 0.0;
+    const size_t num_neighbors = (lazy_) ?
+      lazy_tree_->KnnSearch(sample, 1, &neighbor, &distance) :
+      tree.KnnSearch(sample, 1, &neighbor, &distance);
+
+    // Throw out this sample if too far from the nearest point.
+    if (num_neighbors == 0 || distance > max_connection_radius_)
+      return true;
+  }
+
+  // In lazy mode, defer planning until the new edge is on a candidate path
+  // to the goal, and never grow from below an edge which failed.
+  if (lazy_) {
+    {
+      std::lock_guard<std::mutex> lock(lazy_mutex_);
+      if (IsInvalidated(neighbor))
+        return true;
+    }
+
+    return ExpandLazily(tree, neighbor, sample, stop, start_time,
+                        reached_goal);
+  }
+
+  Waypoint::ConstPtr inserted;
+  return Connect(tree, neighbor, sample, stop, start_time, inserted,
+                 reached_goal);
+}
+
+// Run steps (4) - (6) of Plan() from the given waypoint in the tree to the
+// given sample. Sets inserted to the new waypoint at the sample (or null),
+// and reached_goal if it was connected to the goal. Returns false only if
+// planning must stop altogether.
+bool MetaPlanner::Connect(WaypointTree& tree, Waypoint::ConstPtr neighbor,
+                          const Vector3d& sample, const Vector3d& stop,
+                          double start_time, Waypoint::ConstPtr& inserted,
+                          bool& reached_goal) {
+  inserted = nullptr;
+
+  // Extract value function and corresponding planner ID from last waypoint.
+  // If value is null, (i.e. at root) then set to planners_.size() since
+  // any planner is valid from the root. Convert value ID to planner ID
+  // by dividing by 2 since each planner has two value functions.
+  const Trajectory::ConstPtr neighbor_traj = neighbor->traj_;
+  const ValueFunctionId neighbor_val = neighbor->value_;
+
+  const size_t neighbor_planner_id = neighbor_val / 2;
+
+  // (4) Plan a trajectory with every admissible planner at once (from the
+  // most aggressive planner to the next-most cautious planner), and keep
+  // the most aggressive one that succeeds.
+  std::vector<size_t> candidates;
+  for (size_t ii = 0;
+       ii < std::min(neighbor_planner_id + 2, planners_.size()); ii++) {
+    const Planner::ConstPtr planner = planners_[ii];
+
+    const ValueFunctionId possible_value =
+      planner->GetIncomingValueFunction();
+    const ValueFunctionId possible_next_value =
+      planner->GetOutgoingValueFunction();
+
+    // Get the switching distance for this planner.
+    const auto distance = switching_distances_.find(
+      std::make_pair(possible_value, possible_next_value));
+    if (distance == switching_distances_.end()) {
+      ROS_ERROR("%s: No switching distance for value functions %zu and %zu.",
+                name_.c_str(), possible_value, possible_next_value);
+      continue;
+    }
+
+    const double switch_x = distance->second(0);
+    const double switch_y = distance->second(1);
+    const double switch_z = distance->second(2);
+
+    // Since we might always end up switching, make sure this point
+    // is not closer than the guaranteed switching distance.
+    // NOTE! This enforces backtracking only one planner at a time.
+    // In full generality, we would just need to replace possible_next_value
+    // with the most cautious value.
+    if (std::abs(neighbor->point_(0) - sample(0)) < switch_x &&
+        std::abs(neighbor->point_(1) - sample(1)) < switch_y &&
+        std::abs(neighbor->point_(2) - sample(2)) < switch_z)
+      continue;
 
-      traj = planner->Plan(neighbor->point_, sample, time, 0.1 * max_runtime_);
+    candidates.push_back(ii);
+  }
+
+  // Budgets are chosen per planner by the budget scheduler.
+  const double time = (neighbor_traj == nullptr) ?
+    start_time : neighbor_traj->LastTime();
+
+  // Obstacles pinned for this planning episode.
+  const ObstacleStore::ConstPtr obstacles = space_->PinnedObstacles();
 
-      if (traj != nullptr) {
-        // When we succeed...
-        // If we just planned with a more cautious planner than the one used
-        // by the nearest neighbor, do a 1-step backtrack.
-        if (ii > neighbor_planner_id) {
+  size_t planner_used_id = 0;
+  Trajectory::Ptr traj = PlanInParallel(
+    candidates, neighbor->point_, sample, time, planner_used_id);
+
+  ValueFunctionId value_used;
+  if (traj != nullptr) {
+    // When we succeed...
+    value_used = planners_[planner_used_id]->GetIncomingValueFunction();
+
+    // If we just planned with a more cautious planner than the one used
+    // by the nearest neighbor, do a 1-step backtrack.
+    if (planner_used_id > neighbor_planner_id) {
 #if 0
-          std::cout << "Switched from planner " << neighbor_planner_id
-                    << " with value id " << neighbor_val->Id()
-                    << " to planner " << ii
-                    << " with value id " << value_used->Id() << std::endl;
+      std::cout << "Switched from planner " << neighbor_planner_id
+                << " with value id " << neighbor_val->Id()
+                << " to planner " << planner_used_id
+                << " with value id " << value_used->Id() << std::endl;
 #endif
-          // Clone the neighbor.
-          const Vector3d jittered(neighbor->point_(0) + 1e-4,
-                                  neighbor->point_(1) + 1e-4,
-                                  neighbor->point_(2) + 1e-4);
-
-          const double time = (neighbor_traj == nullptr) ?
-            start_time : neighbor_traj->FirstTime();
-
-          if (time <= start_time + 1e-8) {
-            ROS_INFO_THROTTLE(1.0, "%s: Tried to clone the root.", name_.c_str());
-
-            // Didn't really succeed. Can't clone the root in general.
-            traj = nullptr;
-          } else {
-            Waypoint::ConstPtr clone =
-              Waypoint::Create(jittered,
-                               value_used,
-                               Trajectory::Create(neighbor_traj, time),
-                               neighbor->parent_);
-
-            // Swap out the control value function in the neighbor's trajectory
-            // and update time stamps accordingly.
-            clone->traj_->ExecuteSwitch(value_used, best_time_srv_);
-
-            // Insert the clone.
-            tree.Insert(clone, false);
-
-            // Adjust the time stamps for the new trajectory to occur after the
-            // updated neighbor's trajectory.
-            traj->ResetStartTime(clone->traj_->LastTime());
-
-            // Neighbor is now clone.
-            neighbor = clone;
-          }
+      // Clone the neighbor.
+      const Vector3d jittered(neighbor->point_(0) + 1e-4,
+                              neighbor->point_(1) + 1e-4,
+                              neighbor->point_(2) + 1e-4);
+
+      const double time = (neighbor_traj == nullptr) ?
+        start_time : neighbor_traj->FirstTime();
+
+      if (time <= start_time + 1e-8) {
+        ROS_INFO_THROTTLE(1.0, "%s: Tried to clone the root.", name_.c_str());
+
+        // Didn't really succeed. Can't clone the root in general.
+        traj = nullptr;
+      } else {
+        Waypoint::ConstPtr clone =
+          Waypoint::Create(jittered,
+                           value_used,
+                           Trajectory::Create(neighbor_traj, time,
+                                              tree.GetArena()),
+                           neighbor->parent_,
+                           tree.GetArena());
+
+        // Swap out the control value function in the neighbor's trajectory
+        // and update time stamps accordingly.
+        {
+          std::lock_guard<std::mutex> srv_lock(srv_mutex_);
+          clone->traj_->ExecuteSwitch(value_used, best_time_srv_);
         }
 
-        break;
+        // Adjust the time stamps for the new trajectory to occur after the
+        // updated neighbor's trajectory.
+        traj->ResetStartTime(clone->traj_->LastTime());
+
+        // Both trajectories were only checked against moving obstacles at
+        // their old times, so check them again.
+        if (!IsClear(clone->traj_, *obstacles, clone->traj_->FirstTime()) ||
+            !IsClear(traj, *obstacles, traj->FirstTime())) {
+          traj = nullptr;
+        } else {
+          // Insert the clone. In lazy mode, the frontier holds the lazy tree.
+          tree.Insert(clone, false);
+          if (best_first_ && !lazy_)
+            PushFrontier(clone, stop, start_time);
+
+          // Neighbor is now clone.
+          neighbor = clone;
+        }
       }
     }
+  }
 
-    // Check if we could found a trajectory to this sample.
-    if (traj == nullptr)
-      continue;
+  // Check if we could found a trajectory to this sample.
+  if (traj == nullptr)
+    return true;
 
-    // Insert the sample.
-    const Waypoint::ConstPtr waypoint = Waypoint::Create(
-      sample, value_used, traj, neighbor);
-
-    tree.Insert(waypoint, false);
-
-    // (5) Try to connect to the goal point.
-    Trajectory::Ptr goal_traj;
-    ValueFunctionId goal_value_used;
-    const size_t planner_used_id = value_used / 2;
-
-    if ((sample - stop).norm() <= max_connection_radius_) {
-      for (size_t ii = 0;
-           ii < std::min(planner_used_id + 2, planners_.size()); ii++) {
-        const Planner::ConstPtr planner = planners_[ii];
-        goal_value_used = planner->GetIncomingValueFunction();
-
-        // We are never gonna need to switch if this succeeds.
-        // Plan using 10% of the available total runtime.
-        // NOTE! This is just a heuristic and could easily be changed.
-        goal_traj =
-          planner->Plan(sample, stop, traj->LastTime(), 0.1 * max_runtime_);
-
-        if (goal_traj != nullptr) {
-          // When we succeed... don't need to clone because waypoint has no kids.
-          // If we just planned with a more cautious planner than the one used
-          // by the nearest neighbor, do a 1-step backtrack.
-          if (ii > neighbor_planner_id) {
-            // Swap out the control value function in the neighbor's trajectory
-            // and update time stamps accordingly.
-            waypoint->traj_->ExecuteSwitch(goal_value_used, best_time_srv_);
-
-            // Adjust the time stamps for the new trajectory to occur after the
-            // updated neighbor's trajectory.
-            goal_traj->ResetStartTime(waypoint->traj_->LastTime());
-          }
-
-          break;
+  // Create a waypoint for the sample. Other threads may read it as soon as
+  // it is in the tree, so connect it to the goal (which may switch its
+  // trajectory) before inserting it.
+  const Waypoint::ConstPtr waypoint = Waypoint::Create(
+    sample, value_used, traj, neighbor, tree.GetArena());
+
+  // (5) Try to connect to the goal point.
+  Trajectory::Ptr goal_traj;
+
+  if (tree.Distance(sample, stop) <= max_connection_radius_) {
+    // We are never gonna need to switch if this succeeds.
+    std::vector<size_t> goal_candidates;
+    for (size_t ii = 0;
+         ii < std::min(value_used / 2 + 2, planners_.size()); ii++)
+      goal_candidates.push_back(ii);
+
+    size_t goal_planner_id = 0;
+    goal_traj = PlanInParallel(goal_candidates, sample, stop,
+                               traj->LastTime(), goal_planner_id);
+
+    if (goal_traj != nullptr) {
+      // When we succeed... don't need to clone because waypoint has no kids.
+      // If we just planned with a more cautious planner than the one used
+      // by the nearest neighbor, do a 1-step backtrack.
+      if (goal_planner_id > neighbor_planner_id) {
+        const ValueFunctionId goal_value_used =
+          planners_[goal_planner_id]->GetIncomingValueFunction();
+
+        // Swap out the control value function in the neighbor's trajectory
+        // and update time stamps accordingly.
+        {
+          std::lock_guard<std::mutex> srv_lock(srv_mutex_);
+          waypoint->traj_->ExecuteSwitch(goal_value_used, best_time_srv_);
         }
+
+        // Adjust the time stamps for the new trajectory to occur after the
+        // updated neighbor's trajectory.
+        goal_traj->ResetStartTime(waypoint->traj_->LastTime());
+
+        // As above, retimed trajectories must be checked again. The sample's
+        // own trajectory has already been switched, so if that fails the
+        // sample has to go too.
+        if (!IsClear(waypoint->traj_, *obstacles, waypoint->traj_->FirstTime()))
+          return true;
+
+        if (!IsClear(goal_traj, *obstacles, goal_traj->FirstTime()))
+          goal_traj = nullptr;
       }
     }
+  }
 
-    // (6) If this sample was connected to the goal, update the tree terminus.
-    if (goal_traj != nullptr) {
-      // Connect to the goal.
-      // NOTE: the first point in goal_traj coincides with the last point in
-      // traj, but when we merge the two trajectories the std::map insertion
-      // rules will prevent duplicates.
-      const Waypoint::ConstPtr goal = Waypoint::Create(
-        stop, value_used, goal_traj, waypoint);
+  // Insert the sample.
+  tree.Insert(waypoint, false);
+  if (best_first_ && !lazy_)
+    PushFrontier(waypoint, stop, start_time);
 
-      tree.Insert(goal, true);
+  inserted = waypoint;
 
-      // Mark that we've found a valid trajectory.
-      found = true;
+  // (6) If this sample was connected to the goal, update the tree terminus.
+  if (goal_traj != nullptr) {
+    // Connect to the goal.
+    // NOTE: the first point in goal_traj coincides with the last point in
+    // traj, but when we merge the two trajectories the std::map insertion
+    // rules will prevent duplicates.
+    const Waypoint::ConstPtr goal = Waypoint::Create(
+      stop, value_used, goal_traj, waypoint, tree.GetArena());
+
+    tree.Insert(goal, true);
+
+    // Mark that we've found a valid trajectory.
+    reached_goal = true;
+  }
+
+  return true;
+}
+
+// Lazy mode: add an unchecked straight-line edge from a waypoint in the lazy
+// tree to the given sample, and from there to the goal if close enough. Then
+// evaluate candidate paths to the goal, fastest (estimated) first, until one
+// reaches the goal or none could beat the best trajectory in the tree.
+bool MetaPlanner::ExpandLazily(WaypointTree& tree,
+                               const Waypoint::ConstPtr& neighbor,
+                               const Vector3d& sample, const Vector3d& stop,
+                               double start_time, bool& reached_goal) {
+  const Waypoint::ConstPtr waypoint =
+    LazyWaypoint(sample, neighbor, start_time);
+  lazy_tree_->Insert(waypoint, false);
+  num_lazy_edges_++;
+
+  if (best_first_)
+    PushFrontier(waypoint, stop, start_time);
+
+  if (tree.Distance(sample, stop) <= max_connection_radius_) {
+    const Waypoint::ConstPtr goal = LazyWaypoint(stop, waypoint, start_time);
+    lazy_tree_->Insert(goal, false);
+    num_lazy_edges_++;
+
+    std::lock_guard<std::mutex> lock(lazy_mutex_);
+    lazy_goals_.push_back(goal);
+  }
+
+  while (ros::Time::now().toSec() < deadline_) {
+    // Claim the most promising candidate, dropping any which have been
+    // invalidated or could no longer beat the best trajectory.
+    Waypoint::ConstPtr candidate;
+    {
+      std::lock_guard<std::mutex> lock(lazy_mutex_);
+      const double best_time = tree.BestTime();
+      lazy_goals_.erase(std::remove_if(
+        lazy_goals_.begin(), lazy_goals_.end(),
+        [&](const Waypoint::ConstPtr& goal) {
+          return goal->traj_->LastTime() - start_time >= best_time ||
+            IsInvalidated(goal);
+        }), lazy_goals_.end());
+
+      if (lazy_goals_.empty())
+        break;
+
+      const auto fastest = std::min_element(
+        lazy_goals_.begin(), lazy_goals_.end(),
+        [](const Waypoint::ConstPtr& a, const Waypoint::ConstPtr& b) {
+          return a->traj_->LastTime() < b->traj_->LastTime();
+        });
+
+      candidate = *fastest;
+      lazy_goals_.erase(fastest);
+    }
+
+    bool candidate_reached_goal = false;
+    if (!EvaluateLazyPath(tree, candidate, stop, start_time,
+                          candidate_reached_goal))
+      return false;
+
+    if (candidate_reached_goal) {
+      reached_goal = true;
+      break;
     }
   }
 
-  if (found) {
-    // Get the best (fastest) trajectory out of the tree.
-    const Trajectory::ConstPtr best = tree.BestTrajectory();
-    ROS_INFO("%s: Publishing trajectory of length %zu.",
-             name_.c_str(), best->Size());
+  return true;
+}
 
-    traj_ = best;
-    traj_pub_.publish(best->ToRosMessage());
-    return true;
+// Lazy mode: unchecked waypoint at the given point, reached from the given
+// lazy waypoint as fast as the fastest planner could possibly go.
+Waypoint::ConstPtr MetaPlanner::LazyWaypoint(const Vector3d& point,
+                                             const Waypoint::ConstPtr& parent,
+                                             double start_time) const {
+  const double time = (parent->traj_ == nullptr) ?
+    start_time : parent->traj_->LastTime();
+
+  const std::vector<Vector3d> positions = { parent->point_, point };
+  const std::vector<double> times = {
+    time, time + LowerBoundTime(parent->point_, point) };
+
+  const ValueFunctionId value =
+    planners_.front()->GetIncomingValueFunction();
+  const std::vector<ValueFunctionId> values = { value, value };
+
+  const Arena::Ptr& arena = lazy_tree_->GetArena();
+  return Waypoint::Create(
+    point, value,
+    Trajectory::Create(times,
+                       dynamics_->LiftGeometricTrajectory(positions, times),
+                       values, values, arena),
+    parent, arena);
+}
+
+// Lazy mode: plan each unchecked edge on the path to the given lazy waypoint
+// at the goal for real, starting from the nearest waypoint above it which is
+// already in the tree. Stops at the first edge which fails, invalidating it
+// (and so everything below it), or as soon as the goal is reached.
+bool MetaPlanner::EvaluateLazyPath(WaypointTree& tree,
+                                   const Waypoint::ConstPtr& goal,
+                                   const Vector3d& stop, double start_time,
+                                   bool& reached_goal) {
+  // Unchecked waypoints from the goal up, and the real waypoint above them.
+  std::vector<Waypoint::ConstPtr> path;
+  Waypoint::ConstPtr real;
+  {
+    std::lock_guard<std::mutex> lock(lazy_mutex_);
+    for (Waypoint::ConstPtr waypoint = goal;
+         waypoint != nullptr; waypoint = waypoint->parent_) {
+      const auto match = realized_.find(waypoint.get());
+      if (match != realized_.end()) {
+        real = match->second;
+        break;
+      }
+
+      path.push_back(waypoint);
+    }
+
+    // The waypoint right above the goal already tried (and failed) to connect
+    // to it when it was inserted.
+    if (real == nullptr || path.size() < 2) {
+      invalidated_.insert(goal.get());
+      return true;
+    }
+  }
+
+  // Evaluate each edge down to the waypoint right above the goal. Evaluating
+  // that one also tries to connect it to the goal.
+  for (size_t ii = path.size() - 1; ii > 0; ii--) {
+    const Waypoint::ConstPtr& lazy = path[ii];
+
+    // Another worker may have evaluated this edge in the meantime.
+    {
+      std::lock_guard<std::mutex> lock(lazy_mutex_);
+      if (invalidated_.count(lazy.get()) > 0)
+        return true;
+
+      const auto match = realized_.find(lazy.get());
+      if (match != realized_.end()) {
+        real = match->second;
+        continue;
+      }
+    }
+
+    Waypoint::ConstPtr inserted;
+    if (!Connect(tree, real, lazy->point_, stop, start_time, inserted,
+                 reached_goal))
+      return false;
+
+    num_evaluated_edges_++;
+
+    std::lock_guard<std::mutex> lock(lazy_mutex_);
+    if (inserted == nullptr) {
+      invalidated_.insert(lazy.get());
+      return true;
+    }
+
+    realized_[lazy.get()] = inserted;
+    real = inserted;
+
+    if (reached_goal)
+      return true;
+  }
+
+  // The last edge did not reach the goal.
+  std::lock_guard<std::mutex> lock(lazy_mutex_);
+  invalidated_.insert(goal.get());
+  return true;
+}
+
+// Lazy mode: true if this lazy waypoint, or any unchecked waypoint above it,
+// has been invalidated. Call with lazy_mutex_ held.
+bool MetaPlanner::IsInvalidated(const Waypoint::ConstPtr& waypoint) const {
+  for (const Waypoint* ptr = waypoint.get();
+       ptr != nullptr; ptr = ptr->parent_.get()) {
+    if (invalidated_.count(ptr) > 0)
+      return true;
+
+    if (realized_.count(ptr) > 0)
+      return false;
   }
 
   return false;
 }
 
+// Plan from start to stop with each of the candidate planners at once, and
+// return the result of the most aggressive one that succeeds. Since
+// candidates are sorted from most to least aggressive, a success cancels
+// every candidate after it. All candidates have finished when this returns.
+// Each candidate gets the budget chosen by the budget scheduler, which
+// learns from how long each call takes.
+Trajectory::Ptr MetaPlanner::PlanInParallel(
+  const std::vector<size_t>& candidates,
+  const Vector3d& start, const Vector3d& stop,
+  double start_time, size_t& planner_used_id) const {
+  const size_t num_candidates = candidates.size();
+  if (num_candidates == 0)
+    return nullptr;
+
+  // No call may run past the deadline.
+  const double remaining = deadline_ - ros::Time::now().toSec();
+  if (remaining <= 0.0)
+    return nullptr;
+
+  // Describe this segment to the budget scheduler.
+  const double length = (stop - start).norm();
+  const size_t num_nearby =
+    NumNearbyObstacles(0.5 * (start + stop), 0.5 * length);
+
+  // One cancellation flag per candidate.
+  std::unique_ptr<std::atomic<bool>[]> cancel(
+    new std::atomic<bool>[num_candidates]);
+  for (size_t ii = 0; ii < num_candidates; ii++)
+    cancel[ii] = false;
+
+  std::atomic<bool>* const flags = cancel.get();
+
+  std::vector< std::future<Trajectory::Ptr> > results;
+  for (size_t ii = 0; ii < num_candidates; ii++) {
+    const size_t planner_id = candidates[ii];
+    const Planner::ConstPtr planner = planners_[planner_id];
+    const double budget = std::min(
+      budgets_->Budget(planner_id, length, num_nearby), remaining);
+
+    results.push_back(planner_pool_->Submit(
+      [=, &start, &stop]() {
+        num_calls_++;
+
+        // Try the straight line first. It takes no budget, so there is
+        // nothing to tell the scheduler if it works.
+        Trajectory::Ptr traj = (straight_lines_enabled_) ?
+          straight_lines_[planner_id]->Plan(start, stop, start_time) : nullptr;
+
+        // Then the roadmap. It only takes long if it finds many blocked
+        // edges, and whatever time it takes comes out of the budget.
+        double roadmap_elapsed = 0.0;
+        if (traj != nullptr) {
+          num_straight_lines_++;
+        } else if (roadmaps_enabled_) {
+          const auto roadmap_start = std::chrono::steady_clock::now();
+          traj = roadmaps_[planner_id]->Plan(
+            start, stop, start_time, budget, flags[ii]);
+
+          roadmap_elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - roadmap_start).count();
+          if (traj != nullptr)
+            num_roadmap_paths_++;
+        }
+
+        if (traj == nullptr && roadmap_elapsed < budget) {
+          const auto call_start = std::chrono::steady_clock::now();
+          traj = planner->Plan(start, stop, start_time,
+                               budget - roadmap_elapsed, flags[ii]);
+
+          const double elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - call_start).count();
+          budgets_->Record(planner_id, length, num_nearby, elapsed,
+                           traj != nullptr);
+        }
+
+        // Less aggressive candidates can no longer be chosen.
+        if (traj != nullptr) {
+          for (size_t jj = ii + 1; jj < num_candidates; jj++)
+            flags[jj] = true;
+        }
+
+        return traj;
+      }));
+  }
+
+  // Collect results from most to least aggressive. Wait for every candidate,
+  // even cancelled ones, since they refer to state owned by this call.
+  Trajectory::Ptr best;
+  for (size_t ii = 0; ii < num_candidates; ii++) {
+    const Trajectory::Ptr traj = results[ii].get();
+
+    if (best == nullptr && traj != nullptr) {
+      best = traj;
+      planner_used_id = candidates[ii];
+    }
+  }
+
+  return best;
+}
+
+// Number of obstacles (in the version seen by collision checks) which come
+// within the given distance of a point.
+size_t MetaPlanner::NumNearbyObstacles(const Vector3d& point,
+                                       double distance) const {
+  const ObstacleStore::ConstPtr obstacles = space_->PinnedObstacles();
+
+  size_t num_nearby = 0;
+  for (size_t ii = 0; ii < obstacles->Size(); ii++) {
+    if ((obstacles->Point(ii) - point).norm() <=
+        distance + obstacles->Radius(ii))
+      num_nearby++;
+  }
+
+  return num_nearby;
+}
+
 } //\namespace meta
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the MotionPrimitives class, a library of straight moves between
+// cells of a uniform 3D lattice for one planner's maximum speeds. Each
+// primitive stores its offset in cells, how long it takes at full speed, and
+// the points (relative to its start) at which it must be collision checked.
+// Libraries are generated offline and saved to a binary file, so that
+// planners only need to load them at startup.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/motion_primitives.h>
+
+#include <ros/ros.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+
+namespace meta {
+
+namespace {
+
+// File format identifier ("MPRM") and version.
+const uint32_t kMagic = 0x4d50524d;
+const uint32_t kVersion = 1;
+
+// Greatest common divisor of two non-negative integers.
+int Gcd(int a, int b) {
+  while (b != 0) {
+    const int r = a % b;
+    a = b;
+    b = r;
+  }
+
+  return a;
+}
+
+// Raw binary reads and writes.
+template<typename T>
+void Write(std::ofstream& file, const T& value) {
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool Read(std::ifstream& file, T& value) {
+  return static_cast<bool>(
+    file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+} //\namespace
+
+MotionPrimitives::MotionPrimitives(const Vector3d& max_speed,
+                                   double resolution, size_t max_step)
+  : max_speed_(max_speed),
+    resolution_(resolution),
+    max_step_(max_step) {}
+
+// Factory method. Generates every move to a cell at most max_step cells
+// away along each axis which is not a repeat of a shorter move.
+MotionPrimitives::Ptr MotionPrimitives::
+Create(const Vector3d& max_speed, double resolution, size_t max_step) {
+  Ptr ptr(new MotionPrimitives(max_speed, resolution, max_step));
+
+  const int step = static_cast<int>(max_step);
+  for (int ii = -step; ii <= step; ii++) {
+    for (int jj = -step; jj <= step; jj++) {
+      for (int kk = -step; kk <= step; kk++) {
+        // Skip staying put, and moves that are just a shorter move repeated.
+        const int divisor =
+          Gcd(Gcd(std::abs(ii), std::abs(jj)), std::abs(kk));
+        if (divisor != 1)
+          continue;
+
+        Primitive primitive;
+        primitive.offset_ = {{ ii, jj, kk }};
+        ptr->Complete(primitive);
+        ptr->primitives_.push_back(primitive);
+      }
+    }
+  }
+
+  // Shortest moves first, so that the search tries them first among ties.
+  std::stable_sort(ptr->primitives_.begin(), ptr->primitives_.end(),
+                   [](const Primitive& a, const Primitive& b) {
+                     return a.duration_ < b.duration_;
+                   });
+
+  return ptr;
+}
+
+// Fill in displacement, duration, and collision check points for a
+// primitive whose offset has been set.
+void MotionPrimitives::Complete(Primitive& primitive) const {
+  primitive.displacement_ = resolution_ *
+    Vector3d(primitive.offset_[0], primitive.offset_[1], primitive.offset_[2]);
+  primitive.duration_ =
+    BestPossibleTime(Vector3d::Zero(), primitive.displacement_);
+
+  // No more than half a cell between checks.
+  const size_t num_points = std::max<size_t>(1, static_cast<size_t>(
+    std::ceil(2.0 * primitive.displacement_.norm() / resolution_)));
+
+  primitive.points_.clear();
+  primitive.times_.clear();
+  for (size_t ii = 1; ii <= num_points; ii++) {
+    const double fraction =
+      static_cast<double>(ii) / static_cast<double>(num_points);
+
+    primitive.points_.push_back(fraction * primitive.displacement_);
+    primitive.times_.push_back(fraction * primitive.duration_);
+  }
+}
+
+// Load a library from a file. Returns null if the file could not be read.
+MotionPrimitives::Ptr MotionPrimitives::Load(const std::string& file_name) {
+  std::ifstream file(file_name.c_str(), std::ios::binary);
+  if (!file.is_open())
+    return nullptr;
+
+  uint32_t magic, version;
+  if (!Read(file, magic) || !Read(file, version) ||
+      magic != kMagic || version != kVersion) {
+    ROS_WARN("MotionPrimitives: %s is not a motion primitive library.",
+             file_name.c_str());
+    return nullptr;
+  }
+
+  Vector3d max_speed;
+  double resolution;
+  uint64_t max_step, num_primitives;
+  if (!Read(file, max_speed(0)) || !Read(file, max_speed(1)) ||
+      !Read(file, max_speed(2)) || !Read(file, resolution) ||
+      !Read(file, max_step) || !Read(file, num_primitives)) {
+    ROS_WARN("MotionPrimitives: %s is truncated.", file_name.c_str());
+    return nullptr;
+  }
+
+  Ptr ptr(new MotionPrimitives(max_speed, resolution,
+                               static_cast<size_t>(max_step)));
+  ptr->primitives_.resize(num_primitives);
+
+  for (auto& primitive : ptr->primitives_) {
+    int32_t offset[3];
+    uint64_t num_points;
+    if (!Read(file, offset[0]) || !Read(file, offset[1]) ||
+        !Read(file, offset[2]) || !Read(file, primitive.duration_) ||
+        !Read(file, num_points)) {
+      ROS_WARN("MotionPrimitives: %s is truncated.", file_name.c_str());
+      return nullptr;
+    }
+
+    primitive.offset_ = {{ offset[0], offset[1], offset[2] }};
+    primitive.displacement_ = resolution *
+      Vector3d(offset[0], offset[1], offset[2]);
+
+    primitive.points_.resize(num_points);
+    primitive.times_.resize(num_points);
+    for (size_t ii = 0; ii < num_points; ii++) {
+      if (!Read(file, primitive.points_[ii](0)) ||
+          !Read(file, primitive.points_[ii](1)) ||
+          !Read(file, primitive.points_[ii](2)) ||
+          !Read(file, primitive.times_[ii])) {
+        ROS_WARN("MotionPrimitives: %s is truncated.", file_name.c_str());
+        return nullptr;
+      }
+    }
+  }
+
+  return ptr;
+}
+
+// Save to a file.
+bool MotionPrimitives::Save(const std::string& file_name) const {
+  std::ofstream file(file_name.c_str(), std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  Write(file, kMagic);
+  Write(file, kVersion);
+  Write(file, max_speed_(0));
+  Write(file, max_speed_(1));
+  Write(file, max_speed_(2));
+  Write(file, resolution_);
+  Write(file, static_cast<uint64_t>(max_step_));
+  Write(file, static_cast<uint64_t>(primitives_.size()));
+
+  for (const auto& primitive : primitives_) {
+    for (size_t ii = 0; ii < 3; ii++)
+      Write(file, static_cast<int32_t>(primitive.offset_[ii]));
+
+    Write(file, primitive.duration_);
+    Write(file, static_cast<uint64_t>(primitive.points_.size()));
+
+    for (size_t ii = 0; ii < primitive.points_.size(); ii++) {
+      Write(file, primitive.points_[ii](0));
+      Write(file, primitive.points_[ii](1));
+      Write(file, primitive.points_[ii](2));
+      Write(file, primitive.times_[ii]);
+    }
+  }
+
+  return static_cast<bool>(file);
+}
+
+// Check if this library was generated for the given configuration.
+bool MotionPrimitives::Matches(const Vector3d& max_speed, double resolution,
+                               size_t max_step) const {
+  return (max_speed - max_speed_).cwiseAbs().maxCoeff() < 1e-8 &&
+    std::abs(resolution - resolution_) < 1e-8 &&
+    max_step == max_step_;
+}
+
+} //\namespace meta
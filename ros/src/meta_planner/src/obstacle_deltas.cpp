@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ObstacleDeltas class, which turns the obstacles a sensor sees
+// on each tick into incremental SensorMeasurement messages.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <demo/obstacle_deltas.h>
+
+namespace meta {
+
+// Diff the obstacles sensed at the given time against what has already
+// been reported, and fill in 'msg' with the result.
+bool ObstacleDeltas::Update(const std::vector<uint64_t>& ids,
+                            const std::vector<Vector3d>& positions,
+                            const std::vector<Vector3d>& velocities,
+                            const std::vector<double>& radii,
+                            const ObstacleStore& environment,
+                            const ros::Time& stamp,
+                            meta_planner_msgs::SensorMeasurement& msg) {
+  // Tolerances below which an obstacle is considered unchanged, i.e. where
+  // the listener would predict it to be anyway.
+  const double kPositionTolerance = 0.01;
+  const double kVelocityTolerance = 0.01;
+
+  const double time = stamp.toSec();
+  const bool full_resync = time - last_resync_ >= resync_time_;
+
+  msg = meta_planner_msgs::SensorMeasurement();
+  msg.stamp = stamp;
+  msg.full_resync = full_resync;
+
+  // New and changed obstacles.
+  for (size_t ii = 0; ii < ids.size(); ii++) {
+    Reported obstacle;
+    obstacle.position_ = positions[ii];
+    obstacle.velocity_ = velocities[ii];
+    obstacle.radius_ = radii[ii];
+    obstacle.stamp_ = time;
+
+    const auto iter = reported_.find(ids[ii]);
+    if (iter != reported_.end()) {
+      const Reported& last = iter->second;
+      const Vector3d predicted =
+        last.position_ + (time - last.stamp_) * last.velocity_;
+
+      if ((predicted - obstacle.position_).norm() < kPositionTolerance &&
+          (last.velocity_ - obstacle.velocity_).norm() < kVelocityTolerance &&
+          last.radius_ == obstacle.radius_)
+        continue;
+    }
+
+    reported_[ids[ii]] = obstacle;
+
+    if (!full_resync)
+      Append(ids[ii], obstacle, time, msg);
+  }
+
+  // Removed obstacles.
+  for (auto iter = reported_.begin(); iter != reported_.end(); ) {
+    if (environment.Find(iter->first) < 0) {
+      msg.removed_ids.push_back(iter->first);
+      iter = reported_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+
+  // A full resync lists everything reported so far.
+  if (full_resync) {
+    for (const auto& entry : reported_)
+      Append(entry.first, entry.second, time, msg);
+
+    last_resync_ = time;
+  } else if (msg.ids.empty() && msg.removed_ids.empty()) {
+    return false;
+  }
+
+  msg.sequence = ++sequence_;
+  msg.num_obstacles = msg.ids.size();
+  return true;
+}
+
+// Append one obstacle to a message, at its predicted position at the
+// given time.
+void ObstacleDeltas::Append(uint64_t id, const Reported& obstacle,
+                            double time,
+                            meta_planner_msgs::SensorMeasurement& msg) {
+  const Vector3d position =
+    obstacle.position_ + (time - obstacle.stamp_) * obstacle.velocity_;
+
+  geometry_msgs::Vector3 p;
+  p.x = position(0);
+  p.y = position(1);
+  p.z = position(2);
+
+  geometry_msgs::Vector3 v;
+  v.x = obstacle.velocity_(0);
+  v.y = obstacle.velocity_(1);
+  v.z = obstacle.velocity_(2);
+
+  msg.ids.push_back(id);
+  msg.positions.push_back(p);
+  msg.velocities.push_back(v);
+  msg.radii.push_back(obstacle.radius_);
+}
+
+} //\namespace meta
@@ -0,0 +1,500 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ObstacleStore class, which holds a set of spherical obstacles
+// in structure-of-arrays form (separate x, y, z, and radius arrays), along
+// with a constant velocity motion model for each obstacle.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/obstacle_store.h>
+
+#ifdef META_PLANNER_ENABLE_AVX2
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <cmath>
+
+namespace meta {
+
+namespace {
+  // Sentinel obstacles live infinitely far away and have zero radius.
+  const double kSentinelCoordinate = std::numeric_limits<double>::max();
+  const double kSentinelRadius = 0.0;
+
+  // Squared distance from an obstacle center to the closest point of the
+  // box with the given center and half widths.
+  inline double SquaredBoxDistance(double cx, double cy, double cz,
+                                   const Vector3d& point,
+                                   const Vector3d& bound) {
+    const double dx = std::max(std::abs(cx - point(0)) - bound(0), 0.0);
+    const double dy = std::max(std::abs(cy - point(1)) - bound(1), 0.0);
+    const double dz = std::max(std::abs(cz - point(2)) - bound(2), 0.0);
+    return dx * dx + dy * dy + dz * dz;
+  }
+
+#ifdef META_PLANNER_ENABLE_AVX2
+  // The kernels below are compiled for AVX2 one function at a time, so the
+  // rest of the library (and Eigen's alignment) is unaffected, and they only
+  // run if the CPU we are on turns out to support them.
+  bool HasAvx2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+  }
+
+  // Lanes in which a sphere with the given center and radius intersects the
+  // box with the given center and half widths.
+  __attribute__((target("avx2")))
+  inline __m256d BoxSphereHits(__m256d cx, __m256d cy, __m256d cz, __m256d r,
+                               __m256d qx, __m256d qy, __m256d qz,
+                               __m256d bx, __m256d by, __m256d bz) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d sign = _mm256_set1_pd(-0.0);
+
+    __m256d dx = _mm256_andnot_pd(sign, _mm256_sub_pd(cx, qx));
+    __m256d dy = _mm256_andnot_pd(sign, _mm256_sub_pd(cy, qy));
+    __m256d dz = _mm256_andnot_pd(sign, _mm256_sub_pd(cz, qz));
+
+    dx = _mm256_max_pd(_mm256_sub_pd(dx, bx), zero);
+    dy = _mm256_max_pd(_mm256_sub_pd(dy, by), zero);
+    dz = _mm256_max_pd(_mm256_sub_pd(dz, bz), zero);
+
+    const __m256d d2 = _mm256_add_pd(
+      _mm256_mul_pd(dx, dx),
+      _mm256_add_pd(_mm256_mul_pd(dy, dy), _mm256_mul_pd(dz, dz)));
+
+    return _mm256_cmp_pd(d2, _mm256_mul_pd(r, r), _CMP_LE_OQ);
+  }
+
+  // AVX2 version of CheckBlock. Each lane corresponds to one query point.
+  __attribute__((target("avx2")))
+  void CheckBlockAvx2(const double* xs, const double* ys, const double* zs,
+                      const double* rs, size_t size,
+                      const Vector3d* points, size_t num_points,
+                      const Vector3d& bound, bool* valid) {
+    // Transpose query points into lanes. Unused lanes start out invalid.
+    alignas(32) double px[4] = { 0.0, 0.0, 0.0, 0.0 };
+    alignas(32) double py[4] = { 0.0, 0.0, 0.0, 0.0 };
+    alignas(32) double pz[4] = { 0.0, 0.0, 0.0, 0.0 };
+    alignas(32) int64_t alive[4] = { 0, 0, 0, 0 };
+
+    for (size_t jj = 0; jj < num_points; jj++) {
+      px[jj] = points[jj](0);
+      py[jj] = points[jj](1);
+      pz[jj] = points[jj](2);
+      alive[jj] = valid[jj] ? -1 : 0;
+    }
+
+    const __m256d qx = _mm256_load_pd(px);
+    const __m256d qy = _mm256_load_pd(py);
+    const __m256d qz = _mm256_load_pd(pz);
+    const __m256d bx = _mm256_set1_pd(bound(0));
+    const __m256d by = _mm256_set1_pd(bound(1));
+    const __m256d bz = _mm256_set1_pd(bound(2));
+    __m256d mask = _mm256_castsi256_pd(
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(alive)));
+
+    if (_mm256_movemask_pd(mask) == 0)
+      return;
+
+    for (size_t ii = 0; ii < size; ii++) {
+      // Each lane is one box, all against the same obstacle.
+      const __m256d hit = BoxSphereHits(
+        _mm256_set1_pd(xs[ii]), _mm256_set1_pd(ys[ii]),
+        _mm256_set1_pd(zs[ii]), _mm256_set1_pd(rs[ii]),
+        qx, qy, qz, bx, by, bz);
+
+      // Clear lanes that hit this obstacle, and stop if none are left.
+      mask = _mm256_andnot_pd(hit, mask);
+      if (_mm256_movemask_pd(mask) == 0)
+        break;
+    }
+
+    const int alive_bits = _mm256_movemask_pd(mask);
+    for (size_t jj = 0; jj < num_points; jj++)
+      valid[jj] = (alive_bits >> jj) & 1;
+  }
+
+  // AVX2 version of CheckPoint. Each lane corresponds to one obstacle, and
+  // padding guarantees that the aligned loads never run off the end of the
+  // arrays. If velocities are given, obstacles are first moved to their
+  // predicted positions at the given time.
+  __attribute__((target("avx2")))
+  bool CheckPointAvx2(const double* xs, const double* ys, const double* zs,
+                      const double* rs, const double* vxs, const double* vys,
+                      const double* vzs, const double* ts, size_t size,
+                      const Vector3d& point, double time,
+                      const Vector3d& bound) {
+    const __m256d qx = _mm256_set1_pd(point(0));
+    const __m256d qy = _mm256_set1_pd(point(1));
+    const __m256d qz = _mm256_set1_pd(point(2));
+    const __m256d bx = _mm256_set1_pd(bound(0));
+    const __m256d by = _mm256_set1_pd(bound(1));
+    const __m256d bz = _mm256_set1_pd(bound(2));
+    const __m256d t = _mm256_set1_pd(time);
+
+    for (size_t ii = 0; ii < size; ii += 4) {
+      __m256d cx = _mm256_load_pd(xs + ii);
+      __m256d cy = _mm256_load_pd(ys + ii);
+      __m256d cz = _mm256_load_pd(zs + ii);
+
+      if (vxs != nullptr) {
+        const __m256d dt = _mm256_sub_pd(t, _mm256_load_pd(ts + ii));
+        cx = _mm256_add_pd(cx, _mm256_mul_pd(dt, _mm256_load_pd(vxs + ii)));
+        cy = _mm256_add_pd(cy, _mm256_mul_pd(dt, _mm256_load_pd(vys + ii)));
+        cz = _mm256_add_pd(cz, _mm256_mul_pd(dt, _mm256_load_pd(vzs + ii)));
+      }
+
+      const __m256d hit = BoxSphereHits(
+        cx, cy, cz, _mm256_load_pd(rs + ii), qx, qy, qz, bx, by, bz);
+
+      if (_mm256_movemask_pd(hit) != 0)
+        return false;
+    }
+
+    return true;
+  }
+#endif
+} //\namespace
+
+// Factory method. Use this instead of the constructor.
+ObstacleStore::Ptr ObstacleStore::Create() {
+  ObstacleStore::Ptr ptr(new ObstacleStore());
+  return ptr;
+}
+
+// Deep copy of this store, with the same version number.
+ObstacleStore::Ptr ObstacleStore::Clone() const {
+  ObstacleStore::Ptr ptr(new ObstacleStore(*this));
+  return ptr;
+}
+
+// Add a spherical obstacle, optionally moving at constant velocity from
+// the given point, which was measured at the given time stamp. Assigns
+// the next unused ID.
+void ObstacleStore::Add(const Vector3d& point, double radius,
+                        const Vector3d& velocity, double stamp) {
+  Add(next_id_, point, radius, velocity, stamp);
+}
+
+// Same as above, but with the given ID.
+void ObstacleStore::Add(uint64_t id, const Vector3d& point, double radius,
+                        const Vector3d& velocity, double stamp) {
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (Find(id) >= 0) {
+    ROS_ERROR("ObstacleStore: Tried to add obstacle %lu twice.",
+              static_cast<unsigned long>(id));
+    return;
+  }
+#endif
+
+  // Drop padding, append, and re-pad.
+  xs_.resize(size_);
+  ys_.resize(size_);
+  zs_.resize(size_);
+  rs_.resize(size_);
+  vxs_.resize(size_);
+  vys_.resize(size_);
+  vzs_.resize(size_);
+  ts_.resize(size_);
+
+  xs_.push_back(point(0));
+  ys_.push_back(point(1));
+  zs_.push_back(point(2));
+  rs_.push_back(radius);
+  vxs_.push_back(velocity(0));
+  vys_.push_back(velocity(1));
+  vzs_.push_back(velocity(2));
+  ts_.push_back(stamp);
+  ids_.push_back(id);
+  index_[id] = size_;
+  size_++;
+
+  next_id_ = std::max(next_id_, id + 1);
+  if (!velocity.isZero())
+    num_moving_++;
+
+  Pad();
+  swept_bins_.clear();
+}
+
+// Remove an obstacle. The last obstacle takes its place.
+void ObstacleStore::Remove(size_t ii) {
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (ii >= size_) {
+    ROS_ERROR("ObstacleStore: Tried to remove obstacle %zu of %zu.",
+              ii, size_);
+    return;
+  }
+#endif
+
+  if (!Velocity(ii).isZero())
+    num_moving_--;
+
+  index_.erase(ids_[ii]);
+
+  // Move the last obstacle into this slot.
+  const size_t last = size_ - 1;
+  if (ii != last) {
+    xs_[ii] = xs_[last];
+    ys_[ii] = ys_[last];
+    zs_[ii] = zs_[last];
+    rs_[ii] = rs_[last];
+    vxs_[ii] = vxs_[last];
+    vys_[ii] = vys_[last];
+    vzs_[ii] = vzs_[last];
+    ts_[ii] = ts_[last];
+    ids_[ii] = ids_[last];
+    index_[ids_[ii]] = ii;
+  }
+
+  // Drop the last obstacle and re-pad.
+  size_--;
+  xs_.resize(size_);
+  ys_.resize(size_);
+  zs_.resize(size_);
+  rs_.resize(size_);
+  vxs_.resize(size_);
+  vys_.resize(size_);
+  vzs_.resize(size_);
+  ts_.resize(size_);
+  ids_.resize(size_);
+
+  Pad();
+  swept_bins_.clear();
+}
+
+// Move an existing obstacle.
+void ObstacleStore::SetPoint(size_t ii, const Vector3d& point) {
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (ii >= size_) {
+    ROS_ERROR("ObstacleStore: Tried to move obstacle %zu of %zu.", ii, size_);
+    return;
+  }
+#endif
+
+  xs_[ii] = point(0);
+  ys_[ii] = point(1);
+  zs_[ii] = point(2);
+  swept_bins_.clear();
+}
+
+// Update the motion model of an existing obstacle.
+void ObstacleStore::SetMotion(size_t ii, const Vector3d& point,
+                              const Vector3d& velocity, double stamp) {
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (ii >= size_) {
+    ROS_ERROR("ObstacleStore: Tried to move obstacle %zu of %zu.", ii, size_);
+    return;
+  }
+#endif
+
+  if (!Velocity(ii).isZero())
+    num_moving_--;
+  if (!velocity.isZero())
+    num_moving_++;
+
+  SetPoint(ii, point);
+  vxs_[ii] = velocity(0);
+  vys_[ii] = velocity(1);
+  vzs_[ii] = velocity(2);
+  ts_[ii] = stamp;
+}
+
+// Index the volumes swept out by all obstacles over the time interval
+// [start, start + horizon], in bins of length bin_dt. Over one bin, an
+// obstacle stays inside the sphere centered on its position at the middle
+// of the bin, inflated by half the distance it travels during the bin.
+void ObstacleStore::BuildSweptIndex(double start, double horizon,
+                                    double bin_dt) {
+  swept_bins_.clear();
+
+  // Static obstacles gain nothing from an index.
+  if (num_moving_ == 0 || horizon <= 0.0 || bin_dt <= 0.0)
+    return;
+
+  const size_t num_bins = static_cast<size_t>(std::ceil(horizon / bin_dt));
+  swept_bins_.reserve(num_bins);
+
+  for (size_t kk = 0; kk < num_bins; kk++) {
+    const double mid = start + (static_cast<double>(kk) + 0.5) * bin_dt;
+
+    const ObstacleStore::Ptr bin = ObstacleStore::Create();
+    for (size_t ii = 0; ii < size_; ii++)
+      bin->Add(PointAt(ii, mid),
+               rs_[ii] + 0.5 * bin_dt * Velocity(ii).norm());
+
+    swept_bins_.push_back(bin);
+  }
+
+  swept_start_ = start;
+  swept_bin_dt_ = bin_dt;
+}
+
+// Pad arrays up to the next multiple of kNumLanes with sentinels.
+void ObstacleStore::Pad() {
+  const size_t padded =
+    ((size_ + kNumLanes - 1) / kNumLanes) * kNumLanes;
+
+  xs_.resize(padded, kSentinelCoordinate);
+  ys_.resize(padded, kSentinelCoordinate);
+  zs_.resize(padded, kSentinelCoordinate);
+  rs_.resize(padded, kSentinelRadius);
+  vxs_.resize(padded, 0.0);
+  vys_.resize(padded, 0.0);
+  vzs_.resize(padded, 0.0);
+  ts_.resize(padded, 0.0);
+}
+
+// Check a block of at most kNumLanes query points against every obstacle.
+// Each lane corresponds to one query point. As soon as every lane has hit an
+// obstacle there is nothing left to learn, so we stop early.
+void ObstacleStore::CheckBlock(const Vector3d* points, size_t num_points,
+                               const Vector3d& bound, bool* valid) const {
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (num_points > kNumLanes) {
+    ROS_ERROR("ObstacleStore: Block of %zu points is too large.", num_points);
+    num_points = kNumLanes;
+  }
+#endif
+
+#ifdef META_PLANNER_ENABLE_AVX2
+  if (HasAvx2()) {
+    CheckBlockAvx2(xs_.data(), ys_.data(), zs_.data(), rs_.data(), size_,
+                   points, num_points, bound, valid);
+    return;
+  }
+#endif
+
+  // Scalar fallback with the same early exit.
+  size_t num_alive = 0;
+  for (size_t jj = 0; jj < num_points; jj++)
+    num_alive += valid[jj];
+
+  for (size_t ii = 0; ii < size_ && num_alive > 0; ii++) {
+    const double r2 = rs_[ii] * rs_[ii];
+
+    for (size_t jj = 0; jj < num_points; jj++) {
+      if (valid[jj] &&
+          SquaredBoxDistance(xs_[ii], ys_[ii], zs_[ii],
+                             points[jj], bound) <= r2) {
+        valid[jj] = false;
+        num_alive--;
+      }
+    }
+  }
+}
+
+// Check a single point against every obstacle. Returns true if collision
+// free.
+bool ObstacleStore::CheckPoint(const Vector3d& point,
+                               const Vector3d& bound) const {
+#ifdef META_PLANNER_ENABLE_AVX2
+  if (HasAvx2())
+    return CheckPointAvx2(xs_.data(), ys_.data(), zs_.data(), rs_.data(),
+                          nullptr, nullptr, nullptr, nullptr, size_,
+                          point, 0.0, bound);
+#endif
+
+  for (size_t ii = 0; ii < size_; ii++) {
+    if (SquaredBoxDistance(xs_[ii], ys_[ii], zs_[ii], point, bound) <=
+        rs_[ii] * rs_[ii])
+      return false;
+  }
+
+  return true;
+}
+
+// Check a single point against every obstacle's predicted position at the
+// given time. Returns true if collision free.
+bool ObstacleStore::CheckPoint(const Vector3d& point, double time,
+                               const Vector3d& bound) const {
+  if (num_moving_ == 0)
+    return CheckPoint(point, bound);
+
+  // Broad phase. Bounding spheres contain the swept volumes, so if they are
+  // all clear then so are the obstacles themselves.
+  if (!swept_bins_.empty() && time >= swept_start_) {
+    const size_t kk =
+      static_cast<size_t>((time - swept_start_) / swept_bin_dt_);
+
+    if (kk < swept_bins_.size() && swept_bins_[kk]->CheckPoint(point, bound))
+      return true;
+  }
+
+  // Exact check against predicted positions.
+#ifdef META_PLANNER_ENABLE_AVX2
+  if (HasAvx2())
+    return CheckPointAvx2(xs_.data(), ys_.data(), zs_.data(), rs_.data(),
+                          vxs_.data(), vys_.data(), vzs_.data(), ts_.data(),
+                          size_, point, time, bound);
+#endif
+
+  for (size_t ii = 0; ii < size_; ii++) {
+    const Vector3d p = PointAt(ii, time);
+    if (SquaredBoxDistance(p(0), p(1), p(2), point, bound) <=
+        rs_[ii] * rs_[ii])
+      return false;
+  }
+
+  return true;
+}
+
+// Check whether some single obstacle collides with every query point in the
+// axis-aligned box from lower to upper. Each query point is surrounded by a
+// box with the given half widths, as in CheckPoint.
+bool ObstacleStore::CoversBox(const Vector3d& lower, const Vector3d& upper,
+                              const Vector3d& bound) const {
+  for (size_t ii = 0; ii < size_; ii++) {
+    const Vector3d center = Point(ii);
+
+    // The query point farthest from this obstacle is at a corner, so along
+    // each axis take whichever face is farther.
+    const Vector3d farthest =
+      (center - lower).cwiseAbs().cwiseMax((center - upper).cwiseAbs());
+    if ((farthest - bound).cwiseMax(0.0).squaredNorm() <= rs_[ii] * rs_[ii])
+      return true;
+  }
+
+  return false;
+}
+
+} //\namespace meta
@@ -70,6 +70,7 @@ bool Planner::LoadParameters(const ros::NodeHandle& n) {
 
   // Sensor radius.
   if (!nl.getParam("srv/best_time", best_time_name_)) return false;
+  if (!nl.getParam("srv/max_planner_speed", max_speed_name_)) return false;
 
   return true;
 }
@@ -83,6 +84,10 @@ bool Planner::RegisterCallbacks(const ros::NodeHandle& n) {
   best_time_srv_ = nl.serviceClient<value_function_srvs::GeometricPlannerTime>(
     best_time_name_.c_str(), true);
 
+  ros::service::waitForService(max_speed_name_.c_str());
+  max_speed_srv_ = nl.serviceClient<value_function_srvs::GeometricPlannerSpeed>(
+    max_speed_name_.c_str(), true);
+
   return true;
 }
 
@@ -91,6 +96,8 @@ double Planner::
 BestPossibleTime(const Vector3d& start, const Vector3d& stop) const {
   double best_time = std::numeric_limits<double>::infinity();
 
+  std::lock_guard<std::mutex> lock(best_time_mutex_);
+
   // Make sure the server is up.
   if (!best_time_srv_) {
     ROS_WARN("%s: Best time server disconnected.", name_.c_str());
@@ -114,4 +121,36 @@ BestPossibleTime(const Vector3d& start, const Vector3d& stop) const {
   return best_time;
 }
 
+// Maximum speed of this planner along each axis. Returns false if the
+// server could not be reached.
+bool Planner::MaxSpeed(Vector3d& speed) const {
+  std::lock_guard<std::mutex> lock(best_time_mutex_);
+
+  if (!have_max_speed_) {
+    // Make sure the server is up.
+    if (!max_speed_srv_) {
+      ROS_WARN("%s: Max planner speed server disconnected.", name_.c_str());
+
+      ros::NodeHandle nl;
+      max_speed_srv_ = nl.serviceClient<value_function_srvs::GeometricPlannerSpeed>(
+        max_speed_name_.c_str(), true);
+      return false;
+    }
+
+    // Call the server.
+    value_function_srvs::GeometricPlannerSpeed s;
+    s.request.id = incoming_value_;
+    if (!max_speed_srv_.call(s)) {
+      ROS_ERROR("%s: Error calling max planner speed server.", name_.c_str());
+      return false;
+    }
+
+    max_speed_ = Vector3d(s.response.x, s.response.y, s.response.z);
+    have_max_speed_ = true;
+  }
+
+  speed = max_speed_;
+  return true;
+}
+
 } //\namespace meta
@@ -0,0 +1,498 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the RoadmapPlanner class, which inherits from Planner. It keeps a
+// lazy probabilistic roadmap which persists across queries: vertices are
+// added in the background by Grow(), and edges are only collision checked
+// when a query wants to use them. Each check is remembered for the
+// environment version it was made against, so edges are revalidated only
+// once obstacles change. The roadmap can be saved to and loaded from disk.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/roadmap_planner.h>
+#include <meta_planner/straight_line_planner.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace meta {
+
+namespace {
+
+const size_t kNone = std::numeric_limits<size_t>::max();
+
+// An edge from the start point or to the stop point of a query. These only
+// exist for the one query, so their checks are not remembered.
+struct Link {
+  size_t vertex_;
+  double cost_;
+  bool checked_;
+  bool valid_;
+};
+
+// Pack an edge check for the given environment version. Never zero, which
+// marks an edge that has not been checked.
+inline uint64_t PackCheck(uint64_t version, bool valid) {
+  return ((version + 1) << 1) | (valid ? 1 : 0);
+}
+
+// Weights of the L-infinity metric for the given maximum speeds, so that
+// distance is the time needed at best scaled back to a length along the
+// fastest axis, as in the meta planner. Plain L-infinity without speeds.
+inline Vector3d MetricWeights(const Vector3d& speed) {
+  if ((speed.array() <= 0.0).any())
+    return Vector3d::Ones();
+
+  return speed.maxCoeff() * speed.cwiseInverse();
+}
+
+} //\namespace
+
+const size_t RoadmapPlanner::kNumNeighbors;
+
+RoadmapPlanner::RoadmapPlanner(ValueFunctionId incoming_value,
+                               ValueFunctionId outgoing_value,
+                               const Box::ConstPtr& space,
+                               const Dynamics::ConstPtr& dynamics,
+                               size_t max_vertices, double connection_radius)
+  : Planner(incoming_value, outgoing_value, space, dynamics),
+    max_vertices_(max_vertices),
+    connection_radius_(connection_radius) {}
+
+// Factory method. Use this instead of the constructor.
+RoadmapPlanner::Ptr RoadmapPlanner::
+Create(ValueFunctionId incoming_value,
+       ValueFunctionId outgoing_value,
+       const Box::ConstPtr& space,
+       const Dynamics::ConstPtr& dynamics,
+       size_t max_vertices, double connection_radius) {
+  Ptr ptr(new RoadmapPlanner(incoming_value, outgoing_value, space, dynamics,
+                             max_vertices, connection_radius));
+  return ptr;
+}
+
+// Find a path through the roadmap between two points, or return null.
+Trajectory::Ptr RoadmapPlanner::
+Plan(const Vector3d& start, const Vector3d& stop,
+     double start_time, double budget) const {
+  const std::atomic<bool> cancel(false);
+  return Plan(start, stop, start_time, budget, cancel);
+}
+
+// Same as above, but give up as soon as cancel becomes true.
+// (1) Join the start and stop points to their nearest vertices.
+// (2) Find the fastest path, skipping edges known to be blocked.
+// (3) Check its edges. If any is blocked, go to (2).
+// (4) Check the whole path against moving obstacles at its time stamps.
+Trajectory::Ptr RoadmapPlanner::
+Plan(const Vector3d& start, const Vector3d& stop,
+     double start_time, double budget,
+     const std::atomic<bool>& cancel) const {
+  const double end_time = ros::Time::now().toSec() + budget;
+
+  Vector3d speed;
+  if (!MaxSpeed(speed))
+    return nullptr;
+
+  if (!space_->IsValid(start, incoming_value_, outgoing_value_))
+    return nullptr;
+
+  boost::shared_lock<boost::shared_mutex> lock(mutex_);
+  const size_t num_vertices = vertices_.size();
+  const uint64_t version = space_->CheckedVersion();
+
+  // (1) Join the start and stop points to their nearest vertices.
+  std::vector<Link> start_links;
+  for (size_t vertex : Neighbors(start)) {
+    const Link link = {
+      vertex, Cost(start, vertices_[vertex], speed), false, false };
+    start_links.push_back(link);
+  }
+
+  std::vector<Link> stop_links;
+  for (size_t vertex : Neighbors(stop)) {
+    const Link link = {
+      vertex, Cost(vertices_[vertex], stop, speed), false, false };
+    stop_links.push_back(link);
+  }
+
+  if (start_links.empty() || stop_links.empty())
+    return nullptr;
+
+  // Search over the roadmap's vertices, then the start and stop points.
+  const size_t source = num_vertices;
+  const size_t target = num_vertices + 1;
+  const auto position = [&](size_t node) -> const Vector3d& {
+    return (node == source) ? start :
+      ((node == target) ? stop : vertices_[node]);
+  };
+
+  // Every pass rules out at least one more edge, so this ends even without
+  // a budget.
+  while (!cancel && ros::Time::now().toSec() <= end_time) {
+    // (2) Find the fastest path, skipping edges known to be blocked. Each
+    // node remembers which edge (or link) it was reached by.
+    std::vector<double> g(num_vertices + 2,
+                          std::numeric_limits<double>::infinity());
+    std::vector<size_t> parent(num_vertices + 2, kNone);
+    std::vector<size_t> via(num_vertices + 2, kNone);
+    std::vector<bool> closed(num_vertices + 2, false);
+
+    typedef std::pair<double, size_t> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+
+    const auto relax = [&](size_t from, size_t to, double cost, size_t edge) {
+      const double candidate = g[from] + cost;
+      if (candidate < g[to]) {
+        g[to] = candidate;
+        parent[to] = from;
+        via[to] = edge;
+        open.push(Entry(candidate + Cost(position(to), stop, speed), to));
+      }
+    };
+
+    g[source] = 0.0;
+    open.push(Entry(Cost(start, stop, speed), source));
+
+    while (!open.empty()) {
+      const size_t node = open.top().second;
+      open.pop();
+
+      if (closed[node])
+        continue;
+
+      closed[node] = true;
+      if (node == target)
+        break;
+
+      if (node == source) {
+        for (size_t ii = 0; ii < start_links.size(); ii++) {
+          const Link& link = start_links[ii];
+          if (!link.checked_ || link.valid_)
+            relax(source, link.vertex_, link.cost_, ii);
+        }
+
+        continue;
+      }
+
+      for (size_t edge_index : adjacency_[node]) {
+        const Edge& edge = edges_[edge_index];
+        if (checks_[edge_index].load() == PackCheck(version, false))
+          continue;
+
+        relax(node, (edge.from_ == node) ? edge.to_ : edge.from_,
+              edge.cost_, edge_index);
+      }
+
+      for (size_t ii = 0; ii < stop_links.size(); ii++) {
+        const Link& link = stop_links[ii];
+        if (link.vertex_ == node && (!link.checked_ || link.valid_))
+          relax(node, target, link.cost_, ii);
+      }
+    }
+
+    if (!closed[target])
+      return nullptr;
+
+    std::vector<size_t> path;
+    for (size_t node = target; node != kNone; node = parent[node])
+      path.push_back(node);
+
+    std::reverse(path.begin(), path.end());
+
+    // (3) Check all of its edges, remembering the results, so that the next
+    // search avoids every blocked edge found along the way.
+    bool blocked = false;
+    for (size_t ii = 1; ii < path.size(); ii++) {
+      const size_t from = path[ii - 1];
+      const size_t to = path[ii];
+
+      if (from == source || to == target) {
+        Link& link = (from == source) ?
+          start_links[via[to]] : stop_links[via[to]];
+
+        if (!link.checked_) {
+          link.valid_ = IsValidSegment(position(from), position(to));
+          link.checked_ = true;
+        }
+
+        blocked = blocked || !link.valid_;
+      } else {
+        // Another query may check the same edge at the same time. Both get
+        // the same answer, so either store is fine.
+        std::atomic<uint64_t>& check = checks_[via[to]];
+        const uint64_t last = check.load();
+        bool valid = (last == PackCheck(version, true));
+        if (!valid && last != PackCheck(version, false)) {
+          valid = IsValidSegment(position(from), position(to));
+          check.store(PackCheck(version, valid));
+        }
+
+        blocked = blocked || !valid;
+      }
+    }
+
+    if (blocked)
+      continue;
+
+    // (4) Check the whole path against moving obstacles at its time stamps,
+    // at the same resolution as above.
+    const double resolution = StraightLinePlanner::kResolutionFraction *
+      (space_->UpperBounds() - space_->LowerBounds()).norm();
+
+    std::vector<Vector3d> positions = { start };
+    std::vector<double> times = { start_time };
+    for (size_t ii = 1; ii < path.size(); ii++) {
+      const Vector3d& from = position(path[ii - 1]);
+      const Vector3d& to = position(path[ii]);
+      const double duration = Cost(from, to, speed);
+
+      const size_t num_segments = std::max<size_t>(
+        1, static_cast<size_t>(std::ceil((to - from).norm() / resolution)));
+
+      for (size_t jj = 1; jj <= num_segments; jj++) {
+        const double fraction =
+          static_cast<double>(jj) / static_cast<double>(num_segments);
+
+        if (!space_->IsValid(from + fraction * (to - from),
+                             times.back() + fraction * duration,
+                             incoming_value_, outgoing_value_))
+          return nullptr;
+      }
+
+      positions.push_back(to);
+      times.push_back(times.back() + duration);
+    }
+
+    // Convert to full state space. Make sure to use the INCOMING VALUE!
+    const std::vector<ValueFunctionId> values(
+      positions.size(), incoming_value_);
+
+    return Trajectory::Create(
+      times, dynamics_->LiftGeometricTrajectory(positions, times),
+      values, values);
+  }
+
+  return nullptr;
+}
+
+// Draw up to num_samples more samples, and add the valid ones to the
+// roadmap. Returns the number of vertices added.
+size_t RoadmapPlanner::Grow(size_t num_samples) {
+  Vector3d speed;
+  if (!MaxSpeed(speed))
+    return 0;
+
+  boost::unique_lock<boost::shared_mutex> lock(mutex_);
+  if (kdtree_ == nullptr)
+    kdtree_.reset(new KdTree<size_t>(MetricWeights(speed)));
+
+  size_t num_added = 0;
+  for (size_t ii = 0; ii < num_samples && vertices_.size() < max_vertices_;
+       ii++) {
+    const Vector3d sample = space_->Sample(sequence_);
+    if (!space_->IsValid(sample, incoming_value_, outgoing_value_))
+      continue;
+
+    const std::vector<size_t> neighbors = Neighbors(sample);
+
+    vertices_.push_back(sample);
+    kdtree_->Insert(sample, vertices_.size() - 1);
+    adjacency_.emplace_back();
+    for (size_t neighbor : neighbors)
+      AddEdge(neighbor, vertices_.size() - 1, speed);
+
+    num_added++;
+  }
+
+  return num_added;
+}
+
+// Number of vertices, and whether there is room for more.
+size_t RoadmapPlanner::Size() const {
+  boost::shared_lock<boost::shared_mutex> lock(mutex_);
+  return vertices_.size();
+}
+
+bool RoadmapPlanner::Full() const {
+  boost::shared_lock<boost::shared_mutex> lock(mutex_);
+  return vertices_.size() >= max_vertices_;
+}
+
+// Add an (unchecked) edge. Assumes the lock is held for writing.
+void RoadmapPlanner::AddEdge(size_t from, size_t to, const Vector3d& speed) {
+  const Edge edge = {
+    from, to, Cost(vertices_[from], vertices_[to], speed) };
+
+  adjacency_[from].push_back(edges_.size());
+  adjacency_[to].push_back(edges_.size());
+  edges_.push_back(edge);
+  checks_.emplace_back(0);
+}
+
+// Vertices within the connection radius of a point, nearest first, at most
+// kNumNeighbors of them. Assumes the lock is held for reading.
+std::vector<size_t> RoadmapPlanner::Neighbors(const Vector3d& point) const {
+  if (kdtree_ == nullptr)
+    return std::vector<size_t>();
+
+  std::vector<size_t> neighbors(kNumNeighbors);
+  double distances[kNumNeighbors];
+
+  neighbors.resize(kdtree_->KnnSearch(point, kNumNeighbors, neighbors.data(),
+                                      distances, connection_radius_));
+  return neighbors;
+}
+
+// Collision check the straight line between two points against the current
+// obstacles, at the resolution OMPL uses for motions. The start point itself
+// is not checked.
+bool RoadmapPlanner::IsValidSegment(const Vector3d& from,
+                                    const Vector3d& to) const {
+  const double resolution = StraightLinePlanner::kResolutionFraction *
+    (space_->UpperBounds() - space_->LowerBounds()).norm();
+  const size_t num_segments = std::max<size_t>(
+    1, static_cast<size_t>(std::ceil((to - from).norm() / resolution)));
+
+  std::vector<Vector3d> points(num_segments);
+  for (size_t ii = 1; ii <= num_segments; ii++)
+    points[ii - 1] = from + (to - from) *
+      (static_cast<double>(ii) / static_cast<double>(num_segments));
+
+  std::vector<bool> mask;
+  space_->IsValidBatch(points, incoming_value_, outgoing_value_, mask);
+  return std::find(mask.begin(), mask.end(), false) == mask.end();
+}
+
+// Load the roadmap from a file.
+bool RoadmapPlanner::Load(const std::string& file_name) {
+  Vector3d speed;
+  if (!MaxSpeed(speed))
+    return false;
+
+  std::ifstream file(file_name.c_str());
+  if (!file.is_open())
+    return false;
+
+  size_t incoming_value, outgoing_value;
+  size_t num_samples, num_vertices, num_edges;
+  if (!(file >> incoming_value >> outgoing_value >>
+        num_samples >> num_vertices >> num_edges) ||
+      incoming_value != incoming_value_ ||
+      outgoing_value != outgoing_value_) {
+    ROS_WARN("%s: %s does not match this roadmap.",
+             name_.c_str(), file_name.c_str());
+    return false;
+  }
+
+  // Roadmaps from a different environment are of no use.
+  std::vector<Vector3d> vertices(num_vertices);
+  for (auto& vertex : vertices) {
+    if (!(file >> vertex(0) >> vertex(1) >> vertex(2))) {
+      ROS_WARN("%s: %s is truncated.", name_.c_str(), file_name.c_str());
+      return false;
+    }
+
+    if ((vertex.array() < space_->LowerBounds().array()).any() ||
+        (vertex.array() > space_->UpperBounds().array()).any()) {
+      ROS_WARN("%s: %s was saved for different bounds.",
+               name_.c_str(), file_name.c_str());
+      return false;
+    }
+  }
+
+  std::vector< std::pair<size_t, size_t> > pairs(num_edges);
+  for (auto& pair : pairs) {
+    if (!(file >> pair.first >> pair.second) ||
+        pair.first >= num_vertices || pair.second >= num_vertices) {
+      ROS_WARN("%s: %s is truncated or corrupt.",
+               name_.c_str(), file_name.c_str());
+      return false;
+    }
+  }
+
+  boost::unique_lock<boost::shared_mutex> lock(mutex_);
+  vertices_.swap(vertices);
+  edges_.clear();
+  checks_.clear();
+
+  kdtree_.reset(new KdTree<size_t>(MetricWeights(speed)));
+  for (size_t ii = 0; ii < vertices_.size(); ii++)
+    kdtree_->Insert(vertices_[ii], ii);
+
+  adjacency_.assign(vertices_.size(), std::vector<size_t>());
+  for (const auto& pair : pairs)
+    AddEdge(pair.first, pair.second, speed);
+
+  // Pick up the sequence where it left off, so that new vertices do not
+  // repeat old ones.
+  sequence_ = HaltonSequence();
+  sequence_.Skip(num_samples);
+
+  return true;
+}
+
+// Save the roadmap to a file.
+bool RoadmapPlanner::Save(const std::string& file_name) const {
+  std::ofstream file(file_name.c_str());
+  if (!file.is_open())
+    return false;
+
+  boost::shared_lock<boost::shared_mutex> lock(mutex_);
+
+  file.precision(17);
+  file << incoming_value_ << " " << outgoing_value_ << " "
+       << sequence_.Index() << " " << vertices_.size() << " "
+       << edges_.size() << std::endl;
+
+  for (const auto& vertex : vertices_)
+    file << vertex(0) << " " << vertex(1) << " " << vertex(2) << std::endl;
+
+  for (const auto& edge : edges_)
+    file << edge.from_ << " " << edge.to_ << std::endl;
+
+  return static_cast<bool>(file);
+}
+
+} //\namespace meta
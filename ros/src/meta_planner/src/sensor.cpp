@@ -129,6 +129,11 @@ bool Sensor::LoadParameters(const ros::NodeHandle& n) {
   // Time step.
   if (!nl.getParam("sensor/time_step", time_step_)) return false;
 
+  // Time between full resyncs.
+  double resync_time = 1.0;
+  if (!nl.getParam("sensor/resync_time", resync_time)) return false;
+  deltas_.SetResyncTime(resync_time);
+
   // State space parameters.
   int dimension = 1;
   if (!nl.getParam("control/dim", dimension)) return false;
@@ -163,8 +168,9 @@ bool Sensor::RegisterCallbacks(const ros::NodeHandle& n) {
   sensor_radius_pub_ = nl.advertise<visualization_msgs::Marker>(
     sensor_radius_topic_.c_str(), 1, false);
 
+  // Sensor messages are incremental, so keep a few around.
   sensor_pub_ = nl.advertise<meta_planner_msgs::SensorMeasurement>(
-    sensor_topic_.c_str(), 1, false);
+    sensor_topic_.c_str(), 10, false);
 
   // Subscriber.
   in_flight_sub_ = nl.subscribe(
@@ -204,28 +210,20 @@ void Sensor::TimerCallback(const ros::TimerEvent& e) {
                           tf.transform.translation.z);
 
 
-  // Publish sensor message if an obstacle is within range.
+  // Publish only what has changed since the last sensor message.
+  std::vector<uint64_t> obstacle_ids;
   std::vector<Vector3d> obstacle_positions;
+  std::vector<Vector3d> obstacle_velocities;
   std::vector<double> obstacle_radii;
 
-  if (space_->SenseObstacles(position, sensor_radius_,
-                            obstacle_positions, obstacle_radii)) {
-    // Saw at least one obstacle, so convert to message and publish.
-    meta_planner_msgs::SensorMeasurement msg;
-    msg.num_obstacles = obstacle_positions.size();
-
-    for (size_t ii = 0; ii < obstacle_positions.size(); ii++) {
-      geometry_msgs::Vector3 p;
-      p.x = obstacle_positions[ii](0);
-      p.y = obstacle_positions[ii](1);
-      p.z = obstacle_positions[ii](2);
-
-      msg.positions.push_back(p);
-      msg.radii.push_back(obstacle_radii[ii]);
-    }
+  space_->SenseObstacles(position, sensor_radius_, right_now.toSec(),
+                         obstacle_ids, obstacle_positions,
+                         obstacle_velocities, obstacle_radii);
 
+  meta_planner_msgs::SensorMeasurement msg;
+  if (deltas_.Update(obstacle_ids, obstacle_positions, obstacle_velocities,
+                     obstacle_radii, *space_->Obstacles(), right_now, msg))
     sensor_pub_.publish(msg);
-  }
 
   // Visualize the environment.
   space_->Visualize(environment_pub_, fixed_frame_id_);
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the StraightLinePlanner class, which inherits from Planner. It only
+// ever tries the straight line from start to stop, checked at the same
+// resolution OMPL uses for motions, and fails if that line is blocked. This
+// is cheap enough to try before running a full OMPL planner.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/straight_line_planner.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace meta {
+
+const double StraightLinePlanner::kResolutionFraction = 0.01;
+
+StraightLinePlanner::StraightLinePlanner(ValueFunctionId incoming_value,
+                                         ValueFunctionId outgoing_value,
+                                         const Box::ConstPtr& space,
+                                         const Dynamics::ConstPtr& dynamics)
+  : Planner(incoming_value, outgoing_value, space, dynamics) {}
+
+// Factory method. Use this instead of the constructor.
+Planner::Ptr StraightLinePlanner::Create(ValueFunctionId incoming_value,
+                                         ValueFunctionId outgoing_value,
+                                         const Box::ConstPtr& space,
+                                         const Dynamics::ConstPtr& dynamics) {
+  Planner::Ptr ptr(new StraightLinePlanner(
+    incoming_value, outgoing_value, space, dynamics));
+  return ptr;
+}
+
+// Plan the straight line between two points, or return null if it is
+// blocked. Never takes long enough to need the budget.
+Trajectory::Ptr StraightLinePlanner::
+Plan(const Vector3d& start, const Vector3d& stop,
+     double start_time, double budget) const {
+  if (!space_->IsValid(start, incoming_value_, outgoing_value_))
+    return nullptr;
+
+  // Time to traverse the line. The best possible time is the weighted
+  // L-infinity distance under the maximum speeds, so if those are cached
+  // there is no need to ask the server.
+  Vector3d max_speed;
+  const double duration = (MaxSpeed(max_speed)) ?
+    (stop - start).cwiseAbs().cwiseQuotient(max_speed).maxCoeff() :
+    BestPossibleTime(start, stop);
+
+  if (!std::isfinite(duration))
+    return nullptr;
+
+  // Intermediate points, ending with stop itself.
+  const double resolution = kResolutionFraction *
+    (space_->UpperBounds() - space_->LowerBounds()).norm();
+  const size_t num_segments = std::max<size_t>(
+    1, static_cast<size_t>(std::ceil((stop - start).norm() / resolution)));
+
+  std::vector<Vector3d> points(num_segments);
+  for (size_t ii = 1; ii <= num_segments; ii++)
+    points[ii - 1] = start + (stop - start) *
+      (static_cast<double>(ii) / static_cast<double>(num_segments));
+
+  // Check where obstacles are now, all at once.
+  std::vector<bool> mask;
+  space_->IsValidBatch(points, incoming_value_, outgoing_value_, mask);
+  if (std::find(mask.begin(), mask.end(), false) != mask.end())
+    return nullptr;
+
+  // Check again where moving obstacles will be along the way.
+  for (size_t ii = 1; ii <= num_segments; ii++) {
+    const double time = start_time + duration *
+      (static_cast<double>(ii) / static_cast<double>(num_segments));
+
+    if (!space_->IsValid(points[ii - 1], time,
+                         incoming_value_, outgoing_value_))
+      return nullptr;
+  }
+
+  // Convert to full state space. Make sure to use the INCOMING VALUE!
+  const std::vector<Vector3d> positions = { start, stop };
+  const std::vector<double> times = { start_time, start_time + duration };
+  const std::vector<ValueFunctionId> values = {
+    incoming_value_, incoming_value_ };
+
+  return Trajectory::Create(times,
+                            dynamics_->LiftGeometricTrajectory(positions, times),
+                            values, values);
+}
+
+} //\namespace meta
@@ -44,13 +44,25 @@
 
 namespace meta {
 
+// Factory method. Use this instead of the constructor.
+Trajectory::Ptr Trajectory::Create(const Arena::Ptr& arena) {
+  if (arena == nullptr) {
+    Ptr ptr(new Trajectory());
+    return ptr;
+  }
+
+  void* memory = arena->Allocate(sizeof(Trajectory), alignof(Trajectory));
+  return ArenaShared(new (memory) Trajectory(arena), arena);
+}
+
 // Factory constructor from times, states, values.
 Trajectory::Ptr Trajectory::
 Create(const std::vector<double>& times,
        const std::vector<VectorXd>& states,
        const std::vector<ValueFunctionId>& control_values,
-       const std::vector<ValueFunctionId>& bound_values) {
-  Trajectory::Ptr ptr(new Trajectory());
+       const std::vector<ValueFunctionId>& bound_values,
+       const Arena::Ptr& arena) {
+  Trajectory::Ptr ptr = Trajectory::Create(arena);
 
   // Number of entries in trajectory.
   size_t num_waypoints = states.size();
@@ -97,8 +109,9 @@ Create(const meta_planner_msgs::Trajectory::ConstPtr& msg) {
 // Factory constructor to create a Trajectory as the remainder of the
 // given Trajectory after the specified time point.
 Trajectory::Ptr Trajectory::
-Create(const Trajectory::ConstPtr& other, double start) {
-  Trajectory::Ptr traj = Trajectory::Create();
+Create(const Trajectory::ConstPtr& other, double start,
+       const Arena::Ptr& arena) {
+  Trajectory::Ptr traj = Trajectory::Create(arena);
 
   // Insert the current state at the start time.
   traj->Add(start,
@@ -108,7 +121,7 @@ Create(const Trajectory::ConstPtr& other, double start) {
 
   // Insert the rest of the states in the other trajectory.
   // Get a const iterator to a time in the other trajectory >= start time.
-  std::map<double, StateValue>::const_iterator iter =
+  Map::const_iterator iter =
     other->map_.lower_bound(start);
 
   // Iterate through all remaining states.
@@ -154,7 +167,7 @@ VectorXd Trajectory::GetState(double time) const {
 #endif
 
   // Get a const iterator to a time not less than this one.
-  std::map<double, StateValue>::const_iterator iter = map_.lower_bound(time);
+  Map::const_iterator iter = map_.lower_bound(time);
 
 #ifdef ENABLE_DEBUG_MESSAGES
   if (iter == map_.end()) {
@@ -195,7 +208,7 @@ ValueFunctionId Trajectory::GetControlValueFunction(double time) const {
 #endif
 
   // Get a const iterator to a time not less than this one.
-  std::map<double, StateValue>::const_iterator iter = map_.lower_bound(time);
+  Map::const_iterator iter = map_.lower_bound(time);
 
   // Catch end.
   if (iter == map_.end()) {
@@ -228,7 +241,7 @@ ValueFunctionId Trajectory::GetBoundValueFunction(double time) const {
 #endif
 
   // Get a const iterator to a time not less than this one.
-  std::map<double, StateValue>::const_iterator iter = map_.lower_bound(time);
+  Map::const_iterator iter = map_.lower_bound(time);
 
   // Catch end.
   if (iter == map_.end()) {
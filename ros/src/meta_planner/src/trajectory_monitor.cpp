@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the TrajectoryMonitor class, which watches the remainder of the
+// active trajectory for conflicts with newly sensed obstacles.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/trajectory_monitor.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace meta {
+
+namespace {
+  // Maximum number of segments in a leaf.
+  const size_t kLeafSize = 2;
+
+  // Distance from an obstacle center to the closest point of the box with
+  // the given center and half widths.
+  inline double BoxDistance(const Vector3d& center, const Vector3d& point,
+                            const Vector3d& bound) {
+    return ((center - point).cwiseAbs() - bound).cwiseMax(0.0).norm();
+  }
+} //\namespace
+
+// Factory method. Use this instead of the constructor.
+TrajectoryMonitor::Ptr TrajectoryMonitor::
+Create(const Trajectory::ConstPtr& traj,
+       const Dynamics::ConstPtr& dynamics,
+       const std::map<ValueFunctionId, Vector3d>& bounds) {
+  std::vector<double> times;
+  std::vector<VectorXd> states;
+  std::vector<ValueFunctionId> bound_values;
+  traj->Waypoints(times, states, bound_values);
+
+  std::vector<Vector3d> positions;
+  std::vector<Vector3d> waypoint_bounds;
+  for (size_t ii = 0; ii < times.size(); ii++) {
+    const auto iter = bounds.find(bound_values[ii]);
+    if (iter == bounds.end()) {
+      ROS_WARN("TrajectoryMonitor: Missing tracking bound for value %zu.",
+               bound_values[ii]);
+      return nullptr;
+    }
+
+    positions.push_back(dynamics->Puncture(states[ii]));
+    waypoint_bounds.push_back(iter->second);
+  }
+
+  return Create(times, positions, waypoint_bounds);
+}
+
+// Factory method from waypoint times, positions, and tracking bounds.
+TrajectoryMonitor::Ptr TrajectoryMonitor::
+Create(const std::vector<double>& times,
+       const std::vector<Vector3d>& positions,
+       const std::vector<Vector3d>& bounds) {
+  TrajectoryMonitor::Ptr ptr(new TrajectoryMonitor());
+
+  // A trajectory with a single waypoint is a single degenerate segment.
+  for (size_t ii = 0; ii < times.size(); ii++) {
+    const size_t jj = std::min(ii + 1, times.size() - 1);
+    if (jj == ii && ii > 0)
+      break;
+
+    // The bound value function may change at either end of the segment,
+    // so use the larger of the two bounds.
+    Segment segment;
+    segment.start_ = positions[ii];
+    segment.stop_ = positions[jj];
+    segment.start_time_ = times[ii];
+    segment.stop_time_ = times[jj];
+    segment.bound_ = bounds[ii].cwiseMax(bounds[jj]);
+
+    ptr->segments_.push_back(segment);
+    ptr->order_.push_back(ptr->segments_.size() - 1);
+  }
+
+  if (!ptr->segments_.empty())
+    ptr->Build(0, ptr->segments_.size());
+
+  return ptr;
+}
+
+// Recursively build the hierarchy over order_[first, first + count).
+size_t TrajectoryMonitor::Build(size_t first, size_t count) {
+  const size_t index = nodes_.size();
+  nodes_.push_back(Node());
+
+  // Bounding box and time interval of all segments below this node.
+  Node node;
+  node.lower_ = Vector3d::Constant(std::numeric_limits<double>::infinity());
+  node.upper_ = -node.lower_;
+  node.start_time_ = std::numeric_limits<double>::infinity();
+  node.stop_time_ = -node.start_time_;
+  node.first_ = first;
+  node.count_ = count;
+  node.left_ = 0;
+  node.right_ = 0;
+
+  Vector3d centroid_lower = node.lower_;
+  Vector3d centroid_upper = node.upper_;
+
+  for (size_t ii = first; ii < first + count; ii++) {
+    const Segment& segment = segments_[order_[ii]];
+    const Vector3d lower =
+      segment.start_.cwiseMin(segment.stop_) - segment.bound_;
+    const Vector3d upper =
+      segment.start_.cwiseMax(segment.stop_) + segment.bound_;
+
+    node.lower_ = node.lower_.cwiseMin(lower);
+    node.upper_ = node.upper_.cwiseMax(upper);
+    node.start_time_ = std::min(node.start_time_, segment.start_time_);
+    node.stop_time_ = std::max(node.stop_time_, segment.stop_time_);
+
+    const Vector3d centroid = 0.5 * (lower + upper);
+    centroid_lower = centroid_lower.cwiseMin(centroid);
+    centroid_upper = centroid_upper.cwiseMax(centroid);
+  }
+
+  // Split at the median centroid along the longest axis.
+  if (count > kLeafSize) {
+    size_t axis = 0;
+    (centroid_upper - centroid_lower).maxCoeff(&axis);
+
+    const size_t half = count / 2;
+    std::nth_element(order_.begin() + first,
+                     order_.begin() + first + half,
+                     order_.begin() + first + count,
+                     [&](size_t a, size_t b) {
+                       const Segment& sa = segments_[a];
+                       const Segment& sb = segments_[b];
+                       return sa.start_(axis) + sa.stop_(axis) <
+                         sb.start_(axis) + sb.stop_(axis);
+                     });
+
+    node.count_ = 0;
+    node.left_ = Build(first, half);
+    node.right_ = Build(first + half, count - half);
+  }
+
+  nodes_[index] = node;
+  return index;
+}
+
+// Check a spherical obstacle, moving at constant velocity, against all
+// segments which end after 'from_time'. Returns the index of the earliest
+// conflicting segment, or -1 if there is no conflict.
+int TrajectoryMonitor::Conflict(const Vector3d& point, double radius,
+                                const Vector3d& velocity, double stamp,
+                                double from_time) const {
+  if (nodes_.empty())
+    return -1;
+
+  int earliest = -1;
+
+  std::vector<size_t> stack(1, 0);
+  while (!stack.empty()) {
+    const Node& node = nodes_[stack.back()];
+    stack.pop_back();
+
+    // Skip parts of the trajectory which are already behind us.
+    if (node.stop_time_ < from_time)
+      continue;
+
+    // Box around the obstacle over this node's time interval. The obstacle
+    // moves in a straight line, so it is enough to look at the endpoints.
+    const double start_time = std::max(node.start_time_, from_time);
+    const Vector3d start = point + (start_time - stamp) * velocity;
+    const Vector3d stop = point + (node.stop_time_ - stamp) * velocity;
+
+    const Vector3d lower =
+      start.cwiseMin(stop) - Vector3d::Constant(radius);
+    const Vector3d upper =
+      start.cwiseMax(stop) + Vector3d::Constant(radius);
+
+    if ((lower.array() > node.upper_.array()).any() ||
+        (upper.array() < node.lower_.array()).any())
+      continue;
+
+    // Inner node.
+    if (node.count_ == 0) {
+      stack.push_back(node.left_);
+      stack.push_back(node.right_);
+      continue;
+    }
+
+    // Leaf.
+    for (size_t ii = node.first_; ii < node.first_ + node.count_; ii++) {
+      const size_t index = order_[ii];
+      if (earliest >= 0 && index >= static_cast<size_t>(earliest))
+        continue;
+
+      if (SegmentConflict(segments_[index], point, radius,
+                          velocity, stamp, from_time))
+        earliest = static_cast<int>(index);
+    }
+  }
+
+  return earliest;
+}
+
+// Exact check of a single segment against a moving obstacle. The distance
+// between the obstacle center and the tracking bound box is convex in time,
+// since both move in straight lines, so we can minimize it by ternary search.
+bool TrajectoryMonitor::SegmentConflict(const Segment& segment,
+                                        const Vector3d& point, double radius,
+                                        const Vector3d& velocity, double stamp,
+                                        double from_time) const {
+  double lower = std::max(segment.start_time_, from_time);
+  double upper = segment.stop_time_;
+  if (upper < lower)
+    return false;
+
+  const double duration = segment.stop_time_ - segment.start_time_;
+  const auto distance = [&](double time) {
+    const double fraction = (duration > 1e-8) ?
+      (time - segment.start_time_) / duration : 0.0;
+    const Vector3d position =
+      segment.start_ + fraction * (segment.stop_ - segment.start_);
+
+    return BoxDistance(point + (time - stamp) * velocity,
+                       position, segment.bound_);
+  };
+
+  const size_t kNumIterations = 50;
+  for (size_t ii = 0; ii < kNumIterations; ii++) {
+    const double a = lower + (upper - lower) / 3.0;
+    const double b = upper - (upper - lower) / 3.0;
+
+    if (distance(a) < distance(b))
+      upper = b;
+    else
+      lower = a;
+  }
+
+  return distance(0.5 * (lower + upper)) <= radius;
+}
+
+} //\namespace meta
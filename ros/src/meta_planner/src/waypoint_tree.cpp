@@ -38,34 +38,101 @@
 //
 // Defines the WaypointTree class. The WaypointTree class handles queries like
 // finding the nearest k points, as well as the length (in time) of the
-// shortest path to the goal.
+// shortest path to the goal. Waypoints may be inserted and searched for
+// from multiple threads at once.
+//
+// Each tree owns an Arena, from which its waypoints (and whatever else the
+// caller chooses) may be allocated. The Arena is released in one shot once
+// the tree and everything allocated from it are gone.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <meta_planner/waypoint_tree.h>
 
+#include <boost/thread/locks.hpp>
+
 namespace meta {
 
 WaypointTree::WaypointTree(const Vector3d& start,
                            ValueFunctionId start_value,
-                           double start_time)
-  : root_(Waypoint::Create(start, start_value, nullptr, nullptr)),
-    start_time_(start_time) {
-  kdtree_.Insert(root_);
+                           double start_time,
+                           const Vector3d& weights)
+  : arena_(Arena::Create()),
+    root_(Waypoint::Create(start, start_value, nullptr, nullptr, arena_)),
+    start_time_(start_time),
+    kdtree_(weights) {
+  kdtree_.Insert(root_->point_, root_);
+  registry_.push_back(root_);
+}
+
+// Find the (at most) k nearest neighbors in the tree, closest first, into
+// the given buffers of at least k elements. Returns how many were found.
+size_t WaypointTree::KnnSearch(const Vector3d& query, size_t k,
+                               Waypoint::ConstPtr* neighbors,
+                               double* distances) const {
+  boost::shared_lock<boost::shared_mutex> lock(mutex_);
+  return kdtree_.KnnSearch(query, k, neighbors, distances);
+}
+
+// Same as above, but returning the neighbors.
+std::vector<Waypoint::ConstPtr>
+WaypointTree::KnnSearch(const Vector3d& query, size_t k) const {
+  std::vector<Waypoint::ConstPtr> neighbors(k);
+  std::vector<double> distances(k);
+
+  neighbors.resize(KnnSearch(query, k, neighbors.data(), distances.data()));
+  return neighbors;
+}
+
+// Find all neighbors within distance r, closest first.
+std::vector<Waypoint::ConstPtr>
+WaypointTree::RadiusSearch(const Vector3d& query, double r) const {
+  boost::shared_lock<boost::shared_mutex> lock(mutex_);
+
+  // Make room for every waypoint, so none are left out.
+  const size_t capacity = kdtree_.Size();
+  std::vector<Waypoint::ConstPtr> neighbors(capacity);
+  std::vector<double> distances(capacity);
+
+  neighbors.resize(kdtree_.RadiusSearch(
+    query, r, capacity, neighbors.data(), distances.data()));
+  return neighbors;
+}
+
+// All waypoints in the tree, including the root, in order of insertion.
+std::vector<Waypoint::ConstPtr> WaypointTree::Waypoints() const {
+  boost::shared_lock<boost::shared_mutex> lock(mutex_);
+  return registry_;
 }
 
 // Add Waypoint to tree.
 void WaypointTree::Insert(const Waypoint::ConstPtr& waypoint, bool is_terminal) {
-  kdtree_.Insert(waypoint);
+  if (waypoint == nullptr) {
+    ROS_WARN("Tried to insert a null waypoint.");
+    return;
+  }
 
-  if (is_terminal) {
-    if (terminus_ == nullptr) {
-      ROS_WARN("Set initial terminus.");
-      terminus_ = waypoint;
-    }
-    else if (waypoint->traj_->LastTime() < terminus_->traj_->LastTime()) {
-      ROS_WARN("Updated terminus.");
-      terminus_ = waypoint;
+  {
+    boost::unique_lock<boost::shared_mutex> lock(mutex_);
+    kdtree_.Insert(waypoint->point_, waypoint);
+    registry_.push_back(waypoint);
+  }
+
+  if (!is_terminal)
+    return;
+
+  // Replace the terminus only if this waypoint is faster. If another thread
+  // updates it in the meantime, compare against that one instead.
+  Waypoint::ConstPtr terminus = std::atomic_load(&terminus_);
+  while (terminus == nullptr ||
+         waypoint->traj_->LastTime() < terminus->traj_->LastTime()) {
+    if (std::atomic_compare_exchange_weak(&terminus_, &terminus, waypoint)) {
+      if (terminus == nullptr)
+        ROS_WARN("Set initial terminus.");
+      else
+        ROS_WARN("Updated terminus.");
+
+      break;
     }
   }
 }
@@ -73,15 +140,19 @@ void WaypointTree::Insert(const Waypoint::ConstPtr& waypoint, bool is_terminal)
 // Get best total time (seconds) of any valid trajectory. Returns negative
 // if no valid trajectory exists.
 double WaypointTree::BestTime() const {
-  if (terminus_ == nullptr)
+  const Waypoint::ConstPtr terminus = std::atomic_load(&terminus_);
+  if (terminus == nullptr)
     return std::numeric_limits<double>::infinity();
 
-  return terminus_->traj_->LastTime() - start_time_;
+  return terminus->traj_->LastTime() - start_time_;
 }
 
-// Get best (fastest) trajectory (if it exists).
+// Get best (fastest) trajectory (if it exists). The trajectories along the
+// way are copied into a new one on the heap, so the result does not keep
+// the Arena alive.
 Trajectory::Ptr WaypointTree::BestTrajectory() const {
-  if (terminus_ == nullptr) {
+  const Waypoint::ConstPtr terminus = std::atomic_load(&terminus_);
+  if (terminus == nullptr) {
     ROS_WARN("Tree did not reach to the terminus.");
     return nullptr;
   }
@@ -89,7 +160,7 @@ Trajectory::Ptr WaypointTree::BestTrajectory() const {
   Trajectory::Ptr traj = Trajectory::Create();
 
   // Walk back from the terminus, and append trajectories as we go.
-  Waypoint::ConstPtr waypoint = terminus_;
+  Waypoint::ConstPtr waypoint = terminus;
   while (waypoint != nullptr && waypoint->traj_ != nullptr) {
     traj->Add(waypoint->traj_);
     waypoint = waypoint->parent_;
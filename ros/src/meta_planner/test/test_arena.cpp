@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the Arena class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/arena.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Allocations are aligned as requested, and large ones get their own block.
+TEST(Arena, TestAlignment) {
+  const Arena::Ptr arena = Arena::Create(1024);
+
+  for (size_t alignment = 1; alignment <= 64; alignment *= 2) {
+    const void* ptr = arena->Allocate(3, alignment);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignment, 0u);
+  }
+
+  arena->Allocate(4096, 8);
+  EXPECT_GE(arena->Reserved(), 1024u + 4096u);
+  EXPECT_EQ(arena->Allocated(), 7u * 3u + 4096u);
+}
+
+// Containers and shared pointers keep their arena alive, and objects in it
+// are still destroyed.
+TEST(Arena, TestLifetime) {
+  static size_t num_destroyed = 0;
+  struct Counted {
+    ~Counted() { num_destroyed++; }
+  };
+
+  std::shared_ptr<Counted> counted;
+  std::map<int, double, std::less<int>,
+           ArenaAllocator< std::pair<const int, double> > >* map = nullptr;
+  std::weak_ptr<Arena> weak;
+  {
+    const Arena::Ptr arena = Arena::Create();
+    weak = arena;
+
+    void* memory = arena->Allocate(sizeof(Counted), alignof(Counted));
+    counted = ArenaShared(new (memory) Counted(), arena);
+
+    map = new std::map<int, double, std::less<int>,
+                       ArenaAllocator< std::pair<const int, double> > >(
+      std::less<int>(),
+      ArenaAllocator< std::pair<const int, double> >(arena));
+    for (int ii = 0; ii < 100; ii++)
+      (*map)[ii] = 0.5 * ii;
+  }
+
+  EXPECT_FALSE(weak.expired());
+  EXPECT_EQ(map->at(42), 21.0);
+
+  delete map;
+  EXPECT_FALSE(weak.expired());
+
+  counted.reset();
+  EXPECT_EQ(num_destroyed, 1u);
+  EXPECT_TRUE(weak.expired());
+}
+
+// Threads allocating at once never get overlapping memory.
+TEST(Arena, TestConcurrentAllocation) {
+  const Arena::Ptr arena = Arena::Create(1024);
+  const size_t kNumThreads = 4;
+  const size_t kNumAllocations = 10000;
+
+  std::vector< std::vector<size_t*> > ptrs(kNumThreads);
+  std::vector<std::thread> threads;
+  for (size_t ii = 0; ii < kNumThreads; ii++) {
+    threads.emplace_back([&arena, &ptrs, ii]() {
+      for (size_t jj = 0; jj < kNumAllocations; jj++) {
+        const size_t count = 1 + jj % 7;
+        size_t* ptr = static_cast<size_t*>(
+          arena->Allocate(count * sizeof(size_t), alignof(size_t)));
+        std::fill(ptr, ptr + count, ii);
+        ptrs[ii].push_back(ptr);
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+
+  for (size_t ii = 0; ii < kNumThreads; ii++) {
+    for (size_t jj = 0; jj < kNumAllocations; jj++) {
+      const size_t count = 1 + jj % 7;
+      EXPECT_EQ(std::count(ptrs[ii][jj], ptrs[ii][jj] + count, ii),
+                static_cast<ptrdiff_t>(count));
+    }
+  }
+
+  EXPECT_GE(arena->Reserved(), arena->Allocated());
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the BudgetScheduler class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/budget_scheduler.h>
+
+#include <cstdio>
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// If every call succeeds after the same time, the best budget is just long
+// enough to let it, in that cell only.
+TEST(BudgetScheduler, TestLearnsLatency) {
+  const BudgetScheduler::Ptr scheduler =
+    BudgetScheduler::Create(2, 10.0, 0.1, 0.2);
+
+  EXPECT_NEAR(scheduler->Budget(0, 1.0, 0), 0.1, 1e-12);
+
+  for (size_t ii = 0; ii < BudgetScheduler::kMinAttempts; ii++)
+    scheduler->Record(0, 1.0, 0, 0.045, true);
+
+  EXPECT_NEAR(scheduler->Budget(0, 1.0, 0), 0.05, 1e-12);
+  EXPECT_NEAR(scheduler->Budget(1, 1.0, 0), 0.1, 1e-12);
+  EXPECT_NEAR(scheduler->Budget(0, 9.0, 0), 0.1, 1e-12);
+  EXPECT_NEAR(scheduler->Budget(0, 1.0, 5), 0.1, 1e-12);
+}
+
+// Calls that succeed late half the time are worth cutting off early if the
+// other half succeed quickly.
+TEST(BudgetScheduler, TestCutsOffSlowCalls) {
+  const BudgetScheduler::Ptr scheduler =
+    BudgetScheduler::Create(1, 10.0, 0.1, 0.2);
+
+  for (size_t ii = 0; ii < 50; ii++) {
+    scheduler->Record(0, 1.0, 0, 0.005, true);
+    scheduler->Record(0, 1.0, 0, 0.195, true);
+  }
+
+  EXPECT_NEAR(scheduler->Budget(0, 1.0, 0), 0.01, 1e-12);
+}
+
+// Calls that only ever succeed after the default budget are learned from
+// the occasional maximum budget.
+TEST(BudgetScheduler, TestLearnsLongerBudgets) {
+  const BudgetScheduler::Ptr scheduler =
+    BudgetScheduler::Create(1, 10.0, 0.1, 0.2);
+
+  size_t num_explored = 0;
+  const size_t kNumCalls = 20 * BudgetScheduler::kExplorationPeriod;
+  for (size_t ii = 0; ii < kNumCalls; ii++) {
+    const double budget = scheduler->Budget(0, 1.0, 0);
+    if (budget >= 0.2 - 1e-12)
+      num_explored++;
+
+    if (budget >= 0.155)
+      scheduler->Record(0, 1.0, 0, 0.155, true);
+    else
+      scheduler->Record(0, 1.0, 0, budget, false);
+  }
+
+  EXPECT_GE(num_explored, kNumCalls / BudgetScheduler::kExplorationPeriod);
+
+  // The next budget is not an exploratory one.
+  EXPECT_NEAR(scheduler->Budget(0, 1.0, 0), 0.16, 1e-12);
+}
+
+// Statistics survive a round trip through a file.
+TEST(BudgetScheduler, TestSaveLoad) {
+  const BudgetScheduler::Ptr scheduler =
+    BudgetScheduler::Create(1, 10.0, 0.1, 0.2);
+  for (size_t ii = 0; ii < BudgetScheduler::kMinAttempts; ii++)
+    scheduler->Record(0, 1.0, 0, 0.045, true);
+
+  const std::string file_name = "/tmp/test_budget_scheduler.txt";
+  ASSERT_TRUE(scheduler->Save(file_name));
+
+  const BudgetScheduler::Ptr loaded =
+    BudgetScheduler::Create(1, 10.0, 0.1, 0.2);
+  ASSERT_TRUE(loaded->Load(file_name));
+  EXPECT_NEAR(loaded->Budget(0, 1.0, 0), scheduler->Budget(0, 1.0, 0), 1e-12);
+
+  // Mismatched configurations are rejected.
+  const BudgetScheduler::Ptr mismatched =
+    BudgetScheduler::Create(2, 10.0, 0.1, 0.2);
+  EXPECT_FALSE(mismatched->Load(file_name));
+
+  std::remove(file_name.c_str());
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the Frontier class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/frontier.h>
+
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Waypoints come out cheapest first.
+TEST(Frontier, TestCheapestFirst) {
+  const Frontier::Ptr frontier = Frontier::Create();
+
+  const Waypoint::ConstPtr near = Waypoint::Create(
+    Vector3d(1.0, 0.0, 0.0), 0, nullptr, nullptr);
+  const Waypoint::ConstPtr far = Waypoint::Create(
+    Vector3d(5.0, 0.0, 0.0), 0, nullptr, nullptr);
+
+  frontier->Push(far, 5.0);
+  frontier->Push(near, 1.0);
+  EXPECT_EQ(frontier->Size(), 2u);
+
+  double cost = 0.0;
+  EXPECT_EQ(frontier->Next(cost), near);
+  EXPECT_NEAR(cost, 1.0, 1e-12);
+
+  // Taking a waypoint does not remove it.
+  EXPECT_EQ(frontier->Size(), 2u);
+
+  frontier->Clear();
+  EXPECT_EQ(frontier->Size(), 0u);
+  EXPECT_EQ(frontier->Next(cost), nullptr);
+}
+
+// A waypoint taken k times competes with fresh ones costing k + 1 times as
+// much, so no waypoint is taken forever.
+TEST(Frontier, TestDecaysTakenWaypoints) {
+  const Frontier::Ptr frontier = Frontier::Create();
+
+  const Waypoint::ConstPtr near = Waypoint::Create(
+    Vector3d(1.0, 0.0, 0.0), 0, nullptr, nullptr);
+  const Waypoint::ConstPtr far = Waypoint::Create(
+    Vector3d(3.5, 0.0, 0.0), 0, nullptr, nullptr);
+
+  frontier->Push(near, 1.0);
+  frontier->Push(far, 3.5);
+
+  double cost = 0.0;
+  for (size_t ii = 0; ii < 3; ii++)
+    EXPECT_EQ(frontier->Next(cost), near);
+
+  EXPECT_EQ(frontier->Next(cost), far);
+  EXPECT_NEAR(cost, 3.5, 1e-12);
+}
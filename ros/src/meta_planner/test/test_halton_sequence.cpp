@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the HaltonSequence class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/halton_sequence.h>
+
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Radical inverses of the first few integers in base 2 and 3.
+TEST(HaltonSequence, TestRadicalInverse) {
+  EXPECT_NEAR(HaltonSequence::RadicalInverse(1, 2), 0.5, 1e-12);
+  EXPECT_NEAR(HaltonSequence::RadicalInverse(2, 2), 0.25, 1e-12);
+  EXPECT_NEAR(HaltonSequence::RadicalInverse(3, 2), 0.75, 1e-12);
+  EXPECT_NEAR(HaltonSequence::RadicalInverse(6, 2), 0.375, 1e-12);
+  EXPECT_NEAR(HaltonSequence::RadicalInverse(1, 3), 1.0 / 3.0, 1e-12);
+  EXPECT_NEAR(HaltonSequence::RadicalInverse(5, 3), 7.0 / 9.0, 1e-12);
+}
+
+// Every one of 8 x 9 x 5 cells in the unit cube gets exactly one point out
+// of that many consecutive ones.
+TEST(HaltonSequence, TestStratified) {
+  HaltonSequence sequence;
+
+  const size_t kCells[3] = { 8, 9, 5 };
+  const size_t kNumPoints = kCells[0] * kCells[1] * kCells[2];
+
+  // Points fall on cell boundaries, up to rounding.
+  const double kTolerance = 1e-9;
+
+  std::vector<size_t> counts(kNumPoints, 0);
+  for (size_t ii = 0; ii < kNumPoints; ii++) {
+    const Vector3d point = sequence.Next();
+
+    size_t cell = 0;
+    for (size_t jj = 0; jj < 3; jj++)
+      cell = cell * kCells[jj] +
+        static_cast<size_t>(point(jj) * kCells[jj] + kTolerance);
+
+    counts[cell]++;
+  }
+
+  for (size_t ii = 0; ii < kNumPoints; ii++)
+    EXPECT_EQ(counts[ii], 1);
+}
+
+// Randomly shifted points still lie in the unit cube.
+TEST(HaltonSequence, TestShiftedInUnitCube) {
+  std::default_random_engine rng(0);
+  HaltonSequence sequence(rng);
+
+  const size_t kNumPoints = 1000;
+  for (size_t ii = 0; ii < kNumPoints; ii++) {
+    const Vector3d point = sequence.Next();
+
+    for (size_t jj = 0; jj < 3; jj++) {
+      EXPECT_GE(point(jj), 0.0);
+      EXPECT_LT(point(jj), 1.0);
+    }
+  }
+}
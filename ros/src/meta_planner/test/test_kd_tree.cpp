@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the KdTree class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/kd_tree.h>
+
+#include <algorithm>
+#include <random>
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Nearest neighbor and radius searches agree with brute force under the
+// weighted L-infinity metric, at every size as the tree grows.
+TEST(KdTree, TestMatchesBruteForce) {
+  const Vector3d weights(1.0, 4.0, 2.0);
+  KdTree<size_t> kdtree(weights);
+
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif(-1.0, 1.0);
+
+  const size_t kNumNeighbors = 5;
+  const double kRadius = 0.3;
+  const size_t kCapacity = 1000;
+
+  std::vector<Vector3d> points;
+  std::vector<size_t> values(kCapacity);
+  std::vector<double> distances(kCapacity);
+  for (size_t ii = 0; ii < 700; ii++) {
+    points.push_back(Vector3d(unif(rng), unif(rng), unif(rng)));
+    kdtree.Insert(points.back(), ii);
+    ASSERT_EQ(kdtree.Size(), points.size());
+
+    if (ii % 7 != 0)
+      continue;
+
+    const Vector3d query(unif(rng), unif(rng), unif(rng));
+
+    std::vector<double> expected;
+    for (const auto& point : points)
+      expected.push_back(kdtree.Distance(point, query));
+    std::sort(expected.begin(), expected.end());
+
+    const size_t num_found = kdtree.KnnSearch(
+      query, kNumNeighbors, values.data(), distances.data());
+    ASSERT_EQ(num_found, std::min(kNumNeighbors, points.size()));
+    for (size_t jj = 0; jj < num_found; jj++) {
+      EXPECT_NEAR(distances[jj], expected[jj], 1e-12);
+      EXPECT_NEAR(kdtree.Distance(points[values[jj]], query),
+                  distances[jj], 1e-12);
+    }
+
+    const size_t num_nearby = kdtree.RadiusSearch(
+      query, kRadius, kCapacity, values.data(), distances.data());
+    EXPECT_EQ(num_nearby, static_cast<size_t>(
+      std::upper_bound(expected.begin(), expected.end(), kRadius) -
+      expected.begin()));
+    for (size_t jj = 0; jj < num_nearby; jj++) {
+      EXPECT_LE(distances[jj], kRadius);
+      if (jj > 0) {
+        EXPECT_LE(distances[jj - 1], distances[jj]);
+      }
+    }
+  }
+}
+
+// Radius searches stop at the capacity of the buffers, keeping the closest.
+TEST(KdTree, TestRadiusCapacity) {
+  KdTree<size_t> kdtree;
+  for (size_t ii = 0; ii < 100; ii++)
+    kdtree.Insert(Vector3d(0.01 * static_cast<double>(ii), 0.0, 0.0), ii);
+
+  size_t values[3];
+  double distances[3];
+  EXPECT_EQ(kdtree.RadiusSearch(Vector3d::Zero(), 1.0, 3, values, distances),
+            3u);
+  EXPECT_EQ(values[0], 0u);
+  EXPECT_EQ(values[1], 1u);
+  EXPECT_EQ(values[2], 2u);
+
+  kdtree.Clear();
+  EXPECT_EQ(kdtree.Size(), 0u);
+  EXPECT_EQ(kdtree.KnnSearch(Vector3d::Zero(), 3, values, distances), 0u);
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the MotionPrimitives class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/motion_primitives.h>
+
+#include <cstdio>
+#include <set>
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// With single steps, every neighbor of a cell is reached exactly once, and
+// moves take the weighted L-infinity time.
+TEST(MotionPrimitives, TestSingleSteps) {
+  const Vector3d max_speed(1.0, 2.0, 0.5);
+  const MotionPrimitives::Ptr primitives =
+    MotionPrimitives::Create(max_speed, 0.1, 1);
+
+  ASSERT_EQ(primitives->Size(), 26u);
+
+  std::set<std::array<int, 3> > offsets;
+  for (const auto& primitive : primitives->Primitives()) {
+    offsets.insert(primitive.offset_);
+
+    EXPECT_NEAR(primitive.duration_,
+                (primitive.displacement_.cwiseAbs().cwiseQuotient(max_speed))
+                .maxCoeff(), 1e-12);
+    ASSERT_FALSE(primitive.points_.empty());
+    EXPECT_NEAR((primitive.points_.back() - primitive.displacement_).norm(),
+                0.0, 1e-12);
+    EXPECT_NEAR(primitive.times_.back(), primitive.duration_, 1e-12);
+  }
+
+  EXPECT_EQ(offsets.size(), 26u);
+}
+
+// Longer steps skip moves which repeat a shorter one.
+TEST(MotionPrimitives, TestSkipsRepeats) {
+  const MotionPrimitives::Ptr primitives =
+    MotionPrimitives::Create(Vector3d::Ones(), 0.1, 2);
+
+  // 5^3 - 1 moves, less the 26 which double a single step.
+  EXPECT_EQ(primitives->Size(), 98u);
+
+  for (const auto& primitive : primitives->Primitives()) {
+    const bool all_even = primitive.offset_[0] % 2 == 0 &&
+      primitive.offset_[1] % 2 == 0 && primitive.offset_[2] % 2 == 0;
+    EXPECT_FALSE(all_even);
+  }
+}
+
+// Libraries survive a round trip through a file.
+TEST(MotionPrimitives, TestSaveLoad) {
+  const Vector3d max_speed(1.0, 0.8, 0.6);
+  const MotionPrimitives::Ptr primitives =
+    MotionPrimitives::Create(max_speed, 0.1, 2);
+
+  const std::string file_name = "/tmp/test_motion_primitives.bin";
+  ASSERT_TRUE(primitives->Save(file_name));
+
+  const MotionPrimitives::Ptr loaded = MotionPrimitives::Load(file_name);
+  ASSERT_TRUE(loaded != nullptr);
+  EXPECT_TRUE(loaded->Matches(max_speed, 0.1, 2));
+  EXPECT_FALSE(loaded->Matches(max_speed, 0.1, 1));
+  EXPECT_FALSE(loaded->Matches(Vector3d::Ones(), 0.1, 2));
+  ASSERT_EQ(loaded->Size(), primitives->Size());
+
+  for (size_t ii = 0; ii < loaded->Size(); ii++) {
+    const auto& expected = primitives->Primitives()[ii];
+    const auto& actual = loaded->Primitives()[ii];
+
+    EXPECT_EQ(actual.offset_, expected.offset_);
+    EXPECT_NEAR(actual.duration_, expected.duration_, 1e-12);
+    ASSERT_EQ(actual.points_.size(), expected.points_.size());
+    for (size_t jj = 0; jj < actual.points_.size(); jj++) {
+      EXPECT_NEAR((actual.points_[jj] - expected.points_[jj]).norm(),
+                  0.0, 1e-12);
+      EXPECT_NEAR(actual.times_[jj], expected.times_[jj], 1e-12);
+    }
+  }
+
+  std::remove(file_name.c_str());
+}
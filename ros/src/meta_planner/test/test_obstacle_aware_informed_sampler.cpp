@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the ObstacleAwareInformedSampler class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/obstacle_aware_informed_sampler.h>
+#include <meta_planner/time_optimization_objective.h>
+#include <utils/types.h>
+
+#include <ompl/geometric/SimpleSetup.h>
+#include <ompl/geometric/planners/bitstar/BITstar.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <atomic>
+#include <memory>
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+namespace og = ompl::geometric;
+
+namespace {
+  // Uniform sampler which counts how often it is used.
+  class CountingSampler : public ob::RealVectorStateSampler {
+  public:
+    CountingSampler(const ob::StateSpace* space, std::atomic<size_t>& count)
+      : ob::RealVectorStateSampler(space),
+        count_(count) {}
+
+    void sampleUniform(ob::State* state) {
+      count_++;
+      ob::RealVectorStateSampler::sampleUniform(state);
+    }
+
+  private:
+    std::atomic<size_t>& count_;
+  };
+
+  // Solve a short BIT* query in an empty unit box with the given objective,
+  // and return how many samples came from the sampler installed on the
+  // state space.
+  template<typename ObjectiveFactory>
+  size_t CountBitstarSamples(ObjectiveFactory make_objective) {
+    std::atomic<size_t> count(0);
+
+    const auto space = std::make_shared<ob::RealVectorStateSpace>(3);
+    space->setBounds(0.0, 1.0);
+    space->setStateSamplerAllocator(
+      [&count](const ob::StateSpace* state_space) -> ob::StateSamplerPtr {
+        return std::make_shared<CountingSampler>(state_space, count); });
+
+    og::SimpleSetup setup(space);
+    setup.setStateValidityChecker([](const ob::State* state) {
+        return true; });
+    setup.setOptimizationObjective(
+      make_objective(setup.getSpaceInformation()));
+    setup.setPlanner(
+      std::make_shared<og::BITstar>(setup.getSpaceInformation()));
+
+    ob::ScopedState<ob::RealVectorStateSpace> start(space);
+    ob::ScopedState<ob::RealVectorStateSpace> stop(space);
+    for (size_t ii = 0; ii < 3; ii++) {
+      start[ii] = 0.1;
+      stop[ii] = 0.9;
+    }
+
+    setup.setStartAndGoalStates(start, stop);
+    EXPECT_TRUE(static_cast<bool>(setup.solve(0.1)));
+
+    return count.load();
+  }
+} //\namespace
+
+// BIT* draws its samples from the informed sampler of the objective, which
+// must in turn draw from the sampler installed on the state space.
+TEST(ObstacleAwareInformedSampler, TestBitstarUsesInstalledSampler) {
+  EXPECT_GT(CountBitstarSamples([](const ob::SpaceInformationPtr& si) {
+        return std::make_shared<TimeOptimizationObjective>(
+          si, Vector3d::Ones()); }), 0);
+
+  EXPECT_GT(CountBitstarSamples([](const ob::SpaceInformationPtr& si) {
+        return std::make_shared<ObstacleAwarePathLengthObjective>(si); }), 0);
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the ObstacleStore class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/obstacle_store.h>
+#include <utils/types.h>
+
+#include <random>
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+namespace {
+  // Reference collision check, one obstacle at a time.
+  bool IsFree(const std::vector<Vector3d>& centers,
+              const std::vector<double>& radii,
+              const Vector3d& point, const Vector3d& bound) {
+    for (size_t ii = 0; ii < centers.size(); ii++) {
+      const Vector3d delta =
+        ((centers[ii] - point).cwiseAbs() - bound).cwiseMax(0.0);
+      if (delta.norm() <= radii[ii])
+        return false;
+    }
+
+    return true;
+  }
+} //\namespace
+
+// Make sure block and single point checks agree with a simple loop for
+// every possible amount of padding.
+TEST(ObstacleStore, TestMatchesReference) {
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif_point(-5.0, 5.0);
+  std::uniform_real_distribution<double> unif_radius(0.1, 1.0);
+
+  const Vector3d bound(0.1, 0.2, 0.3);
+
+  for (size_t num_obstacles = 0; num_obstacles < 10; num_obstacles++) {
+    const ObstacleStore::Ptr store = ObstacleStore::Create();
+    std::vector<Vector3d> centers;
+    std::vector<double> radii;
+
+    for (size_t ii = 0; ii < num_obstacles; ii++) {
+      centers.push_back(Vector3d(unif_point(rng),
+                                 unif_point(rng),
+                                 unif_point(rng)));
+      radii.push_back(unif_radius(rng));
+      store->Add(centers.back(), radii.back());
+    }
+
+    EXPECT_EQ(store->Size(), num_obstacles);
+
+    for (size_t ii = 0; ii < 100; ii++) {
+      const size_t num_points = 1 + ii % ObstacleStore::kNumLanes;
+
+      Vector3d points[ObstacleStore::kNumLanes];
+      bool valid[ObstacleStore::kNumLanes];
+      for (size_t jj = 0; jj < num_points; jj++) {
+        points[jj] = Vector3d(unif_point(rng),
+                              unif_point(rng),
+                              unif_point(rng));
+        valid[jj] = true;
+      }
+
+      store->CheckBlock(points, num_points, bound, valid);
+
+      for (size_t jj = 0; jj < num_points; jj++) {
+        const bool expected = IsFree(centers, radii, points[jj], bound);
+        EXPECT_EQ(valid[jj], expected);
+        EXPECT_EQ(store->CheckPoint(points[jj], bound), expected);
+      }
+    }
+  }
+}
+
+// Make sure time-indexed checks agree with a simple loop over predicted
+// positions, with and without the swept volume index.
+TEST(ObstacleStore, TestPredictedMatchesReference) {
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif_point(-5.0, 5.0);
+  std::uniform_real_distribution<double> unif_radius(0.1, 1.0);
+  std::uniform_real_distribution<double> unif_velocity(-1.0, 1.0);
+  std::uniform_real_distribution<double> unif_time(0.0, 6.0);
+
+  const Vector3d bound(0.1, 0.2, 0.3);
+  const double stamp = 1.0;
+
+  const ObstacleStore::Ptr store = ObstacleStore::Create();
+  for (size_t ii = 0; ii < 10; ii++) {
+    // Leave every third obstacle static.
+    const Vector3d velocity = (ii % 3 == 0) ? Vector3d::Zero() :
+      Vector3d(unif_velocity(rng), unif_velocity(rng), unif_velocity(rng));
+
+    store->Add(Vector3d(unif_point(rng), unif_point(rng), unif_point(rng)),
+               unif_radius(rng), velocity, stamp);
+  }
+
+  const ObstacleStore::Ptr indexed = store->Clone();
+  indexed->BuildSweptIndex(stamp, 4.0, 0.25);
+
+  for (size_t ii = 0; ii < 1000; ii++) {
+    const Vector3d point(unif_point(rng), unif_point(rng), unif_point(rng));
+    const double time = unif_time(rng);
+
+    std::vector<Vector3d> centers;
+    std::vector<double> radii;
+    for (size_t jj = 0; jj < store->Size(); jj++) {
+      centers.push_back(store->PointAt(jj, time));
+      radii.push_back(store->Radius(jj));
+    }
+
+    const bool expected = IsFree(centers, radii, point, bound);
+    EXPECT_EQ(store->CheckPoint(point, time, bound), expected);
+    EXPECT_EQ(indexed->CheckPoint(point, time, bound), expected);
+  }
+}
+
+// Make sure IDs survive removal of other obstacles.
+TEST(ObstacleStore, TestRemoveKeepsIds) {
+  const ObstacleStore::Ptr store = ObstacleStore::Create();
+  for (size_t ii = 0; ii < 6; ii++)
+    store->Add(10 * ii, Vector3d::Constant(ii), 0.5);
+
+  store->Remove(store->Find(20));
+  store->Remove(store->Find(0));
+
+  EXPECT_EQ(store->Size(), 4);
+  EXPECT_LT(store->Find(0), 0);
+  EXPECT_LT(store->Find(20), 0);
+
+  for (size_t ii = 0; ii < 6; ii++) {
+    if (ii == 0 || ii == 2)
+      continue;
+
+    const int jj = store->Find(10 * ii);
+    ASSERT_GE(jj, 0);
+    EXPECT_EQ(store->Id(jj), 10 * ii);
+    EXPECT_EQ(store->Point(jj), Vector3d::Constant(ii));
+  }
+
+  // Removed obstacles must not collide with anything.
+  EXPECT_TRUE(store->CheckPoint(Vector3d::Zero(), Vector3d::Zero()));
+}
+
+// A covered box must contain only points in collision.
+TEST(ObstacleStore, TestCoversBoxIsConservative) {
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif_point(-5.0, 5.0);
+  std::uniform_real_distribution<double> unif_radius(0.5, 2.0);
+  std::uniform_real_distribution<double> unif_width(0.0, 1.0);
+  std::uniform_real_distribution<double> unif_fraction(0.0, 1.0);
+
+  const Vector3d bound(0.1, 0.2, 0.3);
+
+  const ObstacleStore::Ptr store = ObstacleStore::Create();
+  for (size_t ii = 0; ii < 5; ii++)
+    store->Add(Vector3d(unif_point(rng), unif_point(rng), unif_point(rng)),
+               unif_radius(rng));
+
+  size_t num_covered = 0;
+  for (size_t ii = 0; ii < 1000; ii++) {
+    const Vector3d lower(unif_point(rng), unif_point(rng), unif_point(rng));
+    const Vector3d upper =
+      lower + Vector3d(unif_width(rng), unif_width(rng), unif_width(rng));
+
+    if (!store->CoversBox(lower, upper, bound))
+      continue;
+
+    num_covered++;
+
+    // Corners are the hardest points to cover.
+    for (size_t jj = 0; jj < 8; jj++) {
+      const Vector3d corner((jj & 1) ? upper(0) : lower(0),
+                            (jj & 2) ? upper(1) : lower(1),
+                            (jj & 4) ? upper(2) : lower(2));
+      EXPECT_FALSE(store->CheckPoint(corner, bound));
+    }
+
+    for (size_t jj = 0; jj < 10; jj++) {
+      const Vector3d point = lower + (upper - lower).cwiseProduct(
+        Vector3d(unif_fraction(rng), unif_fraction(rng), unif_fraction(rng)));
+      EXPECT_FALSE(store->CheckPoint(point, bound));
+    }
+  }
+
+  EXPECT_GT(num_covered, 0);
+}
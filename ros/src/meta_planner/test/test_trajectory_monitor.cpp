@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the TrajectoryMonitor class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/trajectory_monitor.h>
+#include <utils/types.h>
+
+#include <random>
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Make sure the hierarchy finds the same earliest conflict as a brute force
+// check of densely sampled points along every segment.
+TEST(TrajectoryMonitor, TestMatchesDenseSampling) {
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif_point(-5.0, 5.0);
+  std::uniform_real_distribution<double> unif_velocity(-0.5, 0.5);
+  std::uniform_real_distribution<double> unif_radius(0.5, 2.0);
+
+  // Random walk through the box, one second per segment.
+  std::vector<double> times;
+  std::vector<Vector3d> positions;
+  std::vector<Vector3d> bounds;
+  for (size_t ii = 0; ii < 20; ii++) {
+    times.push_back(static_cast<double>(ii));
+    positions.push_back(Vector3d(unif_point(rng),
+                                 unif_point(rng),
+                                 unif_point(rng)));
+    bounds.push_back((ii < 10) ? Vector3d(0.1, 0.1, 0.2) :
+                     Vector3d(0.3, 0.3, 0.4));
+  }
+
+  const TrajectoryMonitor::Ptr monitor =
+    TrajectoryMonitor::Create(times, positions, bounds);
+  ASSERT_EQ(monitor->NumSegments(), times.size() - 1);
+
+  const double from_time = 3.5;
+  const size_t kNumSamples = 1000;
+
+  size_t num_conflicts = 0;
+  for (size_t ii = 0; ii < 200; ii++) {
+    const Vector3d point(unif_point(rng), unif_point(rng), unif_point(rng));
+    const Vector3d velocity(unif_velocity(rng), unif_velocity(rng),
+                            unif_velocity(rng));
+    const double radius = unif_radius(rng);
+
+    int expected = -1;
+    double margin = std::numeric_limits<double>::infinity();
+    for (size_t jj = 0; jj + 1 < times.size() && expected < 0; jj++) {
+      const Vector3d bound = bounds[jj].cwiseMax(bounds[jj + 1]);
+
+      for (size_t kk = 0; kk <= kNumSamples; kk++) {
+        const double fraction = static_cast<double>(kk) / kNumSamples;
+        const double time = times[jj] + fraction * (times[jj + 1] - times[jj]);
+        if (time < from_time)
+          continue;
+
+        const Vector3d position =
+          positions[jj] + fraction * (positions[jj + 1] - positions[jj]);
+        const double distance =
+          ((point + time * velocity - position).cwiseAbs() - bound)
+          .cwiseMax(0.0).norm();
+
+        margin = std::min(margin, std::abs(distance - radius));
+        if (distance <= radius) {
+          expected = static_cast<int>(jj);
+          break;
+        }
+      }
+    }
+
+    // Skip grazing contacts which dense sampling could miss.
+    if (margin < 1e-2)
+      continue;
+
+    EXPECT_EQ(monitor->Conflict(point, radius, velocity, 0.0, from_time),
+              expected);
+    num_conflicts += (expected >= 0);
+  }
+
+  // Make sure the test actually exercises both outcomes.
+  EXPECT_GT(num_conflicts, 0);
+  EXPECT_LT(num_conflicts, 200);
+}
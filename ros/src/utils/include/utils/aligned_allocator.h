@@ -36,48 +36,66 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// Defines the FlannTree class, which is a wrapper around the FLANN library's
-// fast kdtree index.
+// Minimal STL allocator which returns memory aligned to a fixed boundary.
+// Used for structure-of-arrays buffers that are read with aligned SIMD loads.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-#ifndef META_PLANNER_FLANN_TREE_H
-#define META_PLANNER_FLANN_TREE_H
+#ifndef UTILS_ALIGNED_ALLOCATOR_H
+#define UTILS_ALIGNED_ALLOCATOR_H
 
-#include <meta_planner/waypoint.h>
-#include <utils/types.h>
-#include <utils/uncopyable.h>
-
-#include <ros/ros.h>
-#include <flann/flann.h>
-#include <memory>
+#include <stdlib.h>
+#include <cstddef>
+#include <new>
 #include <vector>
-#include <math.h>
 
 namespace meta {
 
-class FlannTree : private Uncopyable {
+template<typename T, size_t Alignment>
+class AlignedAllocator {
 public:
-  explicit FlannTree() {}
-  ~FlannTree();
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template<typename U>
+  struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+  AlignedAllocator() {}
+  template<typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment>& other) {}
 
-  // Insert a new Waypoint into the tree.
-  bool Insert(const Waypoint::ConstPtr& waypoint);
+  // Allocate/free memory for n objects of type T.
+  T* allocate(size_t n) {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, Alignment, n * sizeof(T)) != 0)
+      throw std::bad_alloc();
 
-  // Nearest neighbor search.
-  std::vector<Waypoint::ConstPtr> KnnSearch(Vector3d& query, size_t k) const;
+    return static_cast<T*>(memory);
+  }
 
-  // Radius search.
-  std::vector<Waypoint::ConstPtr> RadiusSearch(Vector3d& query, double r) const;
+  void deallocate(T* p, size_t) { free(p); }
 
-private:
-  // A Flann kdtree. Searches in this tree return indices, which are then mapped
-  // to Waypoint pointers in an array.
-  // TODO: fix the distance metric to be something more intelligent.
-  std::unique_ptr< flann::KDTreeIndex< flann::L2<double> > > index_;
-  std::vector<Waypoint::ConstPtr> registry_;
+  // All instances are interchangeable.
+  template<typename U>
+  bool operator==(const AlignedAllocator<U, Alignment>& other) const {
+    return true;
+  }
+
+  template<typename U>
+  bool operator!=(const AlignedAllocator<U, Alignment>& other) const {
+    return false;
+  }
 };
 
+// Vector whose data pointer is aligned to a 32-byte (AVX) boundary.
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, 32> >;
+
 } //\namespace meta
 
 #endif
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines a fixed-size pool of worker threads. Tasks are queued in order and
+// each returns a std::future for its result. Destroying the pool finishes
+// all queued tasks before joining the workers.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef UTILS_THREAD_POOL_H
+#define UTILS_THREAD_POOL_H
+
+#include <utils/uncopyable.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace meta {
+
+class ThreadPool : private Uncopyable {
+public:
+  explicit ThreadPool(size_t num_threads)
+    : stopped_(false) {
+    if (num_threads == 0)
+      num_threads = 1;
+
+    for (size_t ii = 0; ii < num_threads; ii++)
+      workers_.emplace_back([this]() { Work(); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+
+    condition_.notify_all();
+    for (auto& worker : workers_)
+      worker.join();
+  }
+
+  // Queue a task, and return a future for its result.
+  template<typename F>
+  std::future<typename std::result_of<F()>::type> Submit(F task) {
+    typedef typename std::result_of<F()>::type Result;
+
+    // std::function must be copyable, so hold the packaged task by pointer.
+    const auto packaged =
+      std::make_shared<std::packaged_task<Result()> >(std::move(task));
+    std::future<Result> result = packaged->get_future();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace([packaged]() { (*packaged)(); });
+    }
+
+    condition_.notify_one();
+    return result;
+  }
+
+  // Number of worker threads.
+  inline size_t Size() const { return workers_.size(); }
+
+private:
+  // Run tasks until the pool is stopped and the queue is empty.
+  void Work() {
+    while (true) {
+      std::function<void()> task;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() {
+            return stopped_ || !tasks_.empty(); });
+
+        if (tasks_.empty())
+          return;
+
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+
+      task();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::queue< std::function<void()> > tasks_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopped_;
+};
+
+} //\namespace meta
+
+#endif